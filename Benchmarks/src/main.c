@@ -0,0 +1,830 @@
+#include <core/concurrent_hashtable.h>
+#include <core/dynamic_array.h>
+#include <core/hash.h>
+#include <core/engine.h>
+#include <core/hashmap.h>
+#include <core/hashtable.h>
+#include <core/job.h>
+#include <core/log.h>
+#include <core/memory.h>
+#include <core/mpmc_queue.h>
+#include <core/spsc_queue.h>
+#include <core/toml.h>
+#include <platform/platform.h>
+#include <stdio.h>
+#include <string.h>
+
+#undef LOG_SCOPE
+#define LOG_SCOPE "BENCHMARKS"
+
+// Each benchmark is run once to warm up, then REPETITIONS times. The reported time is the median of the repetitions, which is
+// much more stable between runs than the mean. The report is written in CSV, one line per benchmark:
+//   name,operations,ns_per_op,allocations_per_op
+
+/** @brief The number of measured runs of each benchmark. */
+#define REPETITIONS 7
+
+/** @brief The path of the report when none is given on the command line. */
+#define DEFAULT_REPORT_PATH "benchmarks.csv"
+
+/**
+ * @brief A benchmark.
+ *
+ * @param[in] argument The argument of the benchmark.
+ *
+ * @return The number of operations performed.
+ */
+typedef u64 (*benchmark_function)(u64 argument);
+
+/** @brief The result of a benchmark. */
+typedef struct benchmark_result {
+    u64 operations;
+    f64 ns_per_op;
+    f64 allocations_per_op;
+} benchmark_result;
+
+/** @brief The state of the pseudo-random generator. Reset before each run, so that every run does the same work. */
+static u64 random_state;
+
+static u64 next_random() {
+    // xorshift64
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 7;
+    random_state ^= random_state << 17;
+    return random_state;
+}
+
+static void sort_u64(u64 *values, u32 count) {
+    for (u32 i = 1; i < count; i++) {
+        u64 value = values[i];
+        u32 j = i;
+        while (j > 0 && values[j - 1] > value) {
+            values[j] = values[j - 1];
+            j--;
+        }
+        values[j] = value;
+    }
+}
+
+static benchmark_result benchmark_run(benchmark_function function, u64 argument) {
+    random_state = 0x9E3779B97F4A7C15;
+    function(argument);
+
+    u64 durations[REPETITIONS];
+    u64 operations = 0;
+    u64 allocations = 0;
+
+    for (u32 i = 0; i < REPETITIONS; i++) {
+        random_state = 0x9E3779B97F4A7C15;
+
+        u64 allocations_before = mem_get_total_allocation_count();
+        u64 start = platform_get_time_ns();
+        operations = function(argument);
+        durations[i] = platform_get_time_ns() - start;
+        allocations = mem_get_total_allocation_count() - allocations_before;
+    }
+
+    sort_u64(durations, REPETITIONS);
+
+    return (benchmark_result){
+        .operations = operations,
+        .ns_per_op = (f64)durations[REPETITIONS / 2] / operations,
+        .allocations_per_op = (f64)allocations / operations,
+    };
+}
+
+// ---------------------------------------------------------------------------------------------------------------------------
+// Memory system
+// ---------------------------------------------------------------------------------------------------------------------------
+
+#define MEM_LIVE_SLOTS 1024
+#define MEM_OPERATIONS 200000
+
+/** @brief Allocates and frees regions of the given size right away. */
+static u64 bench_mem_alloc_free_fixed(u64 size) {
+    for (u32 i = 0; i < MEM_OPERATIONS; i++) {
+        void *block = mem_alloc(MEMORY_TAG_ENGINE, size);
+        mem_free(block);
+    }
+
+    return MEM_OPERATIONS;
+}
+
+/**
+ * @brief Replaces random regions among a set of live ones, with mixed sizes (mostly small, some up to 64 KiB) and alignments.
+ */
+static u64 bench_mem_alloc_free_mixed(u64 unused) {
+    (void)unused;
+
+    static const u64 alignments[] = { 16, 16, 16, 32, 64, 256 };
+    void *slots[MEM_LIVE_SLOTS] = {};
+
+    for (u32 i = 0; i < MEM_OPERATIONS; i++) {
+        u64 slot = next_random() % MEM_LIVE_SLOTS;
+        mem_free(slots[slot]);
+
+        u64 random = next_random();
+        u64 size = (random & 0xF) == 0 ? 256 + (random >> 8) % 65536 : 8 + (random >> 8) % 256;
+        slots[slot] = mem_alloc_aligned(MEMORY_TAG_ENGINE, size, alignments[(random >> 4) % 6]);
+    }
+
+    for (u32 i = 0; i < MEM_LIVE_SLOTS; i++) {
+        mem_free(slots[i]);
+    }
+
+    return MEM_OPERATIONS;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------------
+// Dynamic arrays
+// ---------------------------------------------------------------------------------------------------------------------------
+
+/** @brief Pushes elements to an empty array, growing it from scratch. */
+static u64 bench_dynarray_push(u64 count) {
+    DYNARRAY(u64) array = {};
+
+    for (u64 i = 0; i < count; i++) {
+        DYNARRAY_PUSH(array, i);
+    }
+
+    DYNARRAY_CLEAR(array);
+    return count;
+}
+
+/** @brief Pushes elements to an empty array backed by the scratch stack, released wholesale by rewinding it. */
+static u64 bench_dynarray_push_scratch(u64 count) {
+    allocator scratch;
+    allocator_create_scratch(&scratch);
+    scratch_marker marker = mem_scratch_mark();
+
+    DYNARRAY(u64) array;
+    DYNARRAY_INIT(array, &scratch);
+
+    for (u64 i = 0; i < count; i++) {
+        DYNARRAY_PUSH(array, i);
+    }
+
+    mem_scratch_rewind(marker);
+    return count;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------------
+// Hash functions
+// ---------------------------------------------------------------------------------------------------------------------------
+
+#define HASH_KEY_COUNT 4096
+#define HASH_ROUNDS 64
+
+/** @brief A set of keys to hash, with their lengths. */
+typedef struct hash_key_set {
+    char keys[HASH_KEY_COUNT][64];
+    u32 lengths[HASH_KEY_COUNT];
+} hash_key_set;
+
+/** @brief Asset paths (40 to 60 bytes) and short identifiers (6 to 12 bytes). */
+static hash_key_set hash_paths;
+static hash_key_set hash_identifiers;
+
+static void hash_keys_generate() {
+    static const char *folders[] = { "textures/environment", "meshes/characters", "shaders/post_process", "audio/ambient" };
+    static const char *suffixes[] = { "albedo.png", "normal.png", "lod0.mesh", "frag.spv", "loop.ogg" };
+
+    for (u32 i = 0; i < HASH_KEY_COUNT; i++) {
+        hash_paths.lengths[i] = snprintf(
+            hash_paths.keys[i], 64, "assets/%s/asset_%05u_%s", folders[i % 4], i * 7919 % 100000, suffixes[i % 5]);
+        hash_identifiers.lengths[i] = snprintf(hash_identifiers.keys[i], 64, "%.*s_%u", (int)(2 + i % 6), "entity", i);
+    }
+}
+
+/** @brief Hashes every key of a set with the given hash function, folding the hashes so that they are not optimized away. */
+static u64 bench_hash(const hash_key_set *set, u64 (*function)(const void *, u64)) {
+    u64 folded = 0;
+
+    for (u32 round = 0; round < HASH_ROUNDS; round++) {
+        for (u32 i = 0; i < HASH_KEY_COUNT; i++) {
+            folded += function(set->keys[i], set->lengths[i]);
+        }
+    }
+
+    return folded != 0 ? HASH_ROUNDS * HASH_KEY_COUNT : 0;
+}
+
+static u64 bench_hash_fnv1a(u64 identifiers) { return bench_hash(identifiers ? &hash_identifiers : &hash_paths, hash_fnv1a); }
+
+static u64 bench_hash_wyhash(u64 identifiers) { return bench_hash(identifiers ? &hash_identifiers : &hash_paths, hash_wyhash); }
+
+// ---------------------------------------------------------------------------------------------------------------------------
+// Hash tables
+// ---------------------------------------------------------------------------------------------------------------------------
+
+#define HASHTABLE_CAPACITY 16384
+#define HASHTABLE_KEY_SIZE 16
+
+static char hashtable_keys[HASHTABLE_CAPACITY][HASHTABLE_KEY_SIZE];
+
+static void hashtable_keys_generate() {
+    for (u32 i = 0; i < HASHTABLE_CAPACITY; i++) {
+        snprintf(hashtable_keys[i], HASHTABLE_KEY_SIZE, "key_%08x", i * 0x9E3779B1);
+    }
+}
+
+/** @brief Inserts keys in a table until it reaches the given load factor (in percents of its initial capacity). */
+static u64 bench_hashtable_insert(u64 load_factor) {
+    u32 count = HASHTABLE_CAPACITY * load_factor / 100;
+
+    hashtable table;
+    hashtable_init(&table, sizeof(u64), HASHTABLE_CAPACITY, FALSE, NULL);
+
+    for (u64 i = 0; i < count; i++) {
+        hashtable_insert(&table, hashtable_keys[i], &i);
+    }
+
+    hashtable_destroy(&table);
+    return count;
+}
+
+/** @brief Looks up every key of a table filled up to the given load factor (in percents of its initial capacity). */
+static u64 bench_hashtable_get(u64 load_factor) {
+    u32 count = HASHTABLE_CAPACITY * load_factor / 100;
+    u32 lookups = 0;
+
+    hashtable table;
+    hashtable_init(&table, sizeof(u64), HASHTABLE_CAPACITY, FALSE, NULL);
+
+    for (u64 i = 0; i < count; i++) {
+        hashtable_insert(&table, hashtable_keys[i], &i);
+    }
+
+    // The inserts are measured as well, so do many more lookups for them to be negligible
+    for (u32 round = 0; round < 16; round++) {
+        for (u32 i = 0; i < count; i++) {
+            hashtable_get(&table, hashtable_keys[(i * 7919) % count]);
+            lookups++;
+        }
+    }
+
+    hashtable_destroy(&table);
+    return lookups;
+}
+
+/** @brief Same as @ref bench_hashtable_insert, with a swiss hashtable. */
+static u64 bench_swiss_hashtable_insert(u64 load_factor) {
+    u32 count = HASHTABLE_CAPACITY * load_factor / 100;
+
+    swiss_hashtable table;
+    swiss_hashtable_init(&table, sizeof(u64), HASHTABLE_CAPACITY, FALSE, NULL);
+
+    for (u64 i = 0; i < count; i++) {
+        swiss_hashtable_insert(&table, hashtable_keys[i], &i);
+    }
+
+    swiss_hashtable_destroy(&table);
+    return count;
+}
+
+/** @brief Same as @ref bench_hashtable_get, with a swiss hashtable. */
+static u64 bench_swiss_hashtable_get(u64 load_factor) {
+    u32 count = HASHTABLE_CAPACITY * load_factor / 100;
+    u32 lookups = 0;
+
+    swiss_hashtable table;
+    swiss_hashtable_init(&table, sizeof(u64), HASHTABLE_CAPACITY, FALSE, NULL);
+
+    for (u64 i = 0; i < count; i++) {
+        swiss_hashtable_insert(&table, hashtable_keys[i], &i);
+    }
+
+    for (u32 round = 0; round < 16; round++) {
+        for (u32 i = 0; i < count; i++) {
+            swiss_hashtable_get(&table, hashtable_keys[(i * 7919) % count]);
+            lookups++;
+        }
+    }
+
+    swiss_hashtable_destroy(&table);
+    return lookups;
+}
+
+/** @brief Inserts pointer-like keys (aligned, spread over a large range) in a u64 hashtable, up to the given load factor. */
+static u64 bench_u64_hashtable_insert(u64 load_factor) {
+    u32 count = HASHTABLE_CAPACITY * load_factor / 100;
+
+    u64_hashtable table;
+    u64_hashtable_init(&table, sizeof(u64), HASHTABLE_CAPACITY, FALSE, NULL);
+
+    for (u64 i = 0; i < count; i++) {
+        u64_hashtable_insert(&table, 0x7F0000000000 + i * 64, &i);
+    }
+
+    u64_hashtable_destroy(&table);
+    return count;
+}
+
+/** @brief Same as @ref bench_hashtable_get, with a u64 hashtable and the keys of @ref bench_u64_hashtable_insert. */
+static u64 bench_u64_hashtable_get(u64 load_factor) {
+    u32 count = HASHTABLE_CAPACITY * load_factor / 100;
+    u32 lookups = 0;
+
+    u64_hashtable table;
+    u64_hashtable_init(&table, sizeof(u64), HASHTABLE_CAPACITY, FALSE, NULL);
+
+    for (u64 i = 0; i < count; i++) {
+        u64_hashtable_insert(&table, 0x7F0000000000 + i * 64, &i);
+    }
+
+    for (u32 round = 0; round < 16; round++) {
+        for (u32 i = 0; i < count; i++) {
+            u64_hashtable_get(&table, 0x7F0000000000 + ((i * 7919) % count) * 64);
+            lookups++;
+        }
+    }
+
+    u64_hashtable_destroy(&table);
+    return lookups;
+}
+
+/** @brief Same as @ref bench_u64_hashtable_insert, with a typed hash map. */
+static u64 bench_hashmap_insert(u64 load_factor) {
+    u32 count = HASHTABLE_CAPACITY * load_factor / 100;
+
+    HASHMAP(u64, u64) map = {};
+    HASHMAP_RESERVE(map, HASHTABLE_CAPACITY);
+
+    for (u64 i = 0; i < count; i++) {
+        HASHMAP_SET(map, 0x7F0000000000 + i * 64, i);
+    }
+
+    HASHMAP_CLEAR(map);
+    return count;
+}
+
+/** @brief Same as @ref bench_u64_hashtable_get, with a typed hash map. */
+static u64 bench_hashmap_get(u64 load_factor) {
+    u32 count = HASHTABLE_CAPACITY * load_factor / 100;
+    u32 lookups = 0;
+    u64 sum = 0;
+
+    HASHMAP(u64, u64) map = {};
+    HASHMAP_RESERVE(map, HASHTABLE_CAPACITY);
+
+    for (u64 i = 0; i < count; i++) {
+        HASHMAP_SET(map, 0x7F0000000000 + i * 64, i);
+    }
+
+    for (u32 round = 0; round < 16; round++) {
+        for (u32 i = 0; i < count; i++) {
+            u64 *value;
+            HASHMAP_GET(map, 0x7F0000000000 + ((i * 7919) % count) * 64, value);
+            sum += *value;
+            lookups++;
+        }
+    }
+
+    HASHMAP_CLEAR(map);
+
+    // Keep the lookups from being optimized away, since they are inlined
+    return sum != 0 ? lookups : 0;
+}
+
+/** @brief Same as @ref bench_u64_hashtable_get, with a concurrent hashtable (from a single thread). */
+static u64 bench_concurrent_hashtable_get(u64 load_factor) {
+    u32 count = HASHTABLE_CAPACITY * load_factor / 100;
+    u32 lookups = 0;
+
+    concurrent_hashtable table;
+    concurrent_hashtable_init(&table, HASHTABLE_CAPACITY);
+
+    for (u64 i = 0; i < count; i++) {
+        concurrent_hashtable_insert(&table, 0x7F0000000000 + i * 64, &hashtable_keys[i]);
+    }
+
+    for (u32 round = 0; round < 16; round++) {
+        for (u32 i = 0; i < count; i++) {
+            concurrent_hashtable_get(&table, 0x7F0000000000 + ((i * 7919) % count) * 64);
+            lookups++;
+        }
+    }
+
+    concurrent_hashtable_destroy(&table);
+    return lookups;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------------
+// Concurrent queues
+// ---------------------------------------------------------------------------------------------------------------------------
+
+#define QUEUE_CAPACITY 1024
+#define QUEUE_ELEMENTS 1000000
+
+static spsc_queue bench_spsc;
+static mpmc_queue bench_mpmc;
+
+/**
+ * @brief Pushes bursts of elements in a single-producer single-consumer queue, then pops them, from a single thread. This
+ * measures the cost of the operations themselves, without any contention. An operation is an element going through the queue.
+ */
+static u64 bench_spsc_queue_push_pop(u64 burst) {
+    spsc_queue_init(&bench_spsc, sizeof(u64), QUEUE_CAPACITY);
+    u64 sum = 0;
+
+    for (u64 i = 0; i < QUEUE_ELEMENTS; i += burst) {
+        for (u64 j = 0; j < burst; j++) {
+            spsc_queue_push(&bench_spsc, &j);
+        }
+
+        for (u64 j = 0; j < burst; j++) {
+            u64 value;
+            spsc_queue_pop(&bench_spsc, &value);
+            sum += value;
+        }
+    }
+
+    spsc_queue_destroy(&bench_spsc);
+    return sum != 0 ? QUEUE_ELEMENTS : 0;
+}
+
+/** @brief Same as @ref bench_spsc_queue_push_pop, with a multiple-producer multiple-consumer queue. */
+static u64 bench_mpmc_queue_push_pop(u64 burst) {
+    mpmc_queue_init(&bench_mpmc, sizeof(u64), QUEUE_CAPACITY);
+    u64 sum = 0;
+
+    for (u64 i = 0; i < QUEUE_ELEMENTS; i += burst) {
+        for (u64 j = 0; j < burst; j++) {
+            mpmc_queue_push(&bench_mpmc, &j);
+        }
+
+        for (u64 j = 0; j < burst; j++) {
+            u64 value;
+            mpmc_queue_pop(&bench_mpmc, &value);
+            sum += value;
+        }
+    }
+
+    mpmc_queue_destroy(&bench_mpmc);
+    return sum != 0 ? QUEUE_ELEMENTS : 0;
+}
+
+/** @brief Pushes the elements of a transfer benchmark in the single-producer single-consumer queue, from another thread. */
+static void spsc_queue_producer(void *argument) {
+    u64 count = (u64)argument;
+
+    for (u64 i = 1; i <= count; i++) {
+        while (!spsc_queue_push(&bench_spsc, &i)) {
+            platform_thread_yield();
+        }
+    }
+}
+
+/**
+ * @brief Transfers elements from a producer thread to the main thread through a single-producer single-consumer queue. The
+ * threads yield when the queue is full or empty, so that the benchmark also runs on machines with fewer cores than threads.
+ */
+static u64 bench_spsc_queue_transfer(u64 unused) {
+    (void)unused;
+
+    spsc_queue_init(&bench_spsc, sizeof(u64), QUEUE_CAPACITY);
+
+    platform_thread producer;
+    platform_thread_create(spsc_queue_producer, (void *)(u64)QUEUE_ELEMENTS, &producer);
+
+    u64 sum = 0;
+    for (u64 i = 0; i < QUEUE_ELEMENTS; i++) {
+        u64 value;
+        while (!spsc_queue_pop(&bench_spsc, &value)) {
+            platform_thread_yield();
+        }
+        sum += value;
+    }
+
+    platform_thread_join(producer);
+    spsc_queue_destroy(&bench_spsc);
+    return sum != 0 ? QUEUE_ELEMENTS : 0;
+}
+
+/** @brief Pushes the elements of a transfer benchmark in the multiple-producer multiple-consumer queue, from another thread. */
+static void mpmc_queue_producer(void *argument) {
+    u64 count = (u64)argument;
+
+    for (u64 i = 1; i <= count; i++) {
+        while (!mpmc_queue_push(&bench_mpmc, &i)) {
+            platform_thread_yield();
+        }
+    }
+}
+
+/** @brief Same as @ref bench_spsc_queue_transfer, with several producer threads and a multiple-producer queue. */
+static u64 bench_mpmc_queue_transfer(u64 producer_count) {
+    mpmc_queue_init(&bench_mpmc, sizeof(u64), QUEUE_CAPACITY);
+
+    platform_thread producers[8];
+    for (u64 i = 0; i < producer_count; i++) {
+        platform_thread_create(mpmc_queue_producer, (void *)(u64)(QUEUE_ELEMENTS / producer_count), &producers[i]);
+    }
+
+    u64 count = QUEUE_ELEMENTS / producer_count * producer_count;
+    u64 sum = 0;
+    for (u64 i = 0; i < count; i++) {
+        u64 value;
+        while (!mpmc_queue_pop(&bench_mpmc, &value)) {
+            platform_thread_yield();
+        }
+        sum += value;
+    }
+
+    for (u64 i = 0; i < producer_count; i++) {
+        platform_thread_join(producers[i]);
+    }
+
+    mpmc_queue_destroy(&bench_mpmc);
+    return sum != 0 ? count : 0;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------------
+// Threading
+// ---------------------------------------------------------------------------------------------------------------------------
+
+/** @brief Locks and unlocks a mutex that no other thread uses, which never calls the kernel. */
+static u64 bench_mutex_lock_unlock(u64 count) {
+    static platform_mutex mutex = {};
+
+    for (u64 i = 0; i < count; i++) {
+        platform_mutex_lock(&mutex);
+        platform_mutex_unlock(&mutex);
+    }
+
+    return count;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------------
+// Job system
+// ---------------------------------------------------------------------------------------------------------------------------
+
+#define JOB_COUNT 100000
+
+static void job_empty(void *argument) { (void)argument; }
+
+/** @brief Submits empty jobs in batches and waits for each batch, which measures the overhead of a job. */
+static u64 bench_job_run_wait(u64 batch_size) {
+    static job_decl jobs[1024];
+    for (u64 i = 0; i < batch_size; i++) {
+        jobs[i] = (job_decl){ .function = job_empty, .argument = NULL };
+    }
+
+    for (u64 i = 0; i < JOB_COUNT; i += batch_size) {
+        job_counter counter = {};
+        job_run(jobs, batch_size, &counter);
+        job_wait(&counter);
+    }
+
+    return JOB_COUNT;
+}
+
+/** @brief Splits a range in two jobs until it is small enough, like a parallel loop would. */
+static void job_split(void *argument) {
+    u64 size = (u64)argument;
+    if (size <= 1) {
+        return;
+    }
+
+    job_decl halves[2] = {
+        { .function = job_split, .argument = (void *)(size / 2) },
+        { .function = job_split, .argument = (void *)(size - size / 2) },
+    };
+
+    job_counter counter = {};
+    job_run(halves, 2, &counter);
+    job_wait(&counter);
+}
+
+/** @brief Runs a tree of nested fork/join jobs. An operation is a job. */
+static u64 bench_job_fork_join(u64 leaves) {
+    job_split((void *)leaves);
+
+    // A binary tree with n leaves has 2n - 1 nodes, the root being run directly
+    return 2 * leaves - 2;
+}
+
+/** @brief Submits the next link of a chain and waits for it, each link parking its fiber until the end of the chain. */
+static void job_link(void *argument) {
+    u64 remaining = (u64)argument;
+    if (remaining == 0) {
+        return;
+    }
+
+    job_decl next = { .function = job_link, .argument = (void *)(remaining - 1) };
+    job_counter counter = {};
+    job_run(&next, 1, &counter);
+    job_wait(&counter);
+}
+
+/** @brief Runs chains of jobs waiting for each other, several at once, like the dependent passes of a frame. */
+static u64 bench_job_wait_chain(u64 length) {
+    static job_decl chains[8];
+    for (u64 i = 0; i < 8; i++) {
+        chains[i] = (job_decl){ .function = job_link, .argument = (void *)(length - 1) };
+    }
+
+    for (u64 i = 0; i < JOB_COUNT; i += 8 * length) {
+        job_counter counter = {};
+        job_run(chains, 8, &counter);
+        job_wait(&counter);
+    }
+
+    return JOB_COUNT / (8 * length) * 8 * length;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------------
+// TOML
+// ---------------------------------------------------------------------------------------------------------------------------
+
+static char *toml_document = NULL;
+static u64 toml_document_size = 0;
+
+/**
+ * @brief Generates a document with the given number of tables, each holding a few string, integer and boolean entries.
+ *
+ * @note Numbers never start with a 0, which the parser takes for a base prefix.
+ */
+static void toml_document_generate(u32 table_count) {
+    u64 capacity = table_count * 256 + 1;
+    toml_document = mem_alloc(MEMORY_TAG_STRING, capacity);
+    toml_document_size = 0;
+
+    for (u32 i = 0; i < table_count; i++) {
+        toml_document_size += snprintf(toml_document + toml_document_size,
+                                       capacity - toml_document_size,
+                                       "[section_%u]\n"
+                                       "name = \"Section number %u\"\n"
+                                       "path = 'C:\\\\data\\\\%u'\n"
+                                       "count = %u\n"
+                                       "enabled = %s\n\n",
+                                       i,
+                                       i,
+                                       i,
+                                       i * 3 + 1,
+                                       i % 2 ? "true" : "false");
+    }
+}
+
+/** @brief Parses the generated document. An operation is a parsed byte. */
+static u64 bench_toml_parse(u64 unused) {
+    (void)unused;
+
+    toml_table table = {};
+    if (!toml_parse(toml_document, &table)) {
+        LOG_ERROR("Failed to parse the generated document");
+    }
+
+    toml_free(&table);
+    return toml_document_size;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------------
+// Logging
+// ---------------------------------------------------------------------------------------------------------------------------
+
+/** @brief Logs formatted messages. */
+static u64 bench_log_output(u64 count) {
+    for (u64 i = 0; i < count; i++) {
+        log_output(LOG_LEVEL_INFO, "BENCHMARK", "Message %llu with a float %f and a string %s", i, i * 0.5, "payload");
+    }
+
+    return count;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------------
+
+typedef struct benchmark {
+    const char *name;
+    benchmark_function function;
+    u64 argument;
+} benchmark;
+
+static const benchmark benchmarks[] = {
+    { "mem_alloc_free/16", bench_mem_alloc_free_fixed, 16 },
+    { "mem_alloc_free/256", bench_mem_alloc_free_fixed, 256 },
+    { "mem_alloc_free/4096", bench_mem_alloc_free_fixed, 4096 },
+    { "mem_alloc_free/mixed", bench_mem_alloc_free_mixed, 0 },
+    { "dynarray_push/1000", bench_dynarray_push, 1000 },
+    { "dynarray_push/1000000", bench_dynarray_push, 1000000 },
+    { "dynarray_push_scratch/1000", bench_dynarray_push_scratch, 1000 },
+    { "hash_fnv1a/paths", bench_hash_fnv1a, FALSE },
+    { "hash_fnv1a/identifiers", bench_hash_fnv1a, TRUE },
+    { "hash_wyhash/paths", bench_hash_wyhash, FALSE },
+    { "hash_wyhash/identifiers", bench_hash_wyhash, TRUE },
+    { "hashtable_insert/load_25", bench_hashtable_insert, 25 },
+    { "hashtable_insert/load_50", bench_hashtable_insert, 50 },
+    { "hashtable_insert/load_75", bench_hashtable_insert, 75 },
+    { "hashtable_insert/load_90", bench_hashtable_insert, 90 },
+    { "hashtable_get/load_25", bench_hashtable_get, 25 },
+    { "hashtable_get/load_50", bench_hashtable_get, 50 },
+    { "hashtable_get/load_75", bench_hashtable_get, 75 },
+    { "hashtable_get/load_90", bench_hashtable_get, 90 },
+    { "swiss_hashtable_insert/load_25", bench_swiss_hashtable_insert, 25 },
+    { "swiss_hashtable_insert/load_50", bench_swiss_hashtable_insert, 50 },
+    { "swiss_hashtable_insert/load_75", bench_swiss_hashtable_insert, 75 },
+    { "swiss_hashtable_insert/load_90", bench_swiss_hashtable_insert, 90 },
+    { "swiss_hashtable_get/load_25", bench_swiss_hashtable_get, 25 },
+    { "swiss_hashtable_get/load_50", bench_swiss_hashtable_get, 50 },
+    { "swiss_hashtable_get/load_75", bench_swiss_hashtable_get, 75 },
+    { "swiss_hashtable_get/load_90", bench_swiss_hashtable_get, 90 },
+    { "u64_hashtable_insert/load_50", bench_u64_hashtable_insert, 50 },
+    { "u64_hashtable_insert/load_90", bench_u64_hashtable_insert, 90 },
+    { "u64_hashtable_get/load_50", bench_u64_hashtable_get, 50 },
+    { "u64_hashtable_get/load_90", bench_u64_hashtable_get, 90 },
+    { "hashmap_insert/load_50", bench_hashmap_insert, 50 },
+    { "hashmap_insert/load_90", bench_hashmap_insert, 90 },
+    { "hashmap_get/load_50", bench_hashmap_get, 50 },
+    { "hashmap_get/load_90", bench_hashmap_get, 90 },
+    { "concurrent_hashtable_get/load_50", bench_concurrent_hashtable_get, 50 },
+    { "concurrent_hashtable_get/load_90", bench_concurrent_hashtable_get, 90 },
+    { "spsc_queue_push_pop/burst_16", bench_spsc_queue_push_pop, 16 },
+    { "spsc_queue_push_pop/burst_1000", bench_spsc_queue_push_pop, 1000 },
+    { "mpmc_queue_push_pop/burst_16", bench_mpmc_queue_push_pop, 16 },
+    { "mpmc_queue_push_pop/burst_1000", bench_mpmc_queue_push_pop, 1000 },
+    { "spsc_queue_transfer/1_producer", bench_spsc_queue_transfer, 0 },
+    { "mpmc_queue_transfer/1_producer", bench_mpmc_queue_transfer, 1 },
+    { "mpmc_queue_transfer/4_producers", bench_mpmc_queue_transfer, 4 },
+    { "mutex_lock_unlock", bench_mutex_lock_unlock, 1000000 },
+    { "job_run_wait/batch_1", bench_job_run_wait, 1 },
+    { "job_run_wait/batch_1000", bench_job_run_wait, 1000 },
+    { "job_fork_join/65536", bench_job_fork_join, 65536 },
+    { "job_wait_chain/16", bench_job_wait_chain, 16 },
+    { "toml_parse/bytes", bench_toml_parse, 0 },
+    { "log_output", bench_log_output, 10000 },
+};
+
+/**
+ * @brief Runs every benchmark, and writes the report.
+ *
+ * Usage: Benchmarks [report path] [name filter]
+ *
+ * @retval 0 Success
+ * @retval 1 Initialization error
+ * @retval 2 The report could not be written
+ */
+int main(int argc, char **argv) {
+    const char *report_path = argc > 1 ? argv[1] : DEFAULT_REPORT_PATH;
+    const char *filter = argc > 2 ? argv[2] : NULL;
+
+    if (!engine_early_init()) {
+        LOG_ERROR("Failed to initialize engine");
+        return 1;
+    }
+
+    // The job system is not started by the early initialization
+    u64 size_requirement;
+    job_system_init(NULL, &size_requirement);
+    job_system_state *job_state = mem_alloc(MEMORY_TAG_ENGINE, size_requirement);
+    if (!job_system_init(job_state, &size_requirement)) {
+        LOG_ERROR("Failed to initialize the job system");
+        return 1;
+    }
+
+    hash_keys_generate();
+    hashtable_keys_generate();
+    toml_document_generate(2000);
+
+    FILE *report = fopen(report_path, "w");
+    if (report == NULL) {
+        LOG_ERROR("Failed to open the report %s", report_path);
+        return 2;
+    }
+
+    fprintf(report, "name,operations,ns_per_op,allocations_per_op\n");
+
+    benchmark_result results[sizeof(benchmarks) / sizeof(benchmarks[0])];
+    u32 count = sizeof(benchmarks) / sizeof(benchmarks[0]);
+
+    for (u32 i = 0; i < count; i++) {
+        if (filter != NULL && strncmp(benchmarks[i].name, filter, strlen(filter)) != 0) {
+            results[i].operations = 0;
+            continue;
+        }
+
+        results[i] = benchmark_run(benchmarks[i].function, benchmarks[i].argument);
+        fprintf(report,
+                "%s,%llu,%.3f,%.3f\n",
+                benchmarks[i].name,
+                (unsigned long long)results[i].operations,
+                results[i].ns_per_op,
+                results[i].allocations_per_op);
+    }
+
+    fclose(report);
+
+    // The summary is printed at the end, so that it is not lost in the output of the logging benchmark
+    for (u32 i = 0; i < count; i++) {
+        if (results[i].operations != 0) {
+            LOG_INFO("%-34s %12.3f ns/op %10.3f allocs/op",
+                     benchmarks[i].name,
+                     results[i].ns_per_op,
+                     results[i].allocations_per_op);
+        }
+    }
+
+    job_system_deinit(job_state);
+    mem_free(job_state);
+    mem_free(toml_document);
+    return 0;
+}
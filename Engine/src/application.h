@@ -9,6 +9,7 @@
 #pragma once
 
 #include "common.h"
+#include "core/memory.h"
 #include "platform/platform.h"
 #include "renderer/frame_packet.h"
 
@@ -67,4 +68,7 @@ typedef struct application {
 
     /** @brief The configuration of the window. */
     window_config window_config;
+
+    /** @brief The memory budgets, per tag (see @ref mem_set_budget). Zeroed budgets are unlimited. */
+    memory_budget memory_budgets[MEMORY_TAG_MAX_TAGS];
 } application;
@@ -40,5 +40,9 @@ typedef u8 b8;
 #endif
 #endif
 
-typedef u32 uuid;
-#define INVALID_UUID 0xFFFFFFFF
+/** @brief The size of a cache line. Data written by different threads is kept on different lines, so they do not contend. */
+#define CACHE_LINE_SIZE 64
+
+/** @brief A handle to an object of a registry: the index of its slot in the 32 low bits, and the generation of the slot above. */
+typedef u64 uuid;
+#define INVALID_UUID 0xFFFFFFFFFFFFFFFFull
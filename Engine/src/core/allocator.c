@@ -0,0 +1,132 @@
+#include "allocator.h"
+#include "math/math.h"
+
+#define LOG_SCOPE "ALLOCATOR"
+#include "core/log.h"
+
+static void *heap_allocate(void *context, u64 size, u64 alignment) {
+    return mem_alloc_aligned((memory_tag)(u64)context, size, alignment);
+}
+
+static void *heap_reallocate(void *context, void *ptr, u64 old_size, u64 new_size, u64 alignment) {
+    (void)old_size;
+
+    if (ptr == NULL) {
+        return mem_alloc_aligned((memory_tag)(u64)context, new_size, alignment);
+    }
+
+    return mem_realloc(ptr, new_size);
+}
+
+static void heap_free(void *context, void *ptr, u64 size) {
+    (void)context;
+    (void)size;
+    mem_free(ptr);
+}
+
+static void *frame_allocate(void *context, u64 size, u64 alignment) {
+    (void)context;
+    return mem_frame_alloc_aligned(size, alignment);
+}
+
+static void *scratch_allocate(void *context, u64 size, u64 alignment) {
+    (void)context;
+    return mem_scratch_alloc_aligned(size, alignment);
+}
+
+static void *linear_allocate(void *context, u64 size, u64 alignment) {
+    return linear_allocator_allocate(context, size, alignment);
+}
+
+static void *linear_reallocate(void *context, void *ptr, u64 old_size, u64 new_size, u64 alignment) {
+    linear_allocator *linear = context;
+
+    // The last block can grow (or shrink) by moving the end of the allocated part
+    if (ptr != NULL && (u8 *)ptr + old_size == (u8 *)linear->memory + linear->allocated) {
+        u64 offset = (u8 *)ptr - (u8 *)linear->memory;
+        if (offset + new_size <= linear->total_size) {
+            linear->allocated = offset + new_size;
+            return ptr;
+        }
+    }
+
+    void *new_ptr = linear_allocator_allocate(linear, new_size, alignment);
+    if (new_ptr != NULL && ptr != NULL) {
+        mem_copy(new_ptr, ptr, MIN(old_size, new_size));
+    }
+
+    return new_ptr;
+}
+
+static void *pool_allocate(void *context, u64 size, u64 alignment) {
+    pool_allocator *pool = context;
+    if (size > pool->element_size || alignment > pool->alignment) {
+        LOG_ERROR("Cannot allocate %llu bytes aligned on %llu from a pool of %llu bytes elements",
+                  size,
+                  alignment,
+                  pool->element_size);
+        return NULL;
+    }
+
+    return pool_allocator_allocate(pool);
+}
+
+static void pool_free(void *context, void *ptr, u64 size) {
+    (void)size;
+    pool_allocator_free(context, ptr);
+}
+
+#define HEAP_ALLOCATOR(tag) [tag] = { heap_allocate, heap_reallocate, heap_free, (void *)(u64)(tag) }
+
+/** @brief The heap allocators of every tag. */
+static const allocator heap_allocators[MEMORY_TAG_MAX_TAGS] = {
+    HEAP_ALLOCATOR(MEMORY_TAG_UNKNOWN), HEAP_ALLOCATOR(MEMORY_TAG_DYNARRAY), HEAP_ALLOCATOR(MEMORY_TAG_HASHTABLE),
+    HEAP_ALLOCATOR(MEMORY_TAG_ENGINE),  HEAP_ALLOCATOR(MEMORY_TAG_PLATFORM), HEAP_ALLOCATOR(MEMORY_TAG_STRING),
+    HEAP_ALLOCATOR(MEMORY_TAG_RENDERER), HEAP_ALLOCATOR(MEMORY_TAG_VULKAN),
+};
+
+_Static_assert(MEMORY_TAG_MAX_TAGS == 8, "Every tag needs a heap allocator");
+
+API void allocator_create_heap(allocator *allocator, memory_tag tag) {
+    *allocator = (struct allocator){ heap_allocate, heap_reallocate, heap_free, (void *)(u64)tag };
+}
+
+API const allocator *allocator_get_heap(memory_tag tag) { return &heap_allocators[tag]; }
+
+API void allocator_create_frame(allocator *allocator) { *allocator = (struct allocator){ frame_allocate, NULL, NULL, NULL }; }
+
+API void allocator_create_scratch(allocator *allocator) {
+    *allocator = (struct allocator){ scratch_allocate, NULL, NULL, NULL };
+}
+
+API void allocator_create_linear(allocator *allocator, linear_allocator *linear) {
+    *allocator = (struct allocator){ linear_allocate, linear_reallocate, NULL, linear };
+}
+
+API void allocator_create_pool(allocator *allocator, pool_allocator *pool) {
+    *allocator = (struct allocator){ pool_allocate, NULL, pool_free, pool };
+}
+
+API void *allocator_allocate(const allocator *allocator, u64 size, u64 alignment) {
+    return allocator->allocate(allocator->context, size, alignment);
+}
+
+API void *allocator_reallocate(const allocator *allocator, void *ptr, u64 old_size, u64 new_size, u64 alignment) {
+    if (allocator->reallocate != NULL) {
+        return allocator->reallocate(allocator->context, ptr, old_size, new_size, alignment);
+    }
+
+    void *new_ptr = allocator->allocate(allocator->context, new_size, alignment);
+    if (new_ptr != NULL && ptr != NULL) {
+        mem_copy(new_ptr, ptr, MIN(old_size, new_size));
+        allocator_free(allocator, ptr, old_size);
+    }
+
+    return new_ptr;
+}
+
+API void allocator_free(const allocator *allocator, void *ptr, u64 size) {
+    if (ptr != NULL && allocator->free != NULL) {
+        allocator->free(allocator->context, ptr, size);
+    }
+}
@@ -0,0 +1,120 @@
+/**
+ * @file allocator.h
+ * @author Killian Bellouard (killianbellouard@gmail.com)
+ * @brief This file defines the allocator interface taken by the containers.
+ *
+ * An allocator is a table of functions and a context. The containers given one allocate their storage through it, instead of
+ * the heap with their generic tag. The heap allocator keeps the memory tagged to the owning subsystem, while the frame arena,
+ * the scratch stack and linear allocators let temporary containers be discarded wholesale, without freeing each of them.
+ *
+ * The allocator is referenced, not copied, by the containers: it must outlive them.
+ * @version 0.1
+ * @date 2024-08-18
+ */
+
+#pragma once
+
+#include "common.h"
+#include "core/linear_allocator.h"
+#include "core/pool_allocator.h"
+#include "memory.h"
+
+/** @brief An allocator, as seen by the containers. */
+typedef struct allocator {
+    /** @brief Allocates a block. Returns NULL on failure. */
+    void *(*allocate)(void *context, u64 size, u64 alignment);
+    /** @brief Resizes a block, moving it if needed. Returns NULL on failure. NULL to allocate, copy and free instead. */
+    void *(*reallocate)(void *context, void *ptr, u64 old_size, u64 new_size, u64 alignment);
+    /** @brief Frees a block. NULL if the memory is only released wholesale. */
+    void (*free)(void *context, void *ptr, u64 size);
+    /** @brief The context given to the functions. */
+    void *context;
+} allocator;
+
+/**
+ * @brief Creates an allocator serving blocks from the heap, with the given tag.
+ *
+ * @param[out] allocator A pointer to the allocator to initialize.
+ * @param[in] tag The tag of the blocks.
+ */
+API void allocator_create_heap(allocator *allocator, memory_tag tag);
+
+/**
+ * @brief Gets the heap allocator of a tag, shared by the containers that are not given an allocator.
+ *
+ * @param[in] tag The tag of the blocks.
+ *
+ * @return The allocator, valid for the lifetime of the program.
+ */
+API const allocator *allocator_get_heap(memory_tag tag);
+
+/**
+ * @brief Creates an allocator serving blocks from the current frame arena. Blocks are released when the arena is reused.
+ *
+ * @see mem_frame_alloc
+ *
+ * @param[out] allocator A pointer to the allocator to initialize.
+ */
+API void allocator_create_frame(allocator *allocator);
+
+/**
+ * @brief Creates an allocator serving blocks from the scratch stack of the calling thread. Blocks are released by rewinding it.
+ *
+ * @note The containers using it must not be shared with other threads.
+ *
+ * @see mem_scratch_alloc
+ *
+ * @param[out] allocator A pointer to the allocator to initialize.
+ */
+API void allocator_create_scratch(allocator *allocator);
+
+/**
+ * @brief Creates an allocator serving blocks from a linear allocator. Blocks are released when it is freed all at once.
+ *
+ * The last block allocated is grown in place.
+ *
+ * @param[out] allocator A pointer to the allocator to initialize.
+ * @param[in] linear The linear allocator.
+ */
+API void allocator_create_linear(allocator *allocator, linear_allocator *linear);
+
+/**
+ * @brief Creates an allocator serving blocks from a pool. Blocks cannot be larger than the elements of the pool.
+ *
+ * @param[out] allocator A pointer to the allocator to initialize.
+ * @param[in] pool The pool.
+ */
+API void allocator_create_pool(allocator *allocator, pool_allocator *pool);
+
+/**
+ * @brief Allocates a block.
+ *
+ * @param[in] allocator The allocator.
+ * @param[in] size The size of the block.
+ * @param[in] alignment The alignment of the block (must be a power of two).
+ *
+ * @return A pointer to the block, or NULL on failure.
+ */
+API void *allocator_allocate(const allocator *allocator, u64 size, u64 alignment);
+
+/**
+ * @brief Resizes a block, moving it if needed. The contents are preserved up to the smaller of the old and new sizes.
+ *
+ * @param[in] allocator The allocator the block was allocated from.
+ * @param[in] ptr The block, or NULL to allocate a new one.
+ * @param[in] old_size The current size of the block.
+ * @param[in] new_size The new size of the block.
+ * @param[in] alignment The alignment of the block.
+ *
+ * @return A pointer to the resized block, or NULL on failure, in which case the given block is left untouched.
+ */
+API void *allocator_reallocate(const allocator *allocator, void *ptr, u64 old_size, u64 new_size, u64 alignment);
+
+/**
+ * @brief Frees a block. Does nothing for the allocators that only release their memory wholesale.
+ *
+ * @param[in] allocator The allocator the block was allocated from.
+ * @param[in] ptr The block, or NULL.
+ * @param[in] size The size of the block.
+ */
+API void allocator_free(const allocator *allocator, void *ptr, u64 size);
@@ -0,0 +1,79 @@
+/**
+ * @file atomic.h
+ * @author Killian Bellouard (killianbellouard@gmail.com)
+ * @brief This file defines typed atomic operations on plain variables, with the memory orders of C11.
+ *
+ * The operations map directly to the __atomic builtins of GCC and Clang, which implement the C11 memory model, so they cost
+ * exactly what the builtins cost. Unlike the _Atomic types of <stdatomic.h>, they apply to plain fields, so a structure can be
+ * initialized, copied or zeroed like any other before it is shared between threads.
+ * @version 0.1
+ * @date 2024-08-20
+ */
+
+#pragma once
+
+#include "common.h"
+
+/** @brief The memory orders, as defined by C11. */
+typedef enum atomic_order {
+    ATOMIC_ORDER_RELAXED = __ATOMIC_RELAXED,
+    ATOMIC_ORDER_ACQUIRE = __ATOMIC_ACQUIRE,
+    ATOMIC_ORDER_RELEASE = __ATOMIC_RELEASE,
+    ATOMIC_ORDER_ACQ_REL = __ATOMIC_ACQ_REL,
+    ATOMIC_ORDER_SEQ_CST = __ATOMIC_SEQ_CST,
+} atomic_order;
+
+/** @brief Defines the operations shared by every atomic type, suffixed with the given name. */
+#define ATOMIC_DEFINE_COMMON(name, type)                                                                                      \
+    /** @brief Loads the value of an object. */                                                                               \
+    static inline type atomic_load_##name(type *object, atomic_order order) { return __atomic_load_n(object, order); }        \
+    /** @brief Stores a value in an object. */                                                                                \
+    static inline void atomic_store_##name(type *object, type value, atomic_order order) {                                    \
+        __atomic_store_n(object, value, order);                                                                               \
+    }                                                                                                                         \
+    /** @brief Replaces the value of an object, returning the previous one. */                                                \
+    static inline type atomic_exchange_##name(type *object, type value, atomic_order order) {                                 \
+        return __atomic_exchange_n(object, value, order);                                                                     \
+    }                                                                                                                         \
+    /** @brief Replaces the value of an object if it is the expected one. Otherwise, stores the current value in expected. */ \
+    static inline b8 atomic_compare_exchange_##name(type *object, type *expected, type desired, atomic_order order) {         \
+        /* The failure order cannot be a release order */                                                                     \
+        atomic_order failure_order = order == ATOMIC_ORDER_ACQ_REL ? ATOMIC_ORDER_ACQUIRE                                     \
+                                     : order == ATOMIC_ORDER_RELEASE ? ATOMIC_ORDER_RELAXED                                   \
+                                                                     : order;                                                 \
+        return __atomic_compare_exchange_n(object, expected, desired, FALSE, order, failure_order);                           \
+    }
+
+/** @brief Defines the arithmetic operations of an integer atomic type, suffixed with the given name. */
+#define ATOMIC_DEFINE_INTEGER(name, type)                                                                 \
+    ATOMIC_DEFINE_COMMON(name, type)                                                                      \
+    /** @brief Adds a value to an object, returning the previous value. */                                \
+    static inline type atomic_fetch_add_##name(type *object, type value, atomic_order order) {            \
+        return __atomic_fetch_add(object, value, order);                                                  \
+    }                                                                                                     \
+    /** @brief Subtracts a value from an object, returning the previous value. */                         \
+    static inline type atomic_fetch_sub_##name(type *object, type value, atomic_order order) {            \
+        return __atomic_fetch_sub(object, value, order);                                                  \
+    }                                                                                                     \
+    /** @brief Sets bits of an object, returning the previous value. */                                   \
+    static inline type atomic_fetch_or_##name(type *object, type value, atomic_order order) {             \
+        return __atomic_fetch_or(object, value, order);                                                   \
+    }                                                                                                     \
+    /** @brief Clears the bits of an object that are not set in a value, returning the previous value. */ \
+    static inline type atomic_fetch_and_##name(type *object, type value, atomic_order order) {            \
+        return __atomic_fetch_and(object, value, order);                                                  \
+    }
+
+ATOMIC_DEFINE_INTEGER(u8, u8)
+ATOMIC_DEFINE_INTEGER(u32, u32)
+ATOMIC_DEFINE_INTEGER(u64, u64)
+ATOMIC_DEFINE_INTEGER(i32, i32)
+ATOMIC_DEFINE_INTEGER(i64, i64)
+ATOMIC_DEFINE_COMMON(ptr, void *)
+
+/**
+ * @brief Orders the memory accesses before and after the fence, without accessing any object.
+ *
+ * @param[in] order The memory order of the fence.
+ */
+static inline void atomic_fence(atomic_order order) { __atomic_thread_fence(order); }
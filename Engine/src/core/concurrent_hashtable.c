@@ -0,0 +1,335 @@
+#include "concurrent_hashtable.h"
+#include "core/atomic.h"
+#include "core/hash.h"
+#include "memory.h"
+
+#define LOG_SCOPE "CONCURRENT HASHTABLE"
+#include "core/log.h"
+
+/** @brief The key of a slot that has never been used. */
+#define EMPTY_KEY 0xFFFFFFFFFFFFFFFF
+
+/** @brief The smallest capacity of a shard. */
+#define MIN_CAPACITY 16
+
+/** @brief The maximum ratio (in percents) of slots holding a key, live or removed, before a shard is rebuilt. */
+#define MAX_LOAD_FACTOR 75
+
+/** @brief The number of bits of the hash selecting the shard. */
+#define SHARD_BITS 4
+
+_Static_assert(CONCURRENT_HASHTABLE_SHARD_COUNT == 1 << SHARD_BITS, "The shard count must match the shard bits");
+
+/** @brief A slot. Both fields are accessed atomically. */
+typedef struct concurrent_hashtable_slot {
+    u64 key;
+    void *value;
+} concurrent_hashtable_slot;
+
+/** @brief The table of a shard. */
+typedef struct concurrent_hashtable_table {
+    /** @brief The next older retired table of the shard, once this one is retired. */
+    struct concurrent_hashtable_table *next_retired;
+    /** @brief The epoch the table was retired in. */
+    u64 retire_epoch;
+    /** @brief The number of slots, always a power of two. */
+    u64 capacity;
+    concurrent_hashtable_slot slots[];
+} concurrent_hashtable_table;
+
+static concurrent_hashtable_table *table_create(u64 capacity) {
+    concurrent_hashtable_table *table =
+        mem_alloc(MEMORY_TAG_HASHTABLE, sizeof(concurrent_hashtable_table) + capacity * sizeof(concurrent_hashtable_slot));
+    if (table == NULL) {
+        return NULL;
+    }
+
+    table->next_retired = NULL;
+    table->retire_epoch = 0;
+    table->capacity = capacity;
+    for (u64 i = 0; i < capacity; i++) {
+        table->slots[i].key = EMPTY_KEY;
+        table->slots[i].value = NULL;
+    }
+
+    return table;
+}
+
+/** @brief Marks the calling thread, whose address picks the reader counters of the thread. */
+static _Thread_local u8 reader_marker;
+
+/**
+ * @brief Announces a reader in the counter of its thread, for the current epoch.
+ *
+ * @return The counter to decrement once the reader is done.
+ */
+static u64 *reader_enter(concurrent_hashtable *table) {
+    concurrent_hashtable_readers *readers =
+        &table->readers[hash_u64((u64)&reader_marker) & (CONCURRENT_HASHTABLE_READER_STRIPE_COUNT - 1)];
+
+    for (;;) {
+        u64 epoch = atomic_load_u64(&table->epoch, ATOMIC_ORDER_ACQUIRE);
+        u64 *active = &readers->active[epoch & 1];
+        atomic_fetch_add_u64(active, 1, ATOMIC_ORDER_SEQ_CST);
+
+        // The epoch may have advanced before the reader was counted, in which case it no longer protects the epoch it read
+        if (atomic_load_u64(&table->epoch, ATOMIC_ORDER_SEQ_CST) == epoch) {
+            return active;
+        }
+
+        atomic_fetch_sub_u64(active, 1, ATOMIC_ORDER_RELAXED);
+    }
+}
+
+/** @brief Announces the end of a reader. What it read is ordered before the reclamation of the tables. */
+static void reader_exit(u64 *active) { atomic_fetch_sub_u64(active, 1, ATOMIC_ORDER_RELEASE); }
+
+/**
+ * @brief Advances the epoch if no reader is left on the parity of the previous one (which the next one reuses).
+ *
+ * @return The current epoch.
+ */
+static u64 epoch_try_advance(concurrent_hashtable *table) {
+    u64 epoch = atomic_load_u64(&table->epoch, ATOMIC_ORDER_SEQ_CST);
+    for (u32 i = 0; i < CONCURRENT_HASHTABLE_READER_STRIPE_COUNT; i++) {
+        if (atomic_load_u64(&table->readers[i].active[(epoch + 1) & 1], ATOMIC_ORDER_SEQ_CST) != 0) {
+            return epoch;
+        }
+    }
+
+    // A failed exchange means that another writer advanced it
+    atomic_compare_exchange_u64(&table->epoch, &epoch, epoch + 1, ATOMIC_ORDER_SEQ_CST);
+    return atomic_load_u64(&table->epoch, ATOMIC_ORDER_ACQUIRE);
+}
+
+/**
+ * @brief Frees the previous tables of a shard that no reader can hold anymore.
+ *
+ * @note The lock of the shard must be held.
+ */
+static void shard_reclaim(concurrent_hashtable *table, concurrent_hashtable_shard *shard) {
+    if (shard->retired == NULL) {
+        return;
+    }
+
+    // The retired tables are sorted from the newest, so every table after the first one old enough is old enough as well
+    u64 epoch = epoch_try_advance(table);
+    concurrent_hashtable_table **link = &shard->retired;
+    while (*link != NULL && (*link)->retire_epoch + 2 > epoch) {
+        link = &(*link)->next_retired;
+    }
+
+    concurrent_hashtable_table *retired = *link;
+    *link = NULL;
+
+    while (retired != NULL) {
+        concurrent_hashtable_table *next = retired->next_retired;
+        mem_free(retired);
+        retired = next;
+    }
+}
+
+/**
+ * @brief Rebuilds the table of a shard without its removed entries, and publishes it.
+ *
+ * @note The lock of the shard must be held.
+ */
+static b8 shard_rebuild(concurrent_hashtable *table, concurrent_hashtable_shard *shard, u64 new_capacity) {
+    concurrent_hashtable_table *old_table = shard->table;
+    concurrent_hashtable_table *new_table = table_create(new_capacity);
+    if (new_table == NULL) {
+        LOG_ERROR("Failed to allocate %llu slots", new_capacity);
+        return FALSE;
+    }
+
+    // The new table is not published yet, so plain accesses are enough to fill it
+    u64 mask = new_capacity - 1;
+    for (u64 i = 0; i < old_table->capacity; i++) {
+        concurrent_hashtable_slot *slot = &old_table->slots[i];
+        if (slot->key == EMPTY_KEY || slot->value == NULL) {
+            continue;
+        }
+
+        u64 index = hash_u64(slot->key) & mask;
+        while (new_table->slots[index].key != EMPTY_KEY) {
+            index = (index + 1) & mask;
+        }
+
+        new_table->slots[index] = *slot;
+    }
+
+    shard->used = shard->count;
+    atomic_store_ptr((void **)&shard->table, new_table, ATOMIC_ORDER_SEQ_CST);
+
+    // Readers that got the old table were counted in this epoch or an earlier one
+    old_table->retire_epoch = atomic_load_u64(&table->epoch, ATOMIC_ORDER_SEQ_CST);
+    old_table->next_retired = shard->retired;
+    shard->retired = old_table;
+    return TRUE;
+}
+
+API b8 concurrent_hashtable_init(concurrent_hashtable *table, u32 initial_capacity) {
+    mem_zero(table, sizeof(concurrent_hashtable));
+
+    u64 capacity = MIN_CAPACITY;
+    while (capacity * MAX_LOAD_FACTOR / 100 < initial_capacity / CONCURRENT_HASHTABLE_SHARD_COUNT) {
+        capacity *= 2;
+    }
+
+    for (u32 i = 0; i < CONCURRENT_HASHTABLE_SHARD_COUNT; i++) {
+        table->shards[i].table = table_create(capacity);
+        if (table->shards[i].table == NULL) {
+            LOG_ERROR("Failed to allocate the shards");
+            concurrent_hashtable_destroy(table);
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+API void concurrent_hashtable_destroy(concurrent_hashtable *table) {
+    for (u32 i = 0; i < CONCURRENT_HASHTABLE_SHARD_COUNT; i++) {
+        if (table->shards[i].table != NULL) {
+            mem_free(table->shards[i].table);
+        }
+
+        concurrent_hashtable_table *retired = table->shards[i].retired;
+        while (retired != NULL) {
+            concurrent_hashtable_table *next = retired->next_retired;
+            mem_free(retired);
+            retired = next;
+        }
+    }
+
+    mem_zero(table, sizeof(concurrent_hashtable));
+}
+
+API void concurrent_hashtable_reclaim(concurrent_hashtable *table) {
+    for (u32 i = 0; i < CONCURRENT_HASHTABLE_SHARD_COUNT; i++) {
+        concurrent_hashtable_shard *shard = &table->shards[i];
+        if (atomic_load_ptr((void **)&shard->retired, ATOMIC_ORDER_RELAXED) == NULL) {
+            continue;
+        }
+
+        spinlock_acquire(&shard->lock);
+        shard_reclaim(table, shard);
+        spinlock_release(&shard->lock);
+    }
+}
+
+API b8 concurrent_hashtable_insert(concurrent_hashtable *table, u64 key, void *value) {
+    u64 key_hash = hash_u64(key);
+    concurrent_hashtable_shard *shard = &table->shards[key_hash >> (64 - SHARD_BITS)];
+
+    spinlock_acquire(&shard->lock);
+    shard_reclaim(table, shard);
+
+    concurrent_hashtable_table *shard_table = shard->table;
+    if ((shard->used + 1) * 100 > shard_table->capacity * MAX_LOAD_FACTOR) {
+        // Only grow if the live entries need it, otherwise rebuilding at the same capacity is enough to drop the removed ones
+        u64 new_capacity = shard_table->capacity;
+        if ((shard->count + 1) * 100 * 2 > shard_table->capacity * MAX_LOAD_FACTOR) {
+            new_capacity *= 2;
+        }
+
+        if (!shard_rebuild(table, shard, new_capacity)) {
+            spinlock_release(&shard->lock);
+            return FALSE;
+        }
+
+        shard_table = shard->table;
+    }
+
+    u64 mask = shard_table->capacity - 1;
+    for (u64 index = key_hash & mask;; index = (index + 1) & mask) {
+        concurrent_hashtable_slot *slot = &shard_table->slots[index];
+
+        if (slot->key == key) {
+            if (slot->value != NULL) {
+                spinlock_release(&shard->lock);
+                return FALSE;
+            }
+
+            // Revive the removed entry
+            atomic_store_ptr(&slot->value, value, ATOMIC_ORDER_RELEASE);
+            break;
+        }
+
+        if (slot->key == EMPTY_KEY) {
+            // The value must be visible before the key is
+            atomic_store_ptr(&slot->value, value, ATOMIC_ORDER_RELAXED);
+            atomic_store_u64(&slot->key, key, ATOMIC_ORDER_RELEASE);
+            shard->used++;
+            break;
+        }
+    }
+
+    shard->count++;
+    spinlock_release(&shard->lock);
+    return TRUE;
+}
+
+API b8 concurrent_hashtable_set(concurrent_hashtable *table, u64 key, void *value) {
+    u64 key_hash = hash_u64(key);
+    concurrent_hashtable_shard *shard = &table->shards[key_hash >> (64 - SHARD_BITS)];
+
+    spinlock_acquire(&shard->lock);
+    shard_reclaim(table, shard);
+
+    concurrent_hashtable_table *shard_table = shard->table;
+    u64 mask = shard_table->capacity - 1;
+    for (u64 index = key_hash & mask;; index = (index + 1) & mask) {
+        concurrent_hashtable_slot *slot = &shard_table->slots[index];
+
+        if (slot->key == EMPTY_KEY) {
+            break;
+        }
+
+        if (slot->key == key) {
+            if (slot->value == NULL) {
+                break;
+            }
+
+            if (value == NULL) {
+                shard->count--;
+            }
+
+            atomic_store_ptr(&slot->value, value, ATOMIC_ORDER_RELEASE);
+            spinlock_release(&shard->lock);
+            return TRUE;
+        }
+    }
+
+    spinlock_release(&shard->lock);
+    return FALSE;
+}
+
+API void *concurrent_hashtable_get(concurrent_hashtable *table, u64 key) {
+    u64 key_hash = hash_u64(key);
+    concurrent_hashtable_shard *shard = &table->shards[key_hash >> (64 - SHARD_BITS)];
+
+    // The table must be loaded after the reader is counted, for its reclamation to wait for the reader
+    u64 *active = reader_enter(table);
+    concurrent_hashtable_table *shard_table = atomic_load_ptr((void **)&shard->table, ATOMIC_ORDER_SEQ_CST);
+    void *value = NULL;
+
+    // The load factor guarantees that there is an empty slot ending the probe sequence
+    u64 mask = shard_table->capacity - 1;
+    for (u64 index = key_hash & mask;; index = (index + 1) & mask) {
+        concurrent_hashtable_slot *slot = &shard_table->slots[index];
+        u64 slot_key = atomic_load_u64(&slot->key, ATOMIC_ORDER_ACQUIRE);
+
+        if (slot_key == key) {
+            value = atomic_load_ptr(&slot->value, ATOMIC_ORDER_ACQUIRE);
+            break;
+        }
+
+        if (slot_key == EMPTY_KEY) {
+            break;
+        }
+    }
+
+    reader_exit(active);
+    return value;
+}
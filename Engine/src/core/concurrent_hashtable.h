@@ -0,0 +1,128 @@
+/**
+ * @file concurrent_hashtable.h
+ * @author Killian Bellouard (killianbellouard@gmail.com)
+ * @brief This file defines a concurrent hash table, for registries read by many threads and written rarely.
+ *
+ * Reads are lock-free: they never wait, even while another thread is inserting, removing or growing the table. Writes lock one
+ * of 16 shards, selected by the high bits of the hash of the key, so writers only wait for writers of the same shard.
+ *
+ * Each shard is an open-addressing table with linear probing, holding u64 keys and pointer values. Writers publish an entry by
+ * storing its key after its value, with release semantics, so a reader that sees the key also sees the value. A removed entry
+ * keeps its key with a NULL value, and is revived if the key is inserted again. A shard grows (or drops its removed entries)
+ * by building a new table and publishing it, like a read-copy-update: readers still probing the previous table finish on it.
+ *
+ * Previous tables are freed with epoch-based reclamation. A reader announces itself in one of 16 counters, picked by its thread,
+ * for the parity of the epoch of the table. The epoch only advances once no reader is left on the parity of the previous one,
+ * so a table retired at epoch e can no longer be read once the epoch reaches e + 2. Writes try to advance the epoch and free
+ * the previous tables of their shard, and @ref concurrent_hashtable_reclaim does it for every shard, for tables written in
+ * bursts.
+ *
+ * @note The key 0xFFFFFFFFFFFFFFFF is reserved. Pointers and uuids can be used as keys.
+ * @version 0.1
+ * @date 2024-08-17
+ */
+
+#pragma once
+
+#include "common.h"
+#include "core/spinlock.h"
+
+/** @brief The number of shards of a concurrent hash table. */
+#define CONCURRENT_HASHTABLE_SHARD_COUNT 16
+
+/** @brief The number of reader counters of a concurrent hash table, spreading the readers over cache lines. */
+#define CONCURRENT_HASHTABLE_READER_STRIPE_COUNT 16
+
+/** @brief A shard of a concurrent hash table, on its own cache line so that writers of different shards do not contend. */
+typedef struct concurrent_hashtable_shard {
+    /** @brief The lock taken by writers. */
+    _Alignas(CACHE_LINE_SIZE) spinlock lock;
+    /** @brief The current table of the shard, read atomically. */
+    struct concurrent_hashtable_table *table;
+    /** @brief The previous tables of the shard not freed yet, newest first. */
+    struct concurrent_hashtable_table *retired;
+    /** @brief The number of live entries. */
+    u32 count;
+    /** @brief The number of slots holding a key, live or removed. */
+    u32 used;
+} concurrent_hashtable_shard;
+
+/** @brief The readers of a concurrent hash table running on a subset of the threads, per parity of the epoch they started in. */
+typedef struct concurrent_hashtable_readers {
+    _Alignas(CACHE_LINE_SIZE) u64 active[2];
+} concurrent_hashtable_readers;
+
+/** @brief A concurrent hash table, mapping u64 keys to pointers. */
+typedef struct concurrent_hashtable {
+    concurrent_hashtable_shard shards[CONCURRENT_HASHTABLE_SHARD_COUNT];
+    concurrent_hashtable_readers readers[CONCURRENT_HASHTABLE_READER_STRIPE_COUNT];
+    /** @brief The reclamation epoch, read atomically. */
+    _Alignas(CACHE_LINE_SIZE) u64 epoch;
+} concurrent_hashtable;
+
+/**
+ * @brief Initializes a concurrent hashtable.
+ *
+ * @param[out] table The hashtable to initialize.
+ * @param[in] initial_capacity The number of elements the hashtable can hold before growing (assuming keys spread evenly over
+ * the shards).
+ *
+ * @retval TRUE Success
+ * @retval FALSE Failure
+ */
+API b8 concurrent_hashtable_init(concurrent_hashtable *table, u32 initial_capacity);
+
+/**
+ * @brief Destroys a concurrent hashtable.
+ *
+ * @warning No other thread may access the table anymore.
+ *
+ * @param[in] table The hashtable to destroy.
+ */
+API void concurrent_hashtable_destroy(concurrent_hashtable *table);
+
+/**
+ * @brief Frees the previous tables of every shard that no reader can hold anymore.
+ *
+ * Writes already reclaim the tables of their shard. Call this function at idle points (like the beginning of a frame) for
+ * tables written in bursts, whose previous tables would otherwise wait for the next writes.
+ *
+ * @param[in] table The hashtable.
+ */
+API void concurrent_hashtable_reclaim(concurrent_hashtable *table);
+
+/**
+ * @brief Inserts an element in a concurrent hashtable.
+ *
+ * @param[in] table The hashtable to insert the element in.
+ * @param[in] key The key of the element.
+ * @param[in] value The value of the element (must not be NULL).
+ *
+ * @retval TRUE Success
+ * @retval FALSE Failure (if the key already exists or the table could not grow)
+ */
+API b8 concurrent_hashtable_insert(concurrent_hashtable *table, u64 key, void *value);
+
+/**
+ * @brief Sets an element in a concurrent hashtable.
+ *
+ * @param[in] table The hashtable to set the element in.
+ * @param[in] key The key of the element.
+ * @param[in] value The value of the element, or NULL to remove the element.
+ *
+ * @retval TRUE Success
+ * @retval FALSE Failure (if the key does not exist)
+ */
+API b8 concurrent_hashtable_set(concurrent_hashtable *table, u64 key, void *value);
+
+/**
+ * @brief Gets an element from a concurrent hashtable, without locking.
+ *
+ * @note An element inserted or removed by another thread while this function runs may or may not be seen.
+ *
+ * @param[in] table The hashtable to get the element from.
+ * @param[in] key The key of the element.
+ *
+ * @returns The value of the element if it exists, NULL otherwise.
+ */
+API void *concurrent_hashtable_get(concurrent_hashtable *table, u64 key);
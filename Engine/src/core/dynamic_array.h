@@ -9,58 +9,104 @@
 #pragma once
 
 #include "common.h"
+#include "core/allocator.h"
 #include "memory.h"
 
 /**
  * @brief Defines a dynamic array.
  *
+ * The storage comes from the heap, with the DYNARRAY tag, unless the array is given an allocator with @ref DYNARRAY_INIT.
+ *
  * @param [in] type The type of the elements in the array.
  */
-#define DYNARRAY(type) \
-    struct {           \
-        type *data;    \
-        u32 count;     \
-        u32 capacity;  \
+#define DYNARRAY(type)              \
+    struct {                        \
+        type *data;                 \
+        u32 count;                  \
+        u32 capacity;               \
+        const allocator *allocator; \
     }
 
 /**
- * @brief Clears a dynamic array, freeing its memory.
+ * @brief Initializes an empty dynamic array, whose storage comes from the given allocator.
+ *
+ * @param [in] array The array to initialize.
+ * @param [in] alloc A pointer to the allocator (which must outlive the array), or NULL for the heap.
+ */
+#define DYNARRAY_INIT(array, alloc)  \
+    do {                             \
+        (array).data = NULL;         \
+        (array).count = 0;           \
+        (array).capacity = 0;        \
+        (array).allocator = (alloc); \
+    } while (FALSE)
+
+/**
+ * @brief Clears a dynamic array, freeing its memory. The array keeps its allocator.
  *
  * @param [in] array The array to clear.
  */
-#define DYNARRAY_CLEAR(array)       \
-    do {                            \
-        if ((array).data) {         \
-            mem_free((array).data); \
-        }                           \
-        (array).data = NULL;        \
-        (array).count = 0;          \
-        (array).capacity = 0;       \
+#define DYNARRAY_CLEAR(array)                                                                                 \
+    do {                                                                                                      \
+        if ((array).allocator) {                                                                              \
+            allocator_free((array).allocator, (array).data, (u64)(array).capacity * sizeof((array).data[0])); \
+        } else if ((array).data) {                                                                            \
+            mem_free((array).data);                                                                           \
+        }                                                                                                     \
+        (array).data = NULL;                                                                                  \
+        (array).count = 0;                                                                                    \
+        (array).capacity = 0;                                                                                 \
     } while (FALSE)
 
 /**
  * @brief Reserves a new capacity for the array.
  *
+ * The memory is resized in place when possible, and the slots past the count are left uninitialized. The array is left
+ * unchanged if its storage cannot be allocated.
+ *
  * @param [in] array The array to resize.
  * @param [in] capacity The new capacity of the array.
  */
-#define DYNARRAY_RESERVE(array, cap)                                                          \
-    do {                                                                                      \
-        if ((array).data) {                                                                   \
-            void *new_data = mem_alloc(MEMORY_TAG_DYNARRAY, (cap) * sizeof((array).data[0])); \
-            u64 copy_size = (array).count * sizeof((array).data[0]);                          \
-            mem_copy(new_data, (array).data, copy_size);                                      \
-            mem_zero(new_data + copy_size, (cap) * sizeof((array).data[0]) - copy_size);      \
-            mem_free((array).data);                                                           \
-            (array).data = new_data;                                                          \
-        } else {                                                                              \
-            (array).data = mem_alloc(MEMORY_TAG_DYNARRAY, (cap) * sizeof((array).data[0]));   \
-        }                                                                                     \
-        (array).capacity = (cap);                                                             \
+#define DYNARRAY_RESERVE(array, cap)                                                                   \
+    do {                                                                                               \
+        u64 reserve_capacity = (cap);                                                                  \
+        __typeof__((array).data) reserve_data;                                                         \
+        if ((array).allocator) {                                                                       \
+            reserve_data = allocator_reallocate((array).allocator,                                     \
+                                                (array).data,                                          \
+                                                (u64)(array).capacity * sizeof((array).data[0]),       \
+                                                reserve_capacity * sizeof((array).data[0]),            \
+                                                _Alignof(__typeof__((array).data[0])));                \
+        } else if ((array).data) {                                                                     \
+            reserve_data = mem_realloc((array).data, reserve_capacity * sizeof((array).data[0]));      \
+        } else {                                                                                       \
+            reserve_data = mem_alloc(MEMORY_TAG_DYNARRAY, reserve_capacity * sizeof((array).data[0])); \
+        }                                                                                              \
+        if (reserve_data != NULL) {                                                                    \
+            (array).data = reserve_data;                                                               \
+            (array).capacity = reserve_capacity;                                                       \
+        }                                                                                              \
+    } while (FALSE)
+
+/**
+ * @brief Makes room for at least the given number of elements, growing the capacity geometrically.
+ *
+ * @param [in] array The array to grow.
+ * @param [in] min_capacity The number of elements the array must be able to hold.
+ */
+#define DYNARRAY_GROW(array, min_capacity)                      \
+    do {                                                        \
+        if ((u64)(min_capacity) > (array).capacity) {           \
+            u64 grown_capacity = (u64)(array).capacity * 2 + 1; \
+            if (grown_capacity < (u64)(min_capacity)) {         \
+                grown_capacity = (min_capacity);                \
+            }                                                   \
+            DYNARRAY_RESERVE(array, grown_capacity);            \
+        }                                                       \
     } while (FALSE)
 
 /**
- * @brief Pushes a new element to the end of the array.
+ * @brief Pushes a new element to the end of the array. Nothing is pushed if the array cannot grow.
  *
  * @param [in] array The array to push the element to.
  * @param [in] element The element to push.
@@ -69,6 +115,198 @@
     do {                                                       \
         if ((array).count == (array).capacity) {               \
             DYNARRAY_RESERVE(array, (array).capacity * 2 + 1); \
+            if ((array).count == (array).capacity) {           \
+                break;                                         \
+            }                                                  \
         }                                                      \
         (array).data[(array).count++] = (element);             \
     } while (FALSE)
+
+/**
+ * @brief Pushes several elements to the end of the array, growing it at most once. Nothing is pushed if the array cannot grow.
+ *
+ * @param [in] array The array to push the elements to.
+ * @param [in] elements A pointer to the elements to push.
+ * @param [in] n The number of elements to push.
+ */
+#define DYNARRAY_PUSH_N(array, elements, n)                                                       \
+    do {                                                                                          \
+        u64 push_count = (n);                                                                     \
+        DYNARRAY_GROW(array, (array).count + push_count);                                         \
+        if ((array).capacity < (array).count + push_count) {                                      \
+            break;                                                                                \
+        }                                                                                         \
+        mem_copy((array).data + (array).count, (elements), push_count * sizeof((array).data[0])); \
+        (array).count += push_count;                                                              \
+    } while (FALSE)
+
+/**
+ * @brief Inserts an element at the given index, shifting the following elements. Nothing is inserted if the array cannot grow.
+ *
+ * @param [in] array The array to insert the element in.
+ * @param [in] index The index of the element once inserted (at most the count of the array).
+ * @param [in] element The element to insert.
+ */
+#define DYNARRAY_INSERT(array, index, element)                              \
+    do {                                                                    \
+        u64 insert_index = (index);                                         \
+        DYNARRAY_GROW(array, (array).count + 1);                            \
+        if ((array).count == (array).capacity) {                            \
+            break;                                                          \
+        }                                                                   \
+        mem_move((array).data + insert_index + 1,                           \
+                 (array).data + insert_index,                               \
+                 ((array).count - insert_index) * sizeof((array).data[0])); \
+        (array).data[insert_index] = (element);                             \
+        (array).count++;                                                    \
+    } while (FALSE)
+
+/**
+ * @brief Removes the element at the given index by moving the last element in its place. The order is not preserved.
+ *
+ * @param [in] array The array to remove the element from.
+ * @param [in] index The index of the element to remove.
+ */
+#define DYNARRAY_SWAP_REMOVE(array, index)                     \
+    do {                                                       \
+        (array).data[(index)] = (array).data[--(array).count]; \
+    } while (FALSE)
+
+/**
+ * @brief Sets the number of elements of the array, growing it if needed. The array is left unchanged if it cannot grow.
+ *
+ * @param [in] array The array to resize.
+ * @param [in] new_count The new number of elements.
+ * @param [in] zero Whether the added elements are zeroed. Otherwise they are left uninitialized.
+ */
+#define DYNARRAY_RESIZE(array, new_count, zero)                                                               \
+    do {                                                                                                      \
+        u64 resize_count = (new_count);                                                                       \
+        DYNARRAY_GROW(array, resize_count);                                                                   \
+        if ((array).capacity < resize_count) {                                                                \
+            break;                                                                                            \
+        }                                                                                                     \
+        if ((zero) && resize_count > (array).count) {                                                         \
+            mem_zero((array).data + (array).count, (resize_count - (array).count) * sizeof((array).data[0])); \
+        }                                                                                                     \
+        (array).count = resize_count;                                                                         \
+    } while (FALSE)
+
+/**
+ * @brief Reduces the capacity of the array to its count, freeing its memory if it is empty.
+ *
+ * @param [in] array The array to shrink.
+ */
+#define DYNARRAY_SHRINK_TO_FIT(array)                  \
+    do {                                               \
+        if ((array).count == 0) {                      \
+            DYNARRAY_CLEAR(array);                     \
+        } else if ((array).count < (array).capacity) { \
+            DYNARRAY_RESERVE(array, (array).count);    \
+        }                                              \
+    } while (FALSE)
+
+/**
+ * @brief Defines a dynamic array storing its first elements inline, for collections that are usually tiny.
+ *
+ * The elements live in the inline storage until it is full, then move to the heap (with the DYNARRAY tag): heap_data is NULL
+ * and capacity is 0 while they are inline. The array holds no pointer to itself, so it can be copied while the elements are
+ * inline. Elements are accessed through @ref SMALL_DYNARRAY_DATA.
+ *
+ * @param [in] type The type of the elements in the array.
+ * @param [in] n The number of elements stored inline.
+ */
+#define SMALL_DYNARRAY(type, n) \
+    struct {                    \
+        type *heap_data;        \
+        u32 count;              \
+        u32 capacity;           \
+        type inline_data[n];    \
+    }
+
+/**
+ * @brief Gets a pointer to the elements of a small dynamic array.
+ *
+ * @param [in] array The array.
+ */
+#define SMALL_DYNARRAY_DATA(array) ((array).heap_data != NULL ? (array).heap_data : (array).inline_data)
+
+/**
+ * @brief Gets the number of elements a small dynamic array can hold without growing.
+ *
+ * @param [in] array The array.
+ */
+#define SMALL_DYNARRAY_CAPACITY(array) \
+    ((array).heap_data != NULL ? (u64)(array).capacity : sizeof((array).inline_data) / sizeof((array).inline_data[0]))
+
+/**
+ * @brief Clears a small dynamic array, freeing its heap storage if it has one.
+ *
+ * @param [in] array The array to clear.
+ */
+#define SMALL_DYNARRAY_CLEAR(array)      \
+    do {                                 \
+        if ((array).heap_data) {         \
+            mem_free((array).heap_data); \
+        }                                \
+        (array).heap_data = NULL;        \
+        (array).count = 0;               \
+        (array).capacity = 0;            \
+    } while (FALSE)
+
+/**
+ * @brief Reserves a new capacity for a small dynamic array, moving its elements to the heap if they do not fit inline. The
+ * array is left unchanged if its storage cannot be allocated.
+ *
+ * @param [in] array The array to resize.
+ * @param [in] cap The new capacity of the array. Does nothing if it is not larger than the current one.
+ */
+#define SMALL_DYNARRAY_RESERVE(array, cap)                                                                       \
+    do {                                                                                                         \
+        u64 reserve_capacity = (cap);                                                                            \
+        if (reserve_capacity > SMALL_DYNARRAY_CAPACITY(array)) {                                                 \
+            u64 reserve_size = reserve_capacity * sizeof((array).inline_data[0]);                                \
+            __typeof__((array).heap_data) reserve_data;                                                          \
+            if ((array).heap_data) {                                                                             \
+                reserve_data = mem_realloc((array).heap_data, reserve_size);                                     \
+            } else {                                                                                             \
+                reserve_data = mem_alloc(MEMORY_TAG_DYNARRAY, reserve_size);                                     \
+                if (reserve_data != NULL) {                                                                      \
+                    mem_copy(reserve_data, (array).inline_data, (array).count * sizeof((array).inline_data[0])); \
+                }                                                                                                \
+            }                                                                                                    \
+            if (reserve_data != NULL) {                                                                          \
+                (array).heap_data = reserve_data;                                                                \
+                (array).capacity = reserve_capacity;                                                             \
+            }                                                                                                    \
+        }                                                                                                        \
+    } while (FALSE)
+
+/**
+ * @brief Pushes a new element to the end of a small dynamic array. Nothing is pushed if the array cannot grow.
+ *
+ * @param [in] array The array to push the element to.
+ * @param [in] element The element to push.
+ */
+#define SMALL_DYNARRAY_PUSH(array, element)                                    \
+    do {                                                                       \
+        if ((array).count == SMALL_DYNARRAY_CAPACITY(array)) {                 \
+            SMALL_DYNARRAY_RESERVE(array, SMALL_DYNARRAY_CAPACITY(array) * 2); \
+            if ((array).count == SMALL_DYNARRAY_CAPACITY(array)) {             \
+                break;                                                         \
+            }                                                                  \
+        }                                                                      \
+        SMALL_DYNARRAY_DATA(array)[(array).count++] = (element);               \
+    } while (FALSE)
+
+/**
+ * @brief Removes the element at the given index of a small dynamic array by moving the last element in its place. The order
+ * is not preserved.
+ *
+ * @param [in] array The array to remove the element from.
+ * @param [in] index The index of the element to remove.
+ */
+#define SMALL_DYNARRAY_SWAP_REMOVE(array, index)                                           \
+    do {                                                                                   \
+        SMALL_DYNARRAY_DATA(array)[(index)] = SMALL_DYNARRAY_DATA(array)[--(array).count]; \
+    } while (FALSE)
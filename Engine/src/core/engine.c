@@ -2,9 +2,11 @@
 #include "application.h"
 #include "core/event.h"
 #include "core/input.h"
+#include "core/job.h"
 #include "core/log.h"
 #include "core/memory.h"
 #include "core/plugins.h"
+#include "core/str_intern.h"
 #include "platform/platform.h"
 #include "renderer/renderer.h"
 
@@ -16,6 +18,8 @@ typedef struct engine_state {
     platform_system_state *platform_state;
     /** @brief The state of the logging system. */
     log_system_state *log_state;
+    /** @brief The state of the job system. */
+    job_system_state *job_state;
     /** @brief The state of the event system. */
     event_system_state *event_state;
     /** @brief The state of the input system. */
@@ -48,7 +52,17 @@ engine_state *state;
  */
 API b8 engine_early_init() {
     // Initialize the memory management system
-    if (!mem_init()) {
+    memory_config memory_config = {
+        .reserve_size = 16ull * 1024 * 1024 * 1024,
+        .frame_arena_size = 8 * 1024 * 1024,
+        .scratch_size = 64 * 1024 * 1024,
+        .profiler_sample_interval = 512 * 1024,
+        .profiler_max_stacks = 4096,
+        .profiler_output_path = NULL,
+        .huge_pages = TRUE,
+    };
+
+    if (!mem_init(&memory_config)) {
         LOG_ERROR("Failed to initialize the memory management system");
         return FALSE;
     }
@@ -97,6 +111,18 @@ b8 engine_init(application *app) {
         return FALSE;
     }
 
+    // Initializing job system
+    if (!job_system_init(NULL, &size_requirement)) {
+        LOG_ERROR("Failed to initialize the job system");
+        return FALSE;
+    }
+
+    state->job_state = mem_alloc(MEMORY_TAG_ENGINE, size_requirement);
+    if (!job_system_init(state->job_state, &size_requirement)) {
+        LOG_ERROR("Failed to initialize the job system");
+        return FALSE;
+    }
+
     // Initializing event system
     if (!event_init(NULL, &size_requirement)) {
         LOG_ERROR("Failed to initialize the event system");
@@ -111,6 +137,11 @@ b8 engine_init(application *app) {
 
     event_register_callback(EVENT_TYPE_WINDOW_RESIZED, on_window_resized, NULL, &state->on_window_resized_handler);
 
+    // Applying the memory budgets requested by the application, once their pressure events can be fired
+    for (u32 i = 0; i < MEMORY_TAG_MAX_TAGS; i++) {
+        mem_set_budget(i, app->memory_budgets[i].soft_limit, app->memory_budgets[i].hard_limit);
+    }
+
     // Initializing input system
     if (!input_init(NULL, &size_requirement)) {
         LOG_ERROR("Failed to initialize the input system");
@@ -203,6 +234,11 @@ void engine_deinit(struct application *app) {
         mem_free(state->event_state);
     }
 
+    if (state->job_state) {
+        job_system_deinit(state->job_state);
+        mem_free(state->job_state);
+    }
+
     if (state->log_state) {
         log_deinit(state->log_state);
         mem_free(state->log_state);
@@ -216,6 +252,9 @@ void engine_deinit(struct application *app) {
     // Free engine state
     mem_free(state);
 
+    // Free the interned strings, which live until the end
+    str_intern_deinit();
+
     // Deinitialize the memory management system, reporting any leaks in the process
     mem_deinit();
 
@@ -239,6 +278,9 @@ b8 engine_run(struct application *app) {
             break;
         }
 
+        // Everything allocated with mem_frame_alloc two frames ago is released here
+        mem_frame_begin();
+
         f64 current_time = platform_get_time();
         f32 delta_time = (f32)(current_time - last_time);
         last_time = current_time;
@@ -1,6 +1,6 @@
 #include "event.h"
-#include "core/dynamic_array.h"
 #include "core/log.h"
+#include "core/slot_map.h"
 
 typedef struct event_callback_entry {
     event_callback callback;
@@ -8,7 +8,12 @@ typedef struct event_callback_entry {
 } event_callback_entry;
 
 struct event_system_state {
-    DYNARRAY(event_callback_entry) callbacks[EVENT_TYPE_MAX_EVENTS];
+    /** @brief The callbacks of each event type (of @ref event_callback_entry), in registration order. */
+    slot_map callbacks[EVENT_TYPE_MAX_EVENTS];
+    /** @brief The number of nested fires in progress of each event type. */
+    u32 firing_depth[EVENT_TYPE_MAX_EVENTS];
+    /** @brief Whether callbacks of each event type were unregistered while firing, and wait to be removed. */
+    b8 removal_pending[EVENT_TYPE_MAX_EVENTS];
 };
 
 static event_system_state *state = NULL;
@@ -32,9 +37,8 @@ b8 event_init(event_system_state *state_storage, u64 *size_requirement) {
 
     state = (event_system_state *)state_storage;
     mem_zero(state, sizeof(event_system_state));
-
     for (u32 i = 0; i < EVENT_TYPE_MAX_EVENTS; i++) {
-        DYNARRAY_RESERVE(state->callbacks[i], 32);
+        slot_map_init(&state->callbacks[i], sizeof(event_callback_entry), 0, NULL);
     }
 
     return TRUE;
@@ -49,11 +53,12 @@ void event_deinit(event_system_state *state) {
     if (state != NULL) {
         for (u32 i = 0; i < EVENT_TYPE_MAX_EVENTS; i++) {
             for (u32 j = 0; j < state->callbacks[i].count; j++) {
-                if (state->callbacks[i].data[j].callback) {
-                    LOG_WARN("Unregistered callback left in event system: 0x%p", state->callbacks[i].data[j].callback);
+                event_callback_entry *entry = SLOT_MAP_AT(state->callbacks[i], event_callback_entry, j);
+                if (entry->callback != NULL) {
+                    LOG_WARN("Unregistered callback left in event system: 0x%p", entry->callback);
                 }
             }
-            DYNARRAY_CLEAR(state->callbacks[i]);
+            slot_map_destroy(&state->callbacks[i]);
         }
         mem_zero(state, sizeof(event_system_state));
     }
@@ -77,17 +82,10 @@ b8 event_register_callback(event_type type, event_callback callback, void *user_
         return FALSE;
     }
 
-    *result = INVALID_UUID;
-    for (u32 i = 0; i < state->callbacks[type].count; i++) {
-        if (state->callbacks[type].data[i].callback == NULL) {
-            *result = i;
-        }
-    }
-
-    if (*result == INVALID_UUID) {
-        *result = state->callbacks[type].count;
-        event_callback_entry entry = { .callback = callback, .user_data = user_data };
-        DYNARRAY_PUSH(state->callbacks[type], entry);
+    event_callback_entry entry = { .callback = callback, .user_data = user_data };
+    if (!slot_map_insert(&state->callbacks[type], &entry, result)) {
+        *result = INVALID_UUID;
+        return FALSE;
     }
 
     return TRUE;
@@ -100,15 +98,26 @@ b8 event_register_callback(event_type type, event_callback callback, void *user_
  * @param[in] uuid The UUID of the callback to unregister.
  *
  * @retval TRUE Success
- * @retval FALSE Failure
+ * @retval FALSE Failure (the UUID is invalid, or its callback was already unregistered)
  */
 b8 event_unregister_callback(event_type type, uuid uuid) {
-    if (state == NULL || type >= EVENT_TYPE_MAX_EVENTS || uuid >= state->callbacks[type].count) {
+    if (state == NULL || type >= EVENT_TYPE_MAX_EVENTS) {
         return FALSE;
     }
 
-    state->callbacks[type].data[uuid].callback = NULL;
-    return TRUE;
+    // While the event fires, only clear the callback: removing it would shift the callbacks not called yet
+    if (state->firing_depth[type] > 0) {
+        event_callback_entry *entry = slot_map_get(&state->callbacks[type], uuid);
+        if (entry == NULL || entry->callback == NULL) {
+            return FALSE;
+        }
+
+        entry->callback = NULL;
+        state->removal_pending[type] = TRUE;
+        return TRUE;
+    }
+
+    return slot_map_remove_ordered(&state->callbacks[type], uuid);
 }
 
 /**
@@ -125,9 +134,26 @@ b8 event_fire(event_type type, event_data data) {
         return FALSE;
     }
 
-    for (u32 i = 0; i < state->callbacks[type].count; i++) {
-        if (state->callbacks[type].data[i].callback != NULL) {
-            state->callbacks[type].data[i].callback(type, data, state->callbacks[type].data[i].user_data);
+    // Callbacks unregistered while firing stay in place until the outermost fire ends, and the callbacks registered while
+    // firing (appended after the count read here) are not called
+    slot_map *callbacks = &state->callbacks[type];
+    u32 count = callbacks->count;
+    state->firing_depth[type]++;
+    for (u32 i = 0; i < count; i++) {
+        // Copy the entry, as a register from the callback may move the storage
+        event_callback_entry entry = *SLOT_MAP_AT(*callbacks, event_callback_entry, i);
+        if (entry.callback != NULL) {
+            entry.callback(type, data, entry.user_data);
+        }
+    }
+    state->firing_depth[type]--;
+
+    if (state->firing_depth[type] == 0 && state->removal_pending[type]) {
+        state->removal_pending[type] = FALSE;
+        for (u32 i = callbacks->count; i > 0; i--) {
+            if (SLOT_MAP_AT(*callbacks, event_callback_entry, i - 1)->callback == NULL) {
+                slot_map_remove_ordered(callbacks, slot_map_handle_at(callbacks, i - 1));
+            }
         }
     }
 
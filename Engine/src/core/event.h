@@ -88,6 +88,14 @@ typedef enum event_type {
      */
     EVENT_TYPE_WINDOW_RESIZED,
 
+    /**
+     * @brief Event fired when the memory allocated in a tag crosses its soft budget (see @ref mem_set_budget). It is fired
+     * at the beginning of the frame following the crossing, and again only after the usage went back under the soft budget.
+     * Caches should evict what they can.
+     * The @ref event_data used is @ref event_data.u32 (the @ref memory_tag under pressure)
+     */
+    EVENT_TYPE_MEMORY_PRESSURE,
+
     /**
      * @brief Events used by the engine for debug purposes.
      * The @ref event_data used may vary.
@@ -175,12 +183,15 @@ API b8 event_register_callback(event_type type, event_callback callback, void *u
  * @param[in] uuid The UUID of the callback to unregister.
  * 
  * @retval TRUE Success
- * @retval FALSE Failure
+ * @retval FALSE Failure (the UUID is invalid, or its callback was already unregistered)
  */
 API b8 event_unregister_callback(event_type type, uuid uuid);
 
 /**
  * @brief Fires an event.
+ *
+ * The callbacks are called in registration order. A callback may register or unregister callbacks of the event: those
+ * registered while firing are not called, and those unregistered are not called anymore.
  * 
  * @param[in] type The type of the event.
  * @param[in] data The data of the event.
@@ -0,0 +1,123 @@
+#include "hash.h"
+#include <string.h>
+
+// FNV-1a (https://en.wikipedia.org/wiki/Fowler%E2%80%93Noll%E2%80%93Vo_hash_function)
+#define FNV_PRIME 0x100000001b3
+#define FNV_OFFSET_BASIS 0xcbf29ce484222325
+
+API u64 hash_fnv1a(const void *data, u64 size) {
+    const u8 *bytes = data;
+
+    u64 hash = FNV_OFFSET_BASIS;
+    for (u64 i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+// wyhash, final version 4 (https://github.com/wangyi-fudan/wyhash), with its default secret and a seed of 0
+
+static const u64 WYHASH_SECRET[4] = { 0x2d358dccaa6c78a5, 0x8bb84b93962eacc9, 0x4b33a62ed433d4a3, 0x4d5a2da51de1aa47 };
+
+/** @brief Multiplies two 64 bits integers, storing the low half of the result in a and the high half in b. */
+static inline void wyhash_multiply(u64 *a, u64 *b) {
+    __uint128_t result = (__uint128_t)*a * *b;
+    *a = (u64)result;
+    *b = (u64)(result >> 64);
+}
+
+static inline u64 wyhash_mix(u64 a, u64 b) {
+    wyhash_multiply(&a, &b);
+    return a ^ b;
+}
+
+// Unaligned little-endian reads, which compile to a single load
+static inline u64 wyhash_read8(const u8 *p) {
+    u64 value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static inline u64 wyhash_read4(const u8 *p) {
+    u32 value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+/** @brief Reads 1 to 3 bytes: the first, the middle and the last one. */
+static inline u64 wyhash_read3(const u8 *p, u64 size) { return ((u64)p[0] << 16) | ((u64)p[size >> 1] << 8) | p[size - 1]; }
+
+API u64 hash_wyhash(const void *data, u64 size) {
+    const u8 *p = data;
+    u64 seed = wyhash_mix(WYHASH_SECRET[0], WYHASH_SECRET[1]);
+    u64 a;
+    u64 b;
+
+    if (__builtin_expect(size <= 16, 1)) {
+        if (__builtin_expect(size >= 4, 1)) {
+            // Two pairs of overlapping 4 bytes reads cover the whole key
+            a = (wyhash_read4(p) << 32) | wyhash_read4(p + ((size >> 3) << 2));
+            b = (wyhash_read4(p + size - 4) << 32) | wyhash_read4(p + size - 4 - ((size >> 3) << 2));
+        } else if (__builtin_expect(size > 0, 1)) {
+            a = wyhash_read3(p, size);
+            b = 0;
+        } else {
+            a = 0;
+            b = 0;
+        }
+    } else {
+        u64 remaining = size;
+
+        if (__builtin_expect(remaining >= 48, 0)) {
+            // Three independent lanes, so that the multiplications are pipelined
+            u64 seed1 = seed;
+            u64 seed2 = seed;
+            do {
+                seed = wyhash_mix(wyhash_read8(p) ^ WYHASH_SECRET[1], wyhash_read8(p + 8) ^ seed);
+                seed1 = wyhash_mix(wyhash_read8(p + 16) ^ WYHASH_SECRET[2], wyhash_read8(p + 24) ^ seed1);
+                seed2 = wyhash_mix(wyhash_read8(p + 32) ^ WYHASH_SECRET[3], wyhash_read8(p + 40) ^ seed2);
+                p += 48;
+                remaining -= 48;
+            } while (__builtin_expect(remaining >= 48, 1));
+            seed ^= seed1 ^ seed2;
+        }
+
+        while (__builtin_expect(remaining > 16, 0)) {
+            seed = wyhash_mix(wyhash_read8(p) ^ WYHASH_SECRET[1], wyhash_read8(p + 8) ^ seed);
+            p += 16;
+            remaining -= 16;
+        }
+
+        // The last 16 bytes of the key, overlapping the previous ones if needed
+        a = wyhash_read8(p + remaining - 16);
+        b = wyhash_read8(p + remaining - 8);
+    }
+
+    a ^= WYHASH_SECRET[1];
+    b ^= seed;
+    wyhash_multiply(&a, &b);
+    return wyhash_mix(a ^ WYHASH_SECRET[0] ^ size, b ^ WYHASH_SECRET[1]);
+}
+
+API u64 hash_bytes(const void *data, u64 size) {
+#if HASH_FUNCTION == HASH_FUNCTION_FNV1A
+    return hash_fnv1a(data, size);
+#else
+    return hash_wyhash(data, size);
+#endif
+}
+
+API u64 hash(const char *key) {
+#if HASH_FUNCTION == HASH_FUNCTION_FNV1A
+    // No need to measure the string first
+    u64 hash = FNV_OFFSET_BASIS;
+    for (u64 i = 0; key[i] != '\0'; i++) {
+        hash ^= (u8)key[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+#else
+    return hash_wyhash(key, strlen(key));
+#endif
+}
@@ -0,0 +1,99 @@
+/**
+ * @file hash.h
+ * @author Killian Bellouard (killianbellouard@gmail.com)
+ * @brief This file defines the hash functions shared by the hash tables.
+ *
+ * Two hash functions are available:
+ * - FNV-1a, which processes one byte per iteration.
+ * - wyhash (https://github.com/wangyi-fudan/wyhash), which processes 16 to 48 bytes per iteration with 64x64->128 bits
+ *   multiplications, and reads short keys with a few overlapping loads instead of a loop.
+ *
+ * The one used by @ref hash, @ref hash_bytes and @ref hash_str_view (so by every hash table, the typed hash maps and the string
+ * interner) is selected at compile time with HASH_FUNCTION, and defaults to wyhash.
+ *
+ * @note Hashes are only meant for in-memory tables: they differ between hash functions, so they must not be persisted.
+ * @version 0.1
+ * @date 2024-08-14
+ */
+
+#pragma once
+
+#include "common.h"
+#include "core/str.h"
+
+#define HASH_FUNCTION_FNV1A 0
+#define HASH_FUNCTION_WYHASH 1
+
+#ifndef HASH_FUNCTION
+/** @brief The hash function used by the engine, HASH_FUNCTION_FNV1A or HASH_FUNCTION_WYHASH. */
+#define HASH_FUNCTION HASH_FUNCTION_WYHASH
+#endif
+
+/**
+ * @brief Hashes a sequence of bytes with FNV-1a.
+ *
+ * @param[in] data The bytes to hash.
+ * @param[in] size The number of bytes.
+ *
+ * @return The hash of the bytes.
+ */
+API u64 hash_fnv1a(const void *data, u64 size);
+
+/**
+ * @brief Hashes a sequence of bytes with wyhash.
+ *
+ * @param[in] data The bytes to hash.
+ * @param[in] size The number of bytes.
+ *
+ * @return The hash of the bytes.
+ */
+API u64 hash_wyhash(const void *data, u64 size);
+
+/**
+ * @brief Hashes a sequence of bytes with the hash function of the engine.
+ *
+ * @param[in] data The bytes to hash.
+ * @param[in] size The number of bytes.
+ *
+ * @return The hash of the bytes.
+ */
+API u64 hash_bytes(const void *data, u64 size);
+
+/**
+ * @brief Hashes a null-terminated string with the hash function of the engine.
+ *
+ * @note The hash of a string is the same as the hash of its bytes. Prefer @ref hash_str_view when the length is known.
+ *
+ * @param[in] key The string to hash.
+ *
+ * @return The hash of the string.
+ */
+API u64 hash(const char *key);
+
+/**
+ * @brief Hashes a string view with the hash function of the engine.
+ *
+ * @param[in] view The string to hash.
+ *
+ * @return The hash of the string.
+ */
+static inline u64 hash_str_view(str_view view) { return hash_bytes(view.begin, view.size); }
+
+/**
+ * @brief Hashes a 64 bits integer, with the finalizer of MurmurHash3.
+ *
+ * Every bit of the key affects every bit of the hash, so that keys differing only in their low bits (like indices) or high bits
+ * (like aligned pointers) spread over the whole table.
+ *
+ * @param[in] key The integer to hash.
+ *
+ * @return The hash of the integer.
+ */
+static inline u64 hash_u64(u64 key) {
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccd;
+    key ^= key >> 33;
+    key *= 0xc4ceb9fe1a85ec53;
+    key ^= key >> 33;
+    return key;
+}
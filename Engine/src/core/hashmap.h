@@ -0,0 +1,310 @@
+/**
+ * @file hashmap.h
+ * @author Killian Bellouard (killianbellouard@gmail.com)
+ * @brief This files defines the macros and types of the typed hash map.
+ *
+ * A hash map is declared with its key and value types, like a dynamic array, and its operations are macros expanded for these
+ * types: keys and values are assigned instead of copied with mem_copy, and the hash and comparison of the keys are inlined.
+ * Keys can be integers, pointers, strings (char * or const char *) or interned strings (str_id). String keys are not duplicated,
+ * so they must outlive the map. Interned strings are the fastest string keys: their hash is precomputed and they are compared
+ * by address. The map probes groups of slots at once, like the swiss hashtable.
+ *
+ * A zero-initialized map is empty and allocates on its first insert:
+ * @code
+ * HASHMAP(u64, object *) objects = {};
+ * HASHMAP_SET(objects, id, object);
+ *
+ * object **found;
+ * HASHMAP_GET(objects, id, found);
+ *
+ * HASHMAP_FOR_EACH(objects, i) {
+ *     LOG_INFO("%llu", objects.keys[i]);
+ * }
+ *
+ * HASHMAP_CLEAR(objects);
+ * @endcode
+ * @version 0.1
+ * @date 2024-08-15
+ */
+
+#pragma once
+
+#include "common.h"
+#include "core/hash.h"
+#include "core/hashtable_group.h"
+#include "core/str_intern.h"
+#include "memory.h"
+
+/**
+ * @brief Defines a hash map.
+ *
+ * @param [in] key_type The type of the keys.
+ * @param [in] value_type The type of the values.
+ */
+#define HASHMAP(key_type, value_type) \
+    struct {                          \
+        i8 *control;                  \
+        key_type *keys;               \
+        value_type *values;           \
+        u32 capacity;                 \
+        u32 count;                    \
+        u32 growth_left;              \
+    }
+
+static inline b8 _hashmap_str_eq(const char *a, const char *b) {
+    while (*a != '\0' && *a == *b) {
+        a++;
+        b++;
+    }
+    return *a == *b;
+}
+
+static inline u64 _hashmap_hash_pointer(const void *key) { return hash_u64((u64)(uintptr_t)key); }
+
+static inline u64 _hashmap_hash_str_id(str_id key) { return key->hash; }
+
+/**
+ * @brief Hashes a key of a hash map.
+ *
+ * @param [in] key The key to hash.
+ */
+#define HASHMAP_HASH(key)                    \
+    _Generic((key),                          \
+        char *: hash,                        \
+        const char *: hash,                  \
+        void *: _hashmap_hash_pointer,       \
+        const void *: _hashmap_hash_pointer, \
+        str_id: _hashmap_hash_str_id,        \
+        default: hash_u64)(key)
+
+/**
+ * @brief Compares two keys of a hash map.
+ *
+ * @param [in] a The first key.
+ * @param [in] b The second key.
+ */
+#define HASHMAP_KEY_EQ(a, b)                                                                       \
+    _Generic((a),                                                                                  \
+        char *: _hashmap_str_eq((const char *)(uintptr_t)(a), (const char *)(uintptr_t)(b)),       \
+        const char *: _hashmap_str_eq((const char *)(uintptr_t)(a), (const char *)(uintptr_t)(b)), \
+        default: (a) == (b))
+
+/** @brief Allocates the control bytes, keys and values of a map in one block, and returns the control bytes (or NULL). */
+static inline i8 *_hashmap_allocate(
+    u32 capacity, u64 key_size, u64 key_alignment, u64 value_size, u64 value_alignment, void **keys, void **values) {
+    u64 keys_offset = (capacity + key_alignment - 1) & ~(key_alignment - 1);
+    u64 values_offset = (keys_offset + capacity * key_size + value_alignment - 1) & ~(value_alignment - 1);
+    u64 alignment = key_alignment > value_alignment ? key_alignment : value_alignment;
+
+    u8 *block = mem_alloc_aligned(MEMORY_TAG_HASHTABLE,
+                                  values_offset + capacity * value_size,
+                                  alignment > HASHTABLE_GROUP_SIZE ? alignment : HASHTABLE_GROUP_SIZE);
+    if (block == NULL) {
+        return NULL;
+    }
+
+    mem_set(block, (u8)HASHTABLE_CONTROL_EMPTY, capacity);
+
+    *keys = block + keys_offset;
+    *values = block + values_offset;
+    return (i8 *)block;
+}
+
+/**
+ * @brief Rebuilds a map with the given capacity (a power of two, at least the group size), dropping the deleted slots. The map is
+ * left unchanged if the new storage cannot be allocated.
+ *
+ * @param [in] map The map to rebuild.
+ * @param [in] new_capacity The new capacity of the map.
+ */
+#define _HASHMAP_REBUILD(map, new_capacity)                                                                  \
+    do {                                                                                                     \
+        __typeof__(map) _rebuilt = {};                                                                       \
+        _rebuilt.capacity = (new_capacity);                                                                  \
+        _rebuilt.count = (map).count;                                                                        \
+        _rebuilt.growth_left = hashtable_group_max_entries(_rebuilt.capacity) - _rebuilt.count;              \
+        _rebuilt.control = _hashmap_allocate(_rebuilt.capacity,                                              \
+                                             sizeof((map).keys[0]),                                          \
+                                             _Alignof(__typeof__((map).keys[0])),                            \
+                                             sizeof((map).values[0]),                                        \
+                                             _Alignof(__typeof__((map).values[0])),                          \
+                                             (void **)&_rebuilt.keys,                                        \
+                                             (void **)&_rebuilt.values);                                     \
+        if (_rebuilt.control == NULL) {                                                                      \
+            break;                                                                                           \
+        }                                                                                                    \
+        for (u32 _i = 0; _i < (map).capacity; _i++) {                                                        \
+            if ((map).control[_i] >= 0) {                                                                    \
+                u64 _slot_hash = HASHMAP_HASH((map).keys[_i]);                                               \
+                u64 _slot = hashtable_group_find_free_slot(_rebuilt.control, _rebuilt.capacity, _slot_hash); \
+                _rebuilt.control[_slot] = HASHTABLE_H2(_slot_hash);                                          \
+                _rebuilt.keys[_slot] = (map).keys[_i];                                                       \
+                _rebuilt.values[_slot] = (map).values[_i];                                                   \
+            }                                                                                                \
+        }                                                                                                    \
+        if ((map).control) {                                                                                 \
+            mem_free((map).control);                                                                         \
+        }                                                                                                    \
+        (map) = _rebuilt;                                                                                    \
+    } while (FALSE)
+
+/**
+ * @brief Finds the slot of a key in a map.
+ *
+ * @param [in] map The map to search.
+ * @param [in] key The key to find.
+ * @param [in] key_hash The hash of the key.
+ * @param [out] index The index of the slot (an i64), or -1 if the key is not in the map.
+ */
+#define _HASHMAP_FIND(map, key, key_hash, index)                                                 \
+    do {                                                                                         \
+        (index) = -1;                                                                            \
+        if ((map).capacity == 0) {                                                               \
+            break;                                                                               \
+        }                                                                                        \
+        u64 _group_mask = (map).capacity / HASHTABLE_GROUP_SIZE - 1;                             \
+        u64 _group = HASHTABLE_H1(key_hash) & _group_mask;                                       \
+        for (u64 _step = 1;; _step++) {                                                          \
+            const i8 *_control = (map).control + _group * HASHTABLE_GROUP_SIZE;                  \
+            u32 _matches = hashtable_group_match(_control, HASHTABLE_H2(key_hash));              \
+            while (_matches != 0) {                                                              \
+                u64 _candidate = _group * HASHTABLE_GROUP_SIZE + __builtin_ctz(_matches);        \
+                if (HASHMAP_KEY_EQ((map).keys[_candidate], key)) {                               \
+                    (index) = _candidate;                                                        \
+                    break;                                                                       \
+                }                                                                                \
+                _matches &= _matches - 1;                                                        \
+            }                                                                                    \
+            if ((index) >= 0 || hashtable_group_match(_control, HASHTABLE_CONTROL_EMPTY) != 0) { \
+                break;                                                                           \
+            }                                                                                    \
+            _group = (_group + _step) & _group_mask;                                             \
+        }                                                                                        \
+    } while (FALSE)
+
+/**
+ * @brief Reserves room for the given number of entries in a map. The map is left unchanged if the storage cannot be allocated.
+ *
+ * @param [in] map The map to resize.
+ * @param [in] entry_count The number of entries the map must hold without growing.
+ */
+#define HASHMAP_RESERVE(map, entry_count)                                       \
+    do {                                                                        \
+        u32 _capacity = (map).capacity ? (map).capacity : HASHTABLE_GROUP_SIZE; \
+        while (hashtable_group_max_entries(_capacity) < (entry_count)) {        \
+            _capacity *= 2;                                                     \
+        }                                                                       \
+        if (_capacity != (map).capacity) {                                      \
+            _HASHMAP_REBUILD(map, _capacity);                                   \
+        }                                                                       \
+    } while (FALSE)
+
+/**
+ * @brief Sets the value of a key in a map, inserting the key if it is not in the map yet.
+ *
+ * @note If the map must grow and its storage cannot be allocated, the key is not inserted (the count of the map is unchanged).
+ *
+ * @param [in] map The map to set the value in.
+ * @param [in] key The key.
+ * @param [in] value The value.
+ */
+#define HASHMAP_SET(map, key, value)                                                                        \
+    do {                                                                                                    \
+        __typeof__((map).keys[0]) _key = (key);                                                             \
+        u64 _hash = HASHMAP_HASH(_key);                                                                     \
+        i64 _index;                                                                                         \
+        _HASHMAP_FIND(map, _key, _hash, _index);                                                            \
+        if (_index < 0) {                                                                                   \
+            if ((map).capacity == 0) {                                                                      \
+                _HASHMAP_REBUILD(map, HASHTABLE_GROUP_SIZE);                                                \
+                if ((map).capacity == 0) {                                                                  \
+                    break;                                                                                  \
+                }                                                                                           \
+            }                                                                                               \
+            _index = hashtable_group_find_free_slot((map).control, (map).capacity, _hash);                  \
+            if ((map).control[_index] == HASHTABLE_CONTROL_EMPTY && (map).growth_left == 0) {               \
+                /* Only grow if the live entries need it, otherwise dropping the deleted slots is enough */ \
+                b8 _grow = (map).count + 1 > hashtable_group_max_entries((map).capacity) / 2;               \
+                _HASHMAP_REBUILD(map, _grow ? (map).capacity * 2 : (map).capacity);                         \
+                if ((map).growth_left == 0) {                                                               \
+                    /* The rebuild failed, a successful one always leaves room */                           \
+                    break;                                                                                  \
+                }                                                                                           \
+                _index = hashtable_group_find_free_slot((map).control, (map).capacity, _hash);              \
+            }                                                                                               \
+            if ((map).control[_index] == HASHTABLE_CONTROL_EMPTY) {                                         \
+                (map).growth_left--;                                                                        \
+            }                                                                                               \
+            (map).control[_index] = HASHTABLE_H2(_hash);                                                    \
+            (map).keys[_index] = _key;                                                                      \
+            (map).count++;                                                                                  \
+        }                                                                                                   \
+        (map).values[_index] = (value);                                                                     \
+    } while (FALSE)
+
+/**
+ * @brief Gets a pointer to the value of a key in a map.
+ *
+ * @note The pointer is invalidated by the next insertion.
+ *
+ * @param [in] map The map to get the value from.
+ * @param [in] key The key.
+ * @param [out] value_pointer The pointer to the value, or NULL if the key is not in the map.
+ */
+#define HASHMAP_GET(map, key, value_pointer)                          \
+    do {                                                              \
+        __typeof__((map).keys[0]) _key = (key);                       \
+        i64 _index;                                                   \
+        _HASHMAP_FIND(map, _key, HASHMAP_HASH(_key), _index);         \
+        (value_pointer) = _index >= 0 ? &(map).values[_index] : NULL; \
+    } while (FALSE)
+
+/**
+ * @brief Removes a key from a map, if it is in the map.
+ *
+ * @param [in] map The map to remove the key from.
+ * @param [in] key The key.
+ */
+#define HASHMAP_REMOVE(map, key)                                    \
+    do {                                                            \
+        __typeof__((map).keys[0]) _key = (key);                     \
+        i64 _index;                                                 \
+        _HASHMAP_FIND(map, _key, HASHMAP_HASH(_key), _index);       \
+        if (_index >= 0) {                                          \
+            (map).count--;                                          \
+            if (hashtable_group_free_slot((map).control, _index)) { \
+                (map).growth_left++;                                \
+            }                                                       \
+        }                                                           \
+    } while (FALSE)
+
+/**
+ * @brief Iterates over the entries of a map, in no particular order. The key and value of the entry are (map).keys[index] and
+ * (map).values[index].
+ *
+ * @warning The map must not be modified during the iteration, except to remove the current entry.
+ *
+ * @param [in] map The map to iterate over.
+ * @param [in] index The name of the index variable.
+ */
+#define HASHMAP_FOR_EACH(map, index)                     \
+    for (u32 index = 0; index < (map).capacity; index++) \
+        if ((map).control[index] >= 0)
+
+/**
+ * @brief Clears a hash map, freeing its memory.
+ *
+ * @param [in] map The map to clear.
+ */
+#define HASHMAP_CLEAR(map)           \
+    do {                             \
+        if ((map).control) {         \
+            mem_free((map).control); \
+        }                            \
+        (map).control = NULL;        \
+        (map).keys = NULL;           \
+        (map).values = NULL;         \
+        (map).capacity = 0;          \
+        (map).count = 0;             \
+        (map).growth_left = 0;       \
+    } while (FALSE)
@@ -1,163 +1,234 @@
 #include "hashtable.h"
+#include "core/hash.h"
 #include "core/str.h"
+#include "math/math.h"
 #include "memory.h"
 
 #define LOG_SCOPE "HASHTABLE"
 #include "core/log.h"
 
-// FNV-1a (https://en.wikipedia.org/wiki/Fowler%E2%80%93Noll%E2%80%93Vo_hash_function)
-u64 hash(const char *key) {
-    const u64 FNV_PRIME = 0x100000001b3;
-    const u64 FNV_OFFSET_BASIS = 0xcbf29ce484222325;
+/** @brief The smallest capacity of a table. */
+#define MIN_CAPACITY 8
 
-    u64 hash = FNV_OFFSET_BASIS;
-    for (u64 i = 0; key[i] != '\0'; i++) {
-        hash ^= key[i];
-        hash *= FNV_PRIME;
-    }
-    return hash;
-}
+/** @brief The maximum ratio (in percents) of slots holding an entry or a tombstone, before the table is rebuilt. */
+#define MAX_LOAD_FACTOR 75
+
+/** @brief The key of a removed entry. Lookups probe past it, inserts may reuse it. */
+#define TOMBSTONE ((char *)1)
 
+/** @brief The header of a slot, followed by its value. */
 typedef struct hashtable_entry_header {
-    b8 present;
+    /** @brief The key of the entry, NULL if the slot has never been used, or TOMBSTONE if its entry was removed. */
     char *key;
+    /** @brief The hash of the key, kept to skip most key comparisons and to rehash without hashing again. */
+    u64 hash;
 } hashtable_entry_header;
 
+static inline u64 entry_stride(const hashtable *table) {
+    return ALIGN_UP(sizeof(hashtable_entry_header) + table->element_size, _Alignof(hashtable_entry_header));
+}
+
+static inline hashtable_entry_header *entry_at(const hashtable *table, u64 index) {
+    return (hashtable_entry_header *)((u8 *)table->data + index * entry_stride(table));
+}
+
+static inline b8 entry_is_live(const hashtable_entry_header *header) {
+    return header->key != NULL && header->key != TOMBSTONE;
+}
+
+static void entry_write_value(const hashtable *table, hashtable_entry_header *header, void *value) {
+    if (table->pointers) {
+        *(void **)(header + 1) = value;
+    } else {
+        mem_copy(header + 1, value, table->element_size);
+    }
+}
+
+/** @brief Copies a key with the allocator of the table. */
+static char *key_copy(const hashtable *table, const char *key) {
+    u64 size = str_len(key) + 1;
+    char *copy = allocator_allocate(table->allocator, size, 1);
+    if (copy != NULL) {
+        mem_copy(copy, key, size);
+    }
+
+    return copy;
+}
+
+static void key_free(const hashtable *table, char *key) { allocator_free(table->allocator, key, str_len(key) + 1); }
+
+/** @brief Finds the slot holding the given key, or returns NULL if the key is not in the table. */
+static hashtable_entry_header *find_entry(const hashtable *table, const char *key, u64 key_hash) {
+    u64 mask = table->capacity - 1;
+
+    // The load factor guarantees that there is an empty slot ending the probe sequence
+    for (u64 index = key_hash & mask;; index = (index + 1) & mask) {
+        hashtable_entry_header *header = entry_at(table, index);
+
+        if (header->key == NULL) {
+            return NULL;
+        }
+
+        if (header->key != TOMBSTONE && header->hash == key_hash && str_eq(header->key, key)) {
+            return header;
+        }
+    }
+}
+
+/** @brief Rebuilds the table with the given capacity (a power of two), dropping the tombstones. */
 static b8 resize_hashtable(hashtable *table, u32 new_capacity) {
     hashtable copy = *table;
 
-    table->data = mem_alloc(MEMORY_TAG_HASHTABLE, new_capacity * (table->element_size + sizeof(hashtable_entry_header)));
-    mem_zero(table->data, new_capacity * (table->element_size + sizeof(hashtable_entry_header)));
+    table->data = allocator_allocate(table->allocator, new_capacity * entry_stride(table), _Alignof(hashtable_entry_header));
+    if (table->data == NULL) {
+        LOG_ERROR("Failed to allocate %u entries", new_capacity);
+        *table = copy;
+        return FALSE;
+    }
+
+    mem_zero(table->data, new_capacity * entry_stride(table));
     table->capacity = new_capacity;
+    table->tombstone_count = 0;
 
-    // Rehashing
+    // Keys are unique and there are no tombstones yet, so entries go to the first empty slot of their probe sequence
+    u64 mask = new_capacity - 1;
     for (u32 i = 0; i < copy.capacity; i++) {
-        hashtable_entry_header *header =
-            (hashtable_entry_header *)(copy.data + (i * (table->element_size + sizeof(hashtable_entry_header))));
-
-        if (header->present) {
-            // Need to transfer it over
-            u64 index = hash(header->key) % table->capacity;
-            u64 offset = (index * (table->element_size + sizeof(hashtable_entry_header)));
-            hashtable_entry_header *new_header = (hashtable_entry_header *)(table->data + offset);
-
-            if (new_header->present) {
-                LOG_WARN(
-                    "Hash key collision while rehashing: %s and %s (%d entries)", new_header->key, header->key, table->capacity);
-                mem_free(table->data);
-                *table = copy;
-                return FALSE;
-            }
+        hashtable_entry_header *header = entry_at(&copy, i);
+        if (!entry_is_live(header)) {
+            continue;
+        }
 
-            new_header->present = TRUE;
-            new_header->key = header->key;
-            mem_copy(new_header + sizeof(hashtable_entry_header), header + sizeof(hashtable_entry_header), table->element_size);
+        u64 index = header->hash & mask;
+        while (entry_at(table, index)->key != NULL) {
+            index = (index + 1) & mask;
         }
+
+        mem_copy(entry_at(table, index), header, entry_stride(table));
     }
 
-    mem_free(copy.data);
+    allocator_free(table->allocator, copy.data, copy.capacity * entry_stride(&copy));
     return TRUE;
 }
 
-API void hashtable_init(hashtable *hashtable, u32 element_size, u32 initial_capacity, b8 pointers) {
-    hashtable->element_size = element_size;
-    hashtable->capacity = initial_capacity;
+API b8 hashtable_init(hashtable *hashtable, u32 element_size, u32 initial_capacity, b8 pointers, const allocator *allocator) {
+    u32 capacity = MIN_CAPACITY;
+    while (capacity < initial_capacity) {
+        capacity *= 2;
+    }
+
+    hashtable->element_size = pointers ? sizeof(void *) : element_size;
+    hashtable->capacity = capacity;
+    hashtable->count = 0;
+    hashtable->tombstone_count = 0;
     hashtable->pointers = pointers;
-    hashtable->data = mem_alloc(MEMORY_TAG_HASHTABLE, initial_capacity * (element_size + sizeof(hashtable_entry_header)));
-    mem_zero(hashtable->data, initial_capacity * (element_size + sizeof(hashtable_entry_header)));
+    hashtable->allocator = allocator != NULL ? allocator : allocator_get_heap(MEMORY_TAG_HASHTABLE);
+    hashtable->data =
+        allocator_allocate(hashtable->allocator, capacity * entry_stride(hashtable), _Alignof(hashtable_entry_header));
+    if (hashtable->data == NULL) {
+        LOG_ERROR("Failed to allocate %u entries", capacity);
+        hashtable->capacity = 0;
+        return FALSE;
+    }
+
+    mem_zero(hashtable->data, capacity * entry_stride(hashtable));
+    return TRUE;
 }
 
 API b8 hashtable_insert(hashtable *hashtable, const char *key, void *value) {
-    u64 index = hash(key) % hashtable->capacity;
-    u64 offset = (index * (hashtable->element_size + sizeof(hashtable_entry_header)));
-    hashtable_entry_header *header = (hashtable_entry_header *)(hashtable->data + offset);
-
-    if (header->present) {
-        if (!str_eq(header->key, key)) {
-            if (!resize_hashtable(hashtable, hashtable->capacity * 2)) {
-                return FALSE;
+    if ((u64)(hashtable->count + hashtable->tombstone_count + 1) * 100 > (u64)hashtable->capacity * MAX_LOAD_FACTOR) {
+        // Only grow if the live entries need it, otherwise rebuilding at the same capacity is enough to clear the tombstones
+        u32 new_capacity = hashtable->capacity;
+        if ((u64)(hashtable->count + 1) * 100 * 2 > (u64)hashtable->capacity * MAX_LOAD_FACTOR) {
+            new_capacity *= 2;
+        }
+
+        if (!resize_hashtable(hashtable, new_capacity)) {
+            return FALSE;
+        }
+    }
+
+    u64 key_hash = hash(key);
+    u64 mask = hashtable->capacity - 1;
+    hashtable_entry_header *target = NULL;
+
+    for (u64 index = key_hash & mask;; index = (index + 1) & mask) {
+        hashtable_entry_header *header = entry_at(hashtable, index);
+
+        if (header->key == NULL) {
+            if (target == NULL) {
+                target = header;
             }
-            return hashtable_insert(hashtable, key, value);
+            break;
         }
 
-        return FALSE;
+        if (header->key == TOMBSTONE) {
+            if (target == NULL) {
+                target = header;
+            }
+        } else if (header->hash == key_hash && str_eq(header->key, key)) {
+            return FALSE;
+        }
     }
 
-    header->present = TRUE;
-    header->key = str_dup(key);
+    char *copy = key_copy(hashtable, key);
+    if (copy == NULL) {
+        LOG_ERROR("Failed to copy the key \"%s\"", key);
+        return FALSE;
+    }
 
-    if (hashtable->pointers) {
-        *(void **)(header + sizeof(hashtable_entry_header)) = value;
-    } else {
-        mem_copy(header + sizeof(hashtable_entry_header), value, hashtable->element_size);
+    if (target->key == TOMBSTONE) {
+        hashtable->tombstone_count--;
     }
 
+    target->key = copy;
+    target->hash = key_hash;
+    entry_write_value(hashtable, target, value);
+    hashtable->count++;
+
     return TRUE;
 }
 
 API b8 hashtable_set(hashtable *hashtable, const char *key, void *value) {
-    u64 index = hash(key) % hashtable->capacity;
-    u64 offset = (index * (hashtable->element_size + sizeof(hashtable_entry_header)));
-    hashtable_entry_header *header = (hashtable_entry_header *)(hashtable->data + offset);
-
-    if (!header->present) {
+    hashtable_entry_header *header = find_entry(hashtable, key, hash(key));
+    if (header == NULL) {
         return FALSE;
     }
 
-    if (!str_eq(header->key, key)) {
-        LOG_ERROR("Hash key collision while setting: %s and %s (%d entries)\n This should never happen if hashtable_insert "
-                  "verify collisions correctly",
-                  header->key,
-                  key,
-                  hashtable->capacity);
-        return TRUE;
-    }
-
     if (value == NULL) {
-        header->present = FALSE;
-        mem_free(header->key);
+        key_free(hashtable, header->key);
+        header->key = TOMBSTONE;
+        hashtable->count--;
+        hashtable->tombstone_count++;
         return TRUE;
     }
 
-    if (hashtable->pointers) {
-        *(void **)(header + sizeof(hashtable_entry_header)) = value;
-    } else {
-        mem_copy(header + sizeof(hashtable_entry_header), value, hashtable->element_size);
-    }
-
+    entry_write_value(hashtable, header, value);
     return TRUE;
 }
 
 API void *hashtable_get(hashtable *hashtable, const char *key) {
-    u64 index = hash(key) % hashtable->capacity;
-    u64 offset = (index * (hashtable->element_size + sizeof(hashtable_entry_header)));
-    hashtable_entry_header *header = (hashtable_entry_header *)(hashtable->data + offset);
-
-    if (!header->present) {
-        return NULL;
-    }
-
-    if (!str_eq(header->key, key)) {
-        LOG_WARN("Hash key collision: %s and %s (%d entries)", header->key, key, hashtable->capacity);
+    hashtable_entry_header *header = find_entry(hashtable, key, hash(key));
+    if (header == NULL) {
         return NULL;
     }
 
     if (hashtable->pointers) {
-        return *(void **)(header + sizeof(hashtable_entry_header));
+        return *(void **)(header + 1);
     } else {
-        return header + sizeof(hashtable_entry_header);
+        return header + 1;
     }
 }
 
 API void hashtable_destroy(hashtable *hashtable) {
     for (u64 i = 0; i < hashtable->capacity; i++) {
-        hashtable_entry_header *header =
-            (hashtable_entry_header *)(hashtable->data + (i * (hashtable->element_size + sizeof(hashtable_entry_header))));
-        if (header->present) {
-            mem_free(header->key);
+        hashtable_entry_header *header = entry_at(hashtable, i);
+        if (entry_is_live(header)) {
+            key_free(hashtable, header->key);
         }
     }
 
-    mem_free(hashtable->data);
+    if (hashtable->data != NULL) {
+        allocator_free(hashtable->allocator, hashtable->data, hashtable->capacity * entry_stride(hashtable));
+    }
     mem_zero(hashtable, sizeof(struct hashtable));
 }
@@ -2,6 +2,22 @@
  * @file hashtable.h
  * @author Killian Bellouard (killianbellouard@gmail.com)
  * @brief This files defines a hash table.
+ *
+ * The table uses open addressing with linear probing, over a power of two number of slots. Each slot holds the hash of its
+ * key, so that most probes are settled without comparing keys. Removed entries leave a tombstone so that the probe sequences
+ * running through them are not cut. The table is rebuilt when the slots holding an entry or a tombstone exceed its maximum
+ * load factor: it doubles if the live entries need it, otherwise it keeps its capacity and only drops the tombstones.
+ *
+ * The swiss hash table is a variant for large tables, with the same API. It keeps one control byte per slot in a separate
+ * array, holding 7 bits of the hash of the key of the slot, or marking it as empty or deleted. Slots are probed by groups of 16:
+ * the control bytes of a group are compared at once (with SSE2 when available), and keys are only compared for the slots whose
+ * control byte matches. It holds up to 7/8 of its slots.
+ *
+ * The u64 hash table is the same table with integer keys, for maps from ids, handles or pointers. Keys are stored in the slots
+ * and compared directly, so inserts do not allocate and lookups do not touch any string.
+ *
+ * Every table allocates its storage (and the copies of its keys) from the allocator it is given, or from the heap with the
+ * HASHTABLE tag.
  * @version 0.1
  * @date 2024-06-27
  */
@@ -9,13 +25,24 @@
 #pragma once
 
 #include <common.h>
+#include "core/allocator.h"
 
-/** @brief A hash table, using the FNV-1a hash function. */
+/** @brief A hash table, using the hash function of the engine (see hash.h). */
 typedef struct hashtable {
+    /** @brief The size of a value (the size of a pointer if the table stores pointers). */
     u32 element_size;
+    /** @brief The number of slots, always a power of two. */
     u32 capacity;
+    /** @brief The number of entries. */
+    u32 count;
+    /** @brief The number of slots holding a removed entry. */
+    u32 tombstone_count;
+    /** @brief Whether the table stores the pointers it is given, instead of copying the values they point to. */
     b8 pointers;
+    /** @brief The slots. */
     void *data;
+    /** @brief The allocator of the slots and of the copies of the keys. */
+    const allocator *allocator;
 } hashtable;
 
 /**
@@ -23,10 +50,14 @@ typedef struct hashtable {
  *
  * @param[in] hashtable The hashtable to initialize.
  * @param[in] element_size The size of the elements in the hashtable.
- * @param[in] initial_capacity The initial capacity of the hashtable.
+ * @param[in] initial_capacity The initial capacity of the hashtable (rounded up to a power of two).
  * @param[in] pointers Whether the hashtable should store pointers or not.
+ * @param[in] allocator The allocator of the storage (which must outlive the hashtable), or NULL for the heap.
+ *
+ * @retval TRUE Success
+ * @retval FALSE Failure (the storage could not be allocated, the hashtable must not be used but can be destroyed)
  */
-API void hashtable_init(hashtable *hashtable, u32 element_size, u32 initial_capacity, b8 pointers);
+API b8 hashtable_init(hashtable *hashtable, u32 element_size, u32 initial_capacity, b8 pointers, const allocator *allocator);
 
 /**
  * @brief Inserts an element in the hashtable.
@@ -36,7 +67,7 @@ API void hashtable_init(hashtable *hashtable, u32 element_size, u32 initial_capa
  * @param[in] value The value of the element.
  *
  * @retval TRUE Success
- * @retval FALSE Failure (if a collision occurs or a key already exists)
+ * @retval FALSE Failure (if the key already exists or the table could not grow)
  */
 API b8 hashtable_insert(hashtable *hashtable, const char *key, void *value);
 
@@ -45,10 +76,10 @@ API b8 hashtable_insert(hashtable *hashtable, const char *key, void *value);
  *
  * @param[in] hashtable The hashtable to set the element in.
  * @param[in] key The key of the element.
- * @param[in] value The value of the element.
+ * @param[in] value The value of the element, or NULL to remove the element.
  *
  * @retval TRUE Success
- * @retval FALSE Failure
+ * @retval FALSE Failure (if the key does not exist)
  */
 API b8 hashtable_set(hashtable *hashtable, const char *key, void *value);
 
@@ -68,3 +99,164 @@ API void *hashtable_get(hashtable *hashtable, const char *key);
  * @param[in] hashtable The hashtable to destroy.
  */
 API void hashtable_destroy(hashtable *hashtable);
+
+/** @brief A hash table probing groups of slots at once, using the hash function of the engine (see hash.h). */
+typedef struct swiss_hashtable {
+    /** @brief The size of a value (the size of a pointer if the table stores pointers). */
+    u32 element_size;
+    /** @brief The number of slots, always a power of two and a multiple of the group size. */
+    u32 capacity;
+    /** @brief The number of entries. */
+    u32 count;
+    /** @brief The number of entries that can still be inserted in empty slots before the table is rebuilt. */
+    u32 growth_left;
+    /** @brief Whether the table stores the pointers it is given, instead of copying the values they point to. */
+    b8 pointers;
+    /** @brief The control bytes of the slots. */
+    i8 *control;
+    /** @brief The slots, allocated with the control bytes. */
+    void *slots;
+    /** @brief The allocator of the storage and of the copies of the keys. */
+    const allocator *allocator;
+} swiss_hashtable;
+
+/**
+ * @brief Initializes a swiss hashtable.
+ *
+ * @param[in] table The hashtable to initialize.
+ * @param[in] element_size The size of the elements in the hashtable.
+ * @param[in] initial_capacity The number of elements the hashtable can hold before growing.
+ * @param[in] pointers Whether the hashtable should store pointers or not.
+ * @param[in] allocator The allocator of the storage (which must outlive the hashtable), or NULL for the heap.
+ *
+ * @retval TRUE Success
+ * @retval FALSE Failure (the storage could not be allocated, the hashtable must not be used but can be destroyed)
+ */
+API b8 swiss_hashtable_init(swiss_hashtable *table,
+                            u32 element_size,
+                            u32 initial_capacity,
+                            b8 pointers,
+                            const allocator *allocator);
+
+/**
+ * @brief Inserts an element in a swiss hashtable.
+ *
+ * @param[in] table The hashtable to insert the element in.
+ * @param[in] key The key of the element.
+ * @param[in] value The value of the element.
+ *
+ * @retval TRUE Success
+ * @retval FALSE Failure (if the key already exists or the table could not grow)
+ */
+API b8 swiss_hashtable_insert(swiss_hashtable *table, const char *key, void *value);
+
+/**
+ * @brief Sets an element in a swiss hashtable.
+ *
+ * @param[in] table The hashtable to set the element in.
+ * @param[in] key The key of the element.
+ * @param[in] value The value of the element, or NULL to remove the element.
+ *
+ * @retval TRUE Success
+ * @retval FALSE Failure (if the key does not exist)
+ */
+API b8 swiss_hashtable_set(swiss_hashtable *table, const char *key, void *value);
+
+/**
+ * @brief Gets an element from a swiss hashtable.
+ *
+ * @param[in] table The hashtable to get the element from.
+ * @param[in] key The key of the element.
+ *
+ * @returns The value of the element if it exists, NULL otherwise.
+ */
+API void *swiss_hashtable_get(swiss_hashtable *table, const char *key);
+
+/**
+ * @brief Destroys a swiss hashtable.
+ *
+ * @param[in] table The hashtable to destroy.
+ */
+API void swiss_hashtable_destroy(swiss_hashtable *table);
+
+/**
+ * @brief Makes a key for a u64 hashtable from a pointer.
+ *
+ * @param[in] pointer The pointer.
+ */
+#define POINTER_KEY(pointer) ((u64)(uintptr_t)(pointer))
+
+/** @brief A hash table with integer keys, probing groups of slots at once. */
+typedef struct u64_hashtable {
+    /** @brief The size of a value (the size of a pointer if the table stores pointers). */
+    u32 element_size;
+    /** @brief The number of slots, always a power of two and a multiple of the group size. */
+    u32 capacity;
+    /** @brief The number of entries. */
+    u32 count;
+    /** @brief The number of entries that can still be inserted in empty slots before the table is rebuilt. */
+    u32 growth_left;
+    /** @brief Whether the table stores the pointers it is given, instead of copying the values they point to. */
+    b8 pointers;
+    /** @brief The control bytes of the slots. */
+    i8 *control;
+    /** @brief The slots, allocated with the control bytes. */
+    void *slots;
+    /** @brief The allocator of the storage. */
+    const allocator *allocator;
+} u64_hashtable;
+
+/**
+ * @brief Initializes a u64 hashtable.
+ *
+ * @param[in] table The hashtable to initialize.
+ * @param[in] element_size The size of the elements in the hashtable.
+ * @param[in] initial_capacity The number of elements the hashtable can hold before growing.
+ * @param[in] pointers Whether the hashtable should store pointers or not.
+ * @param[in] allocator The allocator of the storage (which must outlive the hashtable), or NULL for the heap.
+ *
+ * @retval TRUE Success
+ * @retval FALSE Failure (the storage could not be allocated, the hashtable must not be used but can be destroyed)
+ */
+API b8 u64_hashtable_init(u64_hashtable *table, u32 element_size, u32 initial_capacity, b8 pointers, const allocator *allocator);
+
+/**
+ * @brief Inserts an element in a u64 hashtable.
+ *
+ * @param[in] table The hashtable to insert the element in.
+ * @param[in] key The key of the element (use @ref POINTER_KEY for pointers).
+ * @param[in] value The value of the element.
+ *
+ * @retval TRUE Success
+ * @retval FALSE Failure (if the key already exists or the table could not grow)
+ */
+API b8 u64_hashtable_insert(u64_hashtable *table, u64 key, void *value);
+
+/**
+ * @brief Sets an element in a u64 hashtable.
+ *
+ * @param[in] table The hashtable to set the element in.
+ * @param[in] key The key of the element.
+ * @param[in] value The value of the element, or NULL to remove the element.
+ *
+ * @retval TRUE Success
+ * @retval FALSE Failure (if the key does not exist)
+ */
+API b8 u64_hashtable_set(u64_hashtable *table, u64 key, void *value);
+
+/**
+ * @brief Gets an element from a u64 hashtable.
+ *
+ * @param[in] table The hashtable to get the element from.
+ * @param[in] key The key of the element.
+ *
+ * @returns The value of the element if it exists, NULL otherwise.
+ */
+API void *u64_hashtable_get(u64_hashtable *table, u64 key);
+
+/**
+ * @brief Destroys a u64 hashtable.
+ *
+ * @param[in] table The hashtable to destroy.
+ */
+API void u64_hashtable_destroy(u64_hashtable *table);
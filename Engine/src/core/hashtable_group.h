@@ -0,0 +1,97 @@
+/**
+ * @file hashtable_group.h
+ * @author Killian Bellouard (killianbellouard@gmail.com)
+ * @brief This file defines the control bytes shared by the hash tables probing groups of slots at once.
+ *
+ * Each slot has a control byte, in an array separate from the slots. The control byte of a full slot is the 7 low bits of the
+ * hash of its key (H2), so its high bit is clear, while the empty and deleted markers have it set. The rest of the hash (H1)
+ * selects the first group of the probe sequence. Groups are probed with triangular steps, which visit every group since their
+ * number is a power of two.
+ *
+ * @note This is internal to the hash tables and the HASHMAP macros.
+ * @version 0.1
+ * @date 2024-08-14
+ */
+
+#pragma once
+
+#include "common.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define HASHTABLE_GROUP_SSE2
+#endif
+
+/** @brief The number of control bytes probed at once. */
+#define HASHTABLE_GROUP_SIZE 16
+
+/** @brief The control byte of a slot that has never been used. */
+#define HASHTABLE_CONTROL_EMPTY ((i8)0x80)
+
+/** @brief The control byte of a slot whose entry was removed. */
+#define HASHTABLE_CONTROL_DELETED ((i8)0xFE)
+
+#define HASHTABLE_H1(hash) ((hash) >> 7)
+#define HASHTABLE_H2(hash) ((i8)((hash) & 0x7F))
+
+/** @brief The maximum number of entries a table of the given capacity may hold (7/8 of its slots). */
+static inline u32 hashtable_group_max_entries(u32 capacity) { return capacity - capacity / 8; }
+
+// A group match is a bitmask, bit i being set if the i-th control byte of the group matches
+#if defined(HASHTABLE_GROUP_SSE2)
+static inline u32 hashtable_group_match(const i8 *group, i8 value) {
+    __m128i control = _mm_load_si128((const __m128i *)group);
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(control, _mm_set1_epi8(value)));
+}
+
+static inline u32 hashtable_group_match_empty_or_deleted(const i8 *group) {
+    return _mm_movemask_epi8(_mm_load_si128((const __m128i *)group));
+}
+#else
+static inline u32 hashtable_group_match(const i8 *group, i8 value) {
+    u32 mask = 0;
+    for (u32 i = 0; i < HASHTABLE_GROUP_SIZE; i++) {
+        mask |= (u32)(group[i] == value) << i;
+    }
+    return mask;
+}
+
+static inline u32 hashtable_group_match_empty_or_deleted(const i8 *group) {
+    u32 mask = 0;
+    for (u32 i = 0; i < HASHTABLE_GROUP_SIZE; i++) {
+        mask |= (u32)(group[i] < 0) << i;
+    }
+    return mask;
+}
+#endif
+
+/** @brief Finds the first slot of the probe sequence of a hash that is empty or deleted. */
+static inline u64 hashtable_group_find_free_slot(const i8 *control, u32 capacity, u64 hash) {
+    u64 group_mask = capacity / HASHTABLE_GROUP_SIZE - 1;
+    u64 group = HASHTABLE_H1(hash) & group_mask;
+
+    for (u64 step = 1;; step++) {
+        u32 matches = hashtable_group_match_empty_or_deleted(control + group * HASHTABLE_GROUP_SIZE);
+        if (matches != 0) {
+            return group * HASHTABLE_GROUP_SIZE + __builtin_ctz(matches);
+        }
+
+        group = (group + step) & group_mask;
+    }
+}
+
+/**
+ * @brief Marks a slot as free, and returns whether it became empty (instead of deleted).
+ *
+ * Lookups stop at the first group with an empty slot, so if the group of the slot already has one, no probe sequence runs through
+ * it and the slot can become empty again.
+ */
+static inline b8 hashtable_group_free_slot(i8 *control, u64 index) {
+    if (hashtable_group_match(control + (index / HASHTABLE_GROUP_SIZE) * HASHTABLE_GROUP_SIZE, HASHTABLE_CONTROL_EMPTY) != 0) {
+        control[index] = HASHTABLE_CONTROL_EMPTY;
+        return TRUE;
+    }
+
+    control[index] = HASHTABLE_CONTROL_DELETED;
+    return FALSE;
+}
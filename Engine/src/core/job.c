@@ -0,0 +1,663 @@
+#include "job.h"
+#include "core/atomic.h"
+#include "core/mpmc_queue.h"
+#include "core/spinlock.h"
+#include "memory.h"
+#include "platform/platform.h"
+#include <stdio.h>
+
+#define LOG_SCOPE "JOB SYSTEM"
+#include "core/log.h"
+
+/** @brief The number of jobs the deque of a thread can hold. A thread runs the jobs it submits itself when its deque is full. */
+#define DEQUE_CAPACITY 4096
+
+/** @brief The number of jobs the queue shared by the threads outside of the job system can hold. */
+#define SHARED_QUEUE_CAPACITY 1024
+
+/** @brief The number of times an idle thread looks for a job before sleeping (for workers) or yielding (for waiters). */
+#define IDLE_SPIN_COUNT 256
+
+/** @brief The index of the threads that are not part of the job system. */
+#define NO_THREAD 0xFFFFFFFF
+
+/**
+ * @brief The maximum number of fibers running jobs, created as needed. Once they are all waiting or running, new jobs run on
+ * the stack of the thread, where waiting blocks it.
+ */
+#define FIBER_COUNT 128
+
+/** @brief The stack size of a fiber. Logging alone takes a 16 KiB buffer on the stack. */
+#define FIBER_STACK_SIZE (128 * 1024)
+
+/** @brief A submitted job. */
+typedef struct job {
+    job_function function;
+    void *argument;
+    job_counter *counter;
+} job;
+
+/** @brief A fiber of the pool, running one job at a time. */
+typedef struct job_fiber {
+    platform_fiber fiber;
+    /** @brief The job to run when the fiber is resumed from the pool. */
+    job job;
+    /** @brief The counter the job is waiting for, while the fiber is parked. */
+    job_counter *wait_counter;
+} job_fiber;
+
+/** @brief The state of a thread of the job system. */
+typedef struct job_thread {
+    /** @brief The index of the thread, or NO_THREAD. */
+    u32 index;
+    /** @brief The fiber of the thread itself, which schedules the job fibers, or NULL if it runs jobs on its own stack. */
+    platform_fiber scheduler;
+    /** @brief The job fiber running on the thread, if any. */
+    job_fiber *current;
+    /** @brief The job fiber that just switched back to the scheduler to wait for a counter. */
+    job_fiber *parked;
+    /** @brief The last fiber freed by the thread, reused before the shared pool (most jobs run without waiting). */
+    job_fiber *spare;
+} job_thread;
+
+/**
+ * @brief A work-stealing deque (Chase-Lev), owned by a thread.
+ *
+ * The owner pushes and takes jobs at the bottom, the other threads steal them at the top. Only the last job can be contended
+ * between the owner and the thieves, which is settled by a compare-and-swap of the top. The jobs are stored by value: a thief
+ * reads the job before claiming it, and the slot of a job cannot be reused before the top has moved past it, so a thief whose
+ * claim succeeds has read the job whole.
+ */
+typedef struct job_deque {
+    /** @brief The index of the oldest job, advanced by the thieves (and by the owner taking the last job). */
+    _Alignas(CACHE_LINE_SIZE) i64 top;
+    /** @brief The index after the newest job, written by the owner. */
+    _Alignas(CACHE_LINE_SIZE) i64 bottom;
+    job jobs[DEQUE_CAPACITY];
+} job_deque;
+
+struct job_system_state {
+    /** @brief The number of threads running jobs, the main thread included. */
+    u32 thread_count;
+    /** @brief The deque of each thread, indexed by the index of the thread. */
+    job_deque *deques;
+    /** @brief The worker threads, the thread of index i being at i - 1. */
+    platform_thread *workers;
+    /** @brief The queue of the jobs submitted by the threads outside of the job system. */
+    mpmc_queue *shared_queue;
+
+    /** @brief Every fiber created, for the first fiber_count entries. */
+    job_fiber *fibers[FIBER_COUNT];
+    /** @brief The number of fibers created (or being created). */
+    u32 fiber_count;
+    /** @brief The fibers free to run a new job. */
+    mpmc_queue *free_fibers;
+
+    /** @brief The fibers waiting for a counter, unordered. */
+    job_fiber *parked[FIBER_COUNT];
+    /** @brief The number of parked fibers. Written under the lock, read without it to skip an empty list. */
+    u32 parked_count;
+    /** @brief The lock of the parked fibers. */
+    spinlock parked_lock;
+
+    /** @brief The semaphore the idle workers sleep on. */
+    platform_semaphore wake;
+    /** @brief The number of workers sleeping, or about to. */
+    u32 sleeping;
+    /** @brief Whether the workers must exit. */
+    b8 quit;
+};
+
+static job_system_state *state = NULL;
+
+/** @brief The state of the calling thread. Only accessed through @ref get_thread, since fibers migrate between threads. */
+static _Thread_local job_thread current_thread = { .index = NO_THREAD };
+
+/** @brief The state of the pseudo-random generator picking the threads to steal from. */
+static _Thread_local u64 random_state = 0;
+
+static u32 next_random() {
+    // xorshift64, seeded with the address of the state, which differs between threads
+    if (random_state == 0) {
+        random_state = (u64)&random_state | 1;
+    }
+
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 7;
+    random_state ^= random_state << 17;
+    return (u32)(random_state >> 32);
+}
+
+/**
+ * @brief Gets the state of the calling thread.
+ *
+ * The compiler may compute the address of a thread-local variable once per function, but a job waiting for a counter can
+ * resume on another thread, in the middle of the function. The address is thus taken by a function that cannot be inlined,
+ * nor merged with another call to it (the empty statement has side effects), to be taken again after every switch.
+ */
+static __attribute__((noinline)) job_thread *get_thread() {
+    __asm__ volatile("");
+    return &current_thread;
+}
+
+/**
+ * @brief Copies a job in a slot of a deque. The fields are written atomically, since a thief may be reading an older job from
+ * the slot (and will then fail to claim it).
+ */
+static inline void job_write(job *slot, const job *value) {
+    atomic_store_ptr((void **)&slot->function, (void *)value->function, ATOMIC_ORDER_RELAXED);
+    atomic_store_ptr((void **)&slot->argument, value->argument, ATOMIC_ORDER_RELAXED);
+    atomic_store_ptr((void **)&slot->counter, value->counter, ATOMIC_ORDER_RELAXED);
+}
+
+static inline void job_read(job *slot, job *result) {
+    result->function = (job_function)atomic_load_ptr((void **)&slot->function, ATOMIC_ORDER_RELAXED);
+    result->argument = atomic_load_ptr((void **)&slot->argument, ATOMIC_ORDER_RELAXED);
+    result->counter = atomic_load_ptr((void **)&slot->counter, ATOMIC_ORDER_RELAXED);
+}
+
+/** @brief Pushes a job at the bottom of a deque. Only called by the owner. */
+static b8 deque_push(job_deque *deque, const job *value) {
+    i64 bottom = atomic_load_i64(&deque->bottom, ATOMIC_ORDER_RELAXED);
+    i64 top = atomic_load_i64(&deque->top, ATOMIC_ORDER_ACQUIRE);
+    if (bottom - top >= DEQUE_CAPACITY) {
+        return FALSE;
+    }
+
+    job_write(&deque->jobs[bottom & (DEQUE_CAPACITY - 1)], value);
+
+    // The job must be visible before the thieves see the new bottom
+    atomic_store_i64(&deque->bottom, bottom + 1, ATOMIC_ORDER_RELEASE);
+    return TRUE;
+}
+
+/** @brief Takes the newest job from the bottom of a deque. Only called by the owner. */
+static b8 deque_take(job_deque *deque, job *result) {
+    // Reserve the bottom job before looking at the top, so that a thief cannot claim it too without the owner noticing
+    i64 bottom = atomic_load_i64(&deque->bottom, ATOMIC_ORDER_RELAXED) - 1;
+    atomic_store_i64(&deque->bottom, bottom, ATOMIC_ORDER_RELAXED);
+    atomic_fence(ATOMIC_ORDER_SEQ_CST);
+    i64 top = atomic_load_i64(&deque->top, ATOMIC_ORDER_RELAXED);
+
+    if (top > bottom) {
+        // The deque is empty
+        atomic_store_i64(&deque->bottom, bottom + 1, ATOMIC_ORDER_RELAXED);
+        return FALSE;
+    }
+
+    job_read(&deque->jobs[bottom & (DEQUE_CAPACITY - 1)], result);
+    if (top < bottom) {
+        return TRUE;
+    }
+
+    // This is the last job, which thieves may be claiming as well
+    b8 claimed = atomic_compare_exchange_i64(&deque->top, &top, top + 1, ATOMIC_ORDER_SEQ_CST);
+    atomic_store_i64(&deque->bottom, bottom + 1, ATOMIC_ORDER_RELAXED);
+    return claimed;
+}
+
+/** @brief Steals the oldest job from the top of a deque. Fails if the deque is empty, or if another thread claimed the job. */
+static b8 deque_steal(job_deque *deque, job *result) {
+    i64 top = atomic_load_i64(&deque->top, ATOMIC_ORDER_ACQUIRE);
+    atomic_fence(ATOMIC_ORDER_SEQ_CST);
+    i64 bottom = atomic_load_i64(&deque->bottom, ATOMIC_ORDER_ACQUIRE);
+
+    if (top >= bottom) {
+        return FALSE;
+    }
+
+    job_read(&deque->jobs[top & (DEQUE_CAPACITY - 1)], result);
+    return atomic_compare_exchange_i64(&deque->top, &top, top + 1, ATOMIC_ORDER_SEQ_CST);
+}
+
+/** @brief Finds a job to run: from the deque of the thread first, then from the shared queue, then from the other threads. */
+static b8 find_job(u32 index, job *result) {
+    if (index != NO_THREAD && deque_take(&state->deques[index], result)) {
+        return TRUE;
+    }
+
+    if (mpmc_queue_pop(state->shared_queue, result)) {
+        return TRUE;
+    }
+
+    // Start from a random thread, so that the thieves spread over the victims
+    u32 start = next_random() % state->thread_count;
+    for (u32 i = 0; i < state->thread_count; i++) {
+        u32 victim = (start + i) % state->thread_count;
+        if (victim != index && deque_steal(&state->deques[victim], result)) {
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+/** @brief Wakes sleeping workers, up to the number of jobs submitted. */
+static void wake_workers(u32 count) {
+    atomic_fence(ATOMIC_ORDER_SEQ_CST);
+
+    u32 sleeping = atomic_load_u32(&state->sleeping, ATOMIC_ORDER_RELAXED);
+    if (sleeping > 0) {
+        platform_semaphore_post(&state->wake, sleeping < count ? sleeping : count);
+    }
+}
+
+static void run_job(const job *current) {
+    current->function(current->argument);
+
+    // What the job wrote must be visible to the threads waiting for the counter
+    if (current->counter == NULL || atomic_fetch_sub_u32(&current->counter->pending, 1, ATOMIC_ORDER_SEQ_CST) != 1) {
+        return;
+    }
+
+    // A fiber may be parked on the counter while every worker sleeps (see park_fiber for the other side)
+    if (state != NULL && atomic_load_u32(&state->parked_count, ATOMIC_ORDER_SEQ_CST) > 0) {
+        wake_workers(1);
+    }
+}
+
+/** @brief The entry point of the fibers of the pool, which run a job each time they are resumed from the pool. */
+static void fiber_main(void *argument) {
+    job_fiber *self = argument;
+
+    for (;;) {
+        run_job(&self->job);
+
+        // The job may have waited and resumed on another thread
+        platform_fiber_switch(self->fiber, get_thread()->scheduler);
+    }
+}
+
+/** @brief Gets a fiber to run a new job: a free one, or a new one while the pool is not full. */
+static job_fiber *acquire_fiber(job_thread *thread) {
+    job_fiber *fiber = thread->spare;
+    if (fiber != NULL) {
+        thread->spare = NULL;
+        return fiber;
+    }
+
+    if (mpmc_queue_pop(state->free_fibers, &fiber)) {
+        return fiber;
+    }
+
+    u32 index = atomic_load_u32(&state->fiber_count, ATOMIC_ORDER_RELAXED);
+    do {
+        if (index >= FIBER_COUNT) {
+            return NULL;
+        }
+    } while (!atomic_compare_exchange_u32(&state->fiber_count, &index, index + 1, ATOMIC_ORDER_RELAXED));
+
+    fiber = mem_alloc(MEMORY_TAG_ENGINE, sizeof(job_fiber));
+    if (fiber == NULL || !platform_fiber_create(FIBER_STACK_SIZE, fiber_main, fiber, &fiber->fiber)) {
+        LOG_ERROR("Failed to create fiber %u", index);
+        if (fiber != NULL) {
+            mem_free(fiber);
+        }
+        return NULL;
+    }
+
+    state->fibers[index] = fiber;
+    return fiber;
+}
+
+/** @brief Adds a fiber that switched back to its scheduler to the parked fibers. */
+static void park_fiber(job_fiber *fiber) {
+    spinlock_acquire(&state->parked_lock);
+    state->parked[state->parked_count] = fiber;
+    atomic_store_u32(&state->parked_count, state->parked_count + 1, ATOMIC_ORDER_SEQ_CST);
+
+    // The last job of the counter may have run meanwhile, and seen no parked fiber: make sure a thread picks this one up, as
+    // this thread may be about to leave the job system (the counter is read under the lock, while it is still in use)
+    b8 ready = atomic_load_u32(&fiber->wait_counter->pending, ATOMIC_ORDER_SEQ_CST) == 0;
+    spinlock_release(&state->parked_lock);
+
+    if (ready) {
+        wake_workers(1);
+    }
+}
+
+/** @brief Takes a parked fiber whose counter reached zero off the parked fibers. */
+static job_fiber *take_ready_fiber() {
+    if (atomic_load_u32(&state->parked_count, ATOMIC_ORDER_RELAXED) == 0) {
+        return NULL;
+    }
+
+    job_fiber *ready = NULL;
+    spinlock_acquire(&state->parked_lock);
+
+    for (u32 i = 0; i < state->parked_count; i++) {
+        if (atomic_load_u32(&state->parked[i]->wait_counter->pending, ATOMIC_ORDER_ACQUIRE) == 0) {
+            ready = state->parked[i];
+            state->parked[i] = state->parked[state->parked_count - 1];
+            atomic_store_u32(&state->parked_count, state->parked_count - 1, ATOMIC_ORDER_RELAXED);
+            break;
+        }
+    }
+
+    spinlock_release(&state->parked_lock);
+    return ready;
+}
+
+/** @brief Switches from the scheduler of the thread to a job fiber, then files the fiber once it switches back. */
+static void resume_fiber(job_thread *thread, job_fiber *fiber) {
+    thread->current = fiber;
+    platform_fiber_switch(thread->scheduler, fiber->fiber);
+    thread->current = NULL;
+
+    // The fiber either waits for a counter, or has run its job
+    if (thread->parked != NULL) {
+        park_fiber(thread->parked);
+        thread->parked = NULL;
+    } else if (thread->spare == NULL) {
+        thread->spare = fiber;
+    } else {
+        mpmc_queue_push(state->free_fibers, &fiber);
+    }
+}
+
+/**
+ * @brief Runs a step of the scheduler of a thread: resumes a fiber whose counter reached zero, or runs a new job on a fiber.
+ *
+ * Threads without a scheduler (outside of the job system) run the jobs on their own stack.
+ *
+ * @retval TRUE A job ran, or resumed
+ * @retval FALSE There was nothing to do
+ */
+static b8 schedule(job_thread *thread) {
+    job next;
+
+    if (thread->scheduler == NULL) {
+        if (!find_job(thread->index, &next)) {
+            return FALSE;
+        }
+
+        run_job(&next);
+        return TRUE;
+    }
+
+    // Waiting jobs first, as they hold a fiber and are usually on the critical path
+    job_fiber *fiber = take_ready_fiber();
+    if (fiber != NULL) {
+        resume_fiber(thread, fiber);
+        return TRUE;
+    }
+
+    if (!find_job(thread->index, &next)) {
+        return FALSE;
+    }
+
+    fiber = acquire_fiber(thread);
+    if (fiber == NULL) {
+        run_job(&next);
+        return TRUE;
+    }
+
+    fiber->job = next;
+    resume_fiber(thread, fiber);
+    return TRUE;
+}
+
+/** @brief Turns the calling thread into the scheduler of its jobs. Without it, the thread runs the jobs on its own stack. */
+static void thread_start(u32 index) {
+    job_thread *thread = get_thread();
+    thread->index = index;
+
+    if (!platform_fiber_convert_thread(&thread->scheduler)) {
+        LOG_WARN("Failed to convert thread %u to a fiber, its jobs will block it when they wait", index);
+        thread->scheduler = NULL;
+    }
+}
+
+static void thread_stop() {
+    job_thread *thread = get_thread();
+    if (thread->scheduler != NULL) {
+        platform_fiber_revert_thread(thread->scheduler);
+    }
+
+    mem_zero(thread, sizeof(job_thread));
+    thread->index = NO_THREAD;
+}
+
+static void worker_main(void *argument) {
+    thread_start((u32)(u64)argument);
+    job_thread *thread = get_thread();
+    u32 idle_rounds = 0;
+
+    while (!atomic_load_u8(&state->quit, ATOMIC_ORDER_ACQUIRE)) {
+        if (schedule(thread)) {
+            idle_rounds = 0;
+            continue;
+        }
+
+        // Jobs are often submitted in quick succession, so spin for a while before sleeping
+        if (++idle_rounds < IDLE_SPIN_COUNT) {
+            CPU_RELAX();
+            continue;
+        }
+
+        // Announce the sleep, then look for a job once more: a thread submitting one (or parking a fiber whose counter reached
+        // zero) meanwhile either sees the announce and wakes a worker, or did it before the last look
+        atomic_fetch_add_u32(&state->sleeping, 1, ATOMIC_ORDER_SEQ_CST);
+        atomic_fence(ATOMIC_ORDER_SEQ_CST);
+
+        if (schedule(thread)) {
+            atomic_fetch_sub_u32(&state->sleeping, 1, ATOMIC_ORDER_RELAXED);
+            idle_rounds = 0;
+            continue;
+        }
+
+        if (!atomic_load_u8(&state->quit, ATOMIC_ORDER_ACQUIRE)) {
+            platform_semaphore_wait(&state->wake);
+        }
+
+        atomic_fetch_sub_u32(&state->sleeping, 1, ATOMIC_ORDER_RELAXED);
+        idle_rounds = 0;
+    }
+
+    thread_stop();
+}
+
+/**
+ * @brief Initializes the job system, starting the worker threads.
+ *
+ * Should be called twice, once to get the required allocation size (with state == NULL), and a second time to actually
+ * initialize the job system (with state != NULL).
+ *
+ * @param[in] state_storage A pointer to a memory region to store the state of the job system. To obtain the needed size, pass
+ * NULL.
+ * @param[out] size_requirement A pointer to the size of the memory that should be allocated.
+ * @retval TRUE Success
+ * @retval FALSE Failure
+ */
+API b8 job_system_init(job_system_state *state_storage, u64 *size_requirement) {
+    if (state_storage == NULL) {
+        *size_requirement = sizeof(job_system_state);
+        return TRUE;
+    }
+
+    mem_zero(state_storage, sizeof(job_system_state));
+
+    // One worker per logical processor, the main thread taking the last one
+    u32 thread_count = platform_get_processor_count();
+
+    state_storage->deques = mem_alloc_aligned(MEMORY_TAG_ENGINE, thread_count * sizeof(job_deque), CACHE_LINE_SIZE);
+    state_storage->workers = mem_alloc(MEMORY_TAG_ENGINE, thread_count * sizeof(platform_thread));
+    state_storage->shared_queue = mem_alloc_aligned(MEMORY_TAG_ENGINE, sizeof(mpmc_queue), CACHE_LINE_SIZE);
+    state_storage->free_fibers = mem_alloc_aligned(MEMORY_TAG_ENGINE, sizeof(mpmc_queue), CACHE_LINE_SIZE);
+    if (state_storage->deques == NULL || state_storage->workers == NULL || state_storage->shared_queue == NULL ||
+        state_storage->free_fibers == NULL) {
+        LOG_ERROR("Failed to allocate the queues");
+        job_system_deinit(state_storage);
+        return FALSE;
+    }
+
+    // Zero both queues first, so that deinitializing after a failed init only frees what was allocated
+    mem_zero(state_storage->shared_queue, sizeof(mpmc_queue));
+    mem_zero(state_storage->free_fibers, sizeof(mpmc_queue));
+    if (!mpmc_queue_init(state_storage->shared_queue, sizeof(job), SHARED_QUEUE_CAPACITY) ||
+        !mpmc_queue_init(state_storage->free_fibers, sizeof(job_fiber *), FIBER_COUNT)) {
+        LOG_ERROR("Failed to initialize the queues");
+        job_system_deinit(state_storage);
+        return FALSE;
+    }
+
+    mem_zero(state_storage->deques, thread_count * sizeof(job_deque));
+    platform_semaphore_init(&state_storage->wake, 0);
+
+    state = state_storage;
+    state->thread_count = thread_count;
+    thread_start(0);
+
+    for (u32 i = 1; i < thread_count; i++) {
+        if (!platform_thread_create(worker_main, (void *)(u64)i, &state->workers[i - 1])) {
+            LOG_ERROR("Failed to start worker %u", i);
+
+            // Only stop the workers already started
+            state->thread_count = i;
+            job_system_deinit(state);
+            return FALSE;
+        }
+
+        // Thread names are limited to 15 characters
+        char name[16];
+        snprintf(name, sizeof(name), "Job %u", i);
+        platform_thread_set_name(state->workers[i - 1], name);
+
+        // The affinity is only a hint, so failing to set it is harmless
+        platform_thread_set_affinity(state->workers[i - 1], i);
+    }
+
+    LOG_INFO("Started %u workers", thread_count - 1);
+    return TRUE;
+}
+
+/**
+ * @brief Deinitializes the job system, stopping the worker threads.
+ *
+ * @param[in] state A pointer to the state of the job system.
+ */
+API void job_system_deinit(job_system_state *state_storage) {
+    if (state_storage == NULL) {
+        return;
+    }
+
+    atomic_store_u8(&state_storage->quit, TRUE, ATOMIC_ORDER_RELEASE);
+    if (state_storage->thread_count > 1) {
+        platform_semaphore_post(&state_storage->wake, state_storage->thread_count - 1);
+    }
+
+    for (u32 i = 1; i < state_storage->thread_count; i++) {
+        platform_thread_join(state_storage->workers[i - 1]);
+    }
+
+    for (u32 i = 0; i < state_storage->fiber_count && i < FIBER_COUNT; i++) {
+        // Fibers whose creation failed are left out
+        if (state_storage->fibers[i] != NULL) {
+            platform_fiber_destroy(state_storage->fibers[i]->fiber);
+            mem_free(state_storage->fibers[i]);
+        }
+    }
+
+    if (state_storage->free_fibers != NULL) {
+        mpmc_queue_destroy(state_storage->free_fibers);
+        mem_free(state_storage->free_fibers);
+    }
+
+    if (state_storage->shared_queue != NULL) {
+        mpmc_queue_destroy(state_storage->shared_queue);
+        mem_free(state_storage->shared_queue);
+    }
+
+    if (state_storage->workers != NULL) {
+        mem_free(state_storage->workers);
+    }
+
+    if (state_storage->deques != NULL) {
+        mem_free(state_storage->deques);
+    }
+
+    if (state == state_storage) {
+        thread_stop();
+    }
+
+    mem_zero(state_storage, sizeof(job_system_state));
+    state = NULL;
+}
+
+/**
+ * @brief Submits jobs. They may start running before this function returns.
+ *
+ * @param[in] jobs A pointer to an array of jobs.
+ * @param[in] count The number of jobs.
+ * @param[in] counter The counter to add the jobs to, or NULL to not wait for them.
+ */
+API void job_run(const job_decl *jobs, u32 count, job_counter *counter) {
+    // The counter must account for every job before the first one can run, and decrement it
+    if (counter != NULL) {
+        atomic_fetch_add_u32(&counter->pending, count, ATOMIC_ORDER_RELAXED);
+    }
+
+    u32 index = get_thread()->index;
+    for (u32 i = 0; i < count; i++) {
+        job submitted = { .function = jobs[i].function, .argument = jobs[i].argument, .counter = counter };
+
+        b8 queued = FALSE;
+        if (state != NULL) {
+            queued = index != NO_THREAD ? deque_push(&state->deques[index], &submitted)
+                                        : mpmc_queue_push(state->shared_queue, &submitted);
+        }
+
+        if (!queued) {
+            run_job(&submitted);
+        }
+    }
+
+    if (state != NULL) {
+        wake_workers(count);
+    }
+}
+
+/**
+ * @brief Waits for every job added to a counter to have run. A job parks its fiber until then, while the thread runs other
+ * jobs; other threads run other jobs in the meantime.
+ *
+ * @param[in] counter The counter to wait for.
+ */
+API void job_wait(job_counter *counter) {
+    job_thread *thread = get_thread();
+
+    if (thread->current != NULL) {
+        job_fiber *self = thread->current;
+
+        while (atomic_load_u32(&counter->pending, ATOMIC_ORDER_ACQUIRE) > 0) {
+            // The scheduler parks the fiber once it is switched out, so that no other thread can resume it before
+            self->wait_counter = counter;
+            thread->parked = self;
+            platform_fiber_switch(self->fiber, thread->scheduler);
+
+            // The fiber may have been resumed by another thread
+            thread = get_thread();
+        }
+
+        return;
+    }
+
+    u32 idle_rounds = 0;
+    while (atomic_load_u32(&counter->pending, ATOMIC_ORDER_ACQUIRE) > 0) {
+        if (state != NULL && schedule(thread)) {
+            idle_rounds = 0;
+            continue;
+        }
+
+        // The jobs left are running (or waiting) on other threads
+        if (++idle_rounds < IDLE_SPIN_COUNT) {
+            CPU_RELAX();
+        } else {
+            platform_thread_yield();
+        }
+    }
+}
+
+API u32 job_get_thread_count() { return state != NULL ? state->thread_count : 1; }
+
+API u32 job_get_thread_index() { return get_thread()->index; }
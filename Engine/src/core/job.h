@@ -0,0 +1,104 @@
+/**
+ * @file job.h
+ * @author Killian Bellouard (killianbellouard@gmail.com)
+ * @brief This file defines the job system, which runs small independent tasks on every core.
+ *
+ * The system starts one worker thread per logical processor, besides the main thread. Each of these threads owns a work-stealing
+ * deque (Chase-Lev): it pushes the jobs it submits at the bottom and takes them back from there, newest first, which keeps their
+ * data warm in its cache, while idle threads steal the oldest jobs from the top of the others. Jobs submitted by other threads
+ * go through a shared queue. Idle workers spin for a short while, then sleep until jobs are submitted.
+ *
+ * Fork/join is done with counters: submitting jobs with a counter adds them to it, and each job decrements it once it has run.
+ * Jobs run on fibers from a pool, so that a job waiting for a counter does not block its thread: its fiber is parked, and the
+ * thread goes on with other jobs until the counter reaches zero, when any thread resumes it. Deep chains of jobs waiting for
+ * each other thus keep every thread busy. The main thread waits by running other jobs in the meantime.
+ * @version 0.1
+ * @date 2024-08-21
+ */
+
+#pragma once
+
+#include "common.h"
+
+typedef struct job_system_state job_system_state;
+
+/**
+ * @brief The function of a job.
+ *
+ * @param[in] argument The argument of the job.
+ */
+typedef void (*job_function)(void *argument);
+
+/** @brief A job to submit. */
+typedef struct job_decl {
+    /** @brief The function to run. */
+    job_function function;
+    /** @brief The argument of the function. */
+    void *argument;
+} job_decl;
+
+/** @brief A counter of the jobs left to run, to wait for them. Zero-initialized counters have no jobs left. */
+typedef struct job_counter {
+    u32 pending;
+} job_counter;
+
+/**
+ * @brief Initializes the job system, starting the worker threads.
+ *
+ * Should be called twice, once to get the required allocation size (with state == NULL), and a second time to actually
+ * initialize the job system (with state != NULL). The calling thread becomes the main thread of the job system.
+ *
+ * @param[in] state A pointer to a memory region to store the state of the job system. To obtain the needed size, pass NULL.
+ * @param[out] size_requirement A pointer to the size of the memory that should be allocated.
+ * @retval TRUE Success
+ * @retval FALSE Failure
+ */
+API b8 job_system_init(job_system_state *state, u64 *size_requirement);
+
+/**
+ * @brief Deinitializes the job system, stopping the worker threads.
+ *
+ * @warning Every job submitted must have run.
+ *
+ * @param[in] state A pointer to the state of the job system.
+ */
+API void job_system_deinit(job_system_state *state);
+
+/**
+ * @brief Submits jobs. They may start running before this function returns.
+ *
+ * @note If the job system is not initialized, or its queues are full, the jobs are run right away by the calling thread.
+ *
+ * @param[in] jobs A pointer to an array of jobs.
+ * @param[in] count The number of jobs.
+ * @param[in] counter The counter to add the jobs to, or NULL to not wait for them.
+ */
+API void job_run(const job_decl *jobs, u32 count, job_counter *counter);
+
+/**
+ * @brief Waits for every job added to a counter to have run, running other jobs in the meantime.
+ *
+ * Inside a job, the fiber of the job is parked until the counter reaches zero, and may then resume on another thread: the
+ * thread index, thread-local variables and per-thread allocators (like the scratch stack) must not be relied upon across the
+ * call. Once the fibers of the pool are all in use, jobs run on the stack of their thread, and waiting blocks it instead.
+ *
+ * @note Memory written by the jobs is visible to the calling thread once this function returns.
+ *
+ * @param[in] counter The counter to wait for.
+ */
+API void job_wait(job_counter *counter);
+
+/**
+ * @brief Gets the number of threads running jobs: the worker threads and the main thread.
+ *
+ * @return The number of threads, at least 1.
+ */
+API u32 job_get_thread_count();
+
+/**
+ * @brief Gets the index of the calling thread in the job system, to index per-thread data.
+ *
+ * @return The index of the thread: 0 for the main thread, 1 to @ref job_get_thread_count - 1 for the workers, or 0xFFFFFFFF if
+ * the thread is not part of the job system.
+ */
+API u32 job_get_thread_index();
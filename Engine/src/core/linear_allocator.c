@@ -0,0 +1,48 @@
+#include "linear_allocator.h"
+#include "math/math.h"
+
+#define LOG_SCOPE "LINEAR ALLOCATOR"
+#include "core/log.h"
+
+API void linear_allocator_create(u64 total_size, void *memory, linear_allocator *allocator) {
+    allocator->total_size = total_size;
+    allocator->allocated = 0;
+    allocator->memory = memory;
+}
+
+API void *linear_allocator_allocate(linear_allocator *allocator, u64 size, u64 alignment) {
+    u64 base = (u64)allocator->memory;
+    u64 offset = ALIGN_UP(base + allocator->allocated, alignment) - base;
+
+    if (offset + size > allocator->total_size) {
+        LOG_ERROR("Out of memory: tried to allocate %llu bytes, %llu bytes remaining",
+                  size,
+                  allocator->total_size - allocator->allocated);
+        return NULL;
+    }
+
+    allocator->allocated = offset + size;
+    return (void *)(base + offset);
+}
+
+API void *linear_allocator_allocate_concurrent(linear_allocator *allocator, u64 size, u64 alignment) {
+    u64 base = (u64)allocator->memory;
+    u64 allocated = __atomic_load_n(&allocator->allocated, __ATOMIC_RELAXED);
+    u64 offset;
+
+    do {
+        offset = ALIGN_UP(base + allocated, alignment) - base;
+
+        if (offset + size > allocator->total_size) {
+            LOG_ERROR("Out of memory: tried to allocate %llu bytes, %llu bytes remaining",
+                      size,
+                      allocator->total_size - allocated);
+            return NULL;
+        }
+    } while (!__atomic_compare_exchange_n(
+        &allocator->allocated, &allocated, offset + size, TRUE, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+
+    return (void *)(base + offset);
+}
+
+API void linear_allocator_free_all(linear_allocator *allocator) { allocator->allocated = 0; }
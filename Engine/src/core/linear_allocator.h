@@ -0,0 +1,65 @@
+/**
+ * @file linear_allocator.h
+ * @author Killian Bellouard (killianbellouard@gmail.com)
+ * @brief This file defines a linear (bump) allocator. Allocations are served by advancing an offset in a fixed memory region,
+ * and can only be released all at once.
+ * @version 0.1
+ * @date 2024-08-02
+ */
+
+#pragma once
+
+#include "common.h"
+
+/** @brief A linear allocator working on a caller-provided memory region. */
+typedef struct linear_allocator {
+    /** @brief The total size of the memory region. */
+    u64 total_size;
+    /** @brief The number of bytes already handed out (including alignment padding). */
+    u64 allocated;
+    /** @brief The memory region. Not owned by the allocator. */
+    void *memory;
+} linear_allocator;
+
+/**
+ * @brief Creates a linear allocator over the given memory region.
+ *
+ * @note The allocator does not take ownership of the memory region, the caller is responsible for freeing it.
+ *
+ * @param[in] total_size The size of the memory region.
+ * @param[in] memory The memory region to allocate from.
+ * @param[out] allocator A pointer to the allocator to initialize.
+ */
+API void linear_allocator_create(u64 total_size, void *memory, linear_allocator *allocator);
+
+/**
+ * @brief Allocates a block from the allocator.
+ *
+ * @param[in] allocator The allocator to allocate from.
+ * @param[in] size The size of the block.
+ * @param[in] alignment The alignment of the block (must be a power of two).
+ *
+ * @return A pointer to the allocated block, or NULL if the allocator is out of memory.
+ */
+API void *linear_allocator_allocate(linear_allocator *allocator, u64 size, u64 alignment);
+
+/**
+ * @brief Allocates a block from the allocator. Unlike @ref linear_allocator_allocate, this can be called from several threads
+ * at once on the same allocator.
+ *
+ * @note Resetting the allocator while other threads allocate from it is still not supported.
+ *
+ * @param[in] allocator The allocator to allocate from.
+ * @param[in] size The size of the block.
+ * @param[in] alignment The alignment of the block (must be a power of two).
+ *
+ * @return A pointer to the allocated block, or NULL if the allocator is out of memory.
+ */
+API void *linear_allocator_allocate_concurrent(linear_allocator *allocator, u64 size, u64 alignment);
+
+/**
+ * @brief Releases all the blocks allocated from the allocator at once.
+ *
+ * @param[in] allocator The allocator to reset.
+ */
+API void linear_allocator_free_all(linear_allocator *allocator);
@@ -1,18 +1,82 @@
 #include "memory.h"
+#include "core/event.h"
+#include "core/linear_allocator.h"
 #include "core/log.h"
+#include "core/memory_profiler.h"
+#include "core/spinlock.h"
+#include "core/tlsf_allocator.h"
+#include "math/math.h"
 #include "platform/platform.h"
 
 #include <string.h>
 
-// TODO: The allocation functions provided by the platforms are very "generic" in nature and are not very efficient for our use
-// case. We should avoid them at all cost, by pre-allocating a large memory region and then only allocating from it using our own
-// allocators -> Optimize this system after the first phase of the project
+// The whole memory system lives in one large range of address space reserved at initialization, and committed lazily as it
+// is used:
+//   [memory_state][frame arena 0][frame arena 1][heap ...]
+// The heap is managed by a TLSF allocator, and grows (is committed) by steps of at least HEAP_GROWTH_STEP bytes.
+//
+// Every function can be called from any thread. The heap is protected by a spinlock, but most allocations never take it:
+// small regions (up to SMALL_REGION_MAX_SIZE bytes, with the default alignment) are served from per-thread caches. Each thread
+// keeps two magazines (lists of at most MAGAZINE_CAPACITY free regions) per size class. It only touches shared state when both
+// are empty, to take a full magazine from the depot (a lock-free stack per size class) or carve a new one from the heap, or
+// when both are full, to push one to the depot. Small regions only go back to the heap when a thread releases its cache
+// (see mem_thread_cache_release): its full magazines are pushed to the depot, and the regions of the partial ones are freed to
+// the heap.
+//
+// Each thread also owns a scratch stack: a range of address space reserved on its first use, and committed lazily.
+//
+// The statistics are accumulated per thread as well, and merged into the global counters with atomic operations once they
+// drift by more than STATS_FLUSH_THRESHOLD bytes.
 
-typedef struct region_header {
+/** @brief The granularity at which memory is committed when huge pages are requested. */
+#define HUGE_PAGE_COMMIT_GRANULARITY (2 * 1024 * 1024)
+
+/** @brief The granularity at which memory is committed otherwise. */
+#define COMMIT_GRANULARITY (64 * 1024)
+
+/** @brief The minimum amount of memory committed at once when the heap grows. */
+#define HEAP_GROWTH_STEP (8 * 1024 * 1024)
+
+/** @brief The alignment of regions when none is requested. */
+#define DEFAULT_ALIGNMENT 16
+
+/** @brief The difference of size between two consecutive size classes. */
+#define SIZE_CLASS_GRANULARITY 16
+
+/** @brief The number of size classes served by the thread caches. */
+#define SIZE_CLASS_COUNT 16
+
+/** @brief The largest region served by the thread caches. */
+#define SMALL_REGION_MAX_SIZE (SIZE_CLASS_COUNT * SIZE_CLASS_GRANULARITY)
+
+/** @brief The size class of regions allocated directly from the heap. */
+#define SIZE_CLASS_NONE 0xFF
+
+/** @brief The number of regions in a full magazine. */
+#define MAGAZINE_CAPACITY 32
+
+/** @brief The number of bytes a thread can allocate or free before merging its statistics into the global ones. */
+#define STATS_FLUSH_THRESHOLD (64 * 1024)
+
+/** @brief The largest range that can be reserved, so that the depot can address regions with 32 bits. */
+#define MAX_RESERVE_SIZE (16ull << 32)
+
+/**
+ * @brief The header stored in front of every region allocated from the heap.
+ *
+ * Its size is kept a multiple of 16 bytes, so that the region following it keeps the natural alignment of the heap blocks.
+ */
+typedef struct __attribute__((aligned(16))) region_header {
+    /** @brief The requested size of the region. */
     u64 size;
-    u64 allocation_offset;
-    u64 allocation_size;
+    /** @brief The tag of the region. */
     memory_tag tag;
+    /** @brief The size class of the region, or SIZE_CLASS_NONE if it is not served by the thread caches. */
+    u8 size_class;
+    /** @brief The log2 of the alignment of the region, kept so that it is preserved when the region is moved. */
+    u8 alignment_log2;
+    /** @brief The identifier of the heap profiler sample of the region, or 0 if it was not sampled. */
+    u16 sample_id;
 
 #ifdef DEBUG
     struct region_header *prev;
@@ -23,34 +87,182 @@ typedef struct region_header {
 #endif
 } region_header;
 
+/** @brief The links stored in a free small region, while it sits in a magazine. */
+typedef struct cached_region {
+    /** @brief The next region in the same magazine. */
+    struct cached_region *next;
+    /** @brief The first region of the next magazine in the depot (only used by the first region of a magazine). */
+    struct cached_region *next_magazine;
+} cached_region;
+
+/** @brief A list of free regions of the same size class. */
+typedef struct magazine {
+    cached_region *head;
+    u32 count;
+} magazine;
+
+/** @brief The allocation cache of a thread. */
+typedef struct thread_cache {
+    /** @brief The magazines allocations are served from, per size class. */
+    magazine loaded[SIZE_CLASS_COUNT];
+    /** @brief The magazines swapped with the loaded ones when these are empty or full, per size class. */
+    magazine previous[SIZE_CLASS_COUNT];
+
+    /** @brief The allocation count changes not merged in the global statistics yet. Read by other threads. */
+    i64 allocation_count_delta[MEMORY_TAG_MAX_TAGS];
+    /** @brief The allocated size changes not merged in the global statistics yet. Read by other threads. */
+    i64 allocated_size_delta[MEMORY_TAG_MAX_TAGS];
+    /** @brief The number of allocations made by the thread, not merged in the global statistics yet. Read by other threads. */
+    u64 total_allocation_count;
+
+    /** @brief The scratch stack. Its memory is NULL until the first scratch allocation. */
+    linear_allocator scratch;
+    /** @brief The number of committed bytes at the beginning of the scratch stack. */
+    u64 scratch_committed;
+
+    /** @brief Whether a thread owns this cache. Caches released by exited threads are reused by new ones. */
+    b8 in_use;
+    /** @brief The next cache in the list of all the caches. */
+    struct thread_cache *next;
+} thread_cache;
+
 typedef struct memory_state {
+    /** @brief The budgets, per tag. */
+    memory_budget budgets[MEMORY_TAG_MAX_TAGS];
+    /** @brief Whether the usage of each tag is above its soft limit. */
+    b8 under_pressure[MEMORY_TAG_MAX_TAGS];
+    /** @brief The tags whose usage crossed their soft limit since the last frame, one bit per tag, updated atomically. */
+    u32 pressure_pending;
+
+    /** @brief The number of allocations per tag, updated atomically. */
     u64 allocation_count[MEMORY_TAG_MAX_TAGS];
+    /** @brief The allocated size per tag, updated atomically. */
     u64 allocated_size[MEMORY_TAG_MAX_TAGS];
+    /** @brief The number of allocations made since the initialization by the threads that released their cache. */
+    u64 total_allocation_count;
 
 #ifdef DEBUG
     region_header *regions_list_head[MEMORY_TAG_MAX_TAGS];
     region_header *regions_list_tail[MEMORY_TAG_MAX_TAGS];
+    /** @brief The lock protecting the lists of regions. */
+    spinlock regions_lock;
 #endif
+
+    /** @brief The reserved address range. The state itself is stored at its beginning. */
+    void *reserved_memory;
+    /** @brief The size of the reserved address range. */
+    u64 reserved_size;
+    /** @brief The granularity at which memory is committed. */
+    u64 commit_granularity;
+    /** @brief The size of the address range reserved for each scratch stack. */
+    u64 scratch_size;
+    /** @brief The path where the heap profile is written at deinitialization, or NULL. */
+    const char *profiler_output_path;
+
+    /** @brief The frame arenas, used alternatively every frame. */
+    linear_allocator frame_arenas[2];
+    /** @brief The number of committed bytes at the beginning of each frame arena. */
+    u64 frame_arenas_committed[2];
+    /** @brief The index of the frame arena used by the current frame. */
+    u8 current_frame_arena;
+    /** @brief The lock taken to commit more of a frame arena. */
+    spinlock frame_arenas_lock;
+
+    /** @brief The lock protecting the heap. */
+    __attribute__((aligned(64))) spinlock heap_lock;
+    /** @brief The general purpose heap. */
+    tlsf_allocator heap;
+    /** @brief The end of the committed part of the heap. */
+    void *heap_committed_end;
+
+    /**
+     * @brief The heads of the stacks of full magazines, per size class.
+     *
+     * Each head packs a counter, incremented on every change to detect concurrent pops (ABA), in its 32 high bits, and the
+     * offset of the first region of the magazine from the beginning of the reserved range (divided by 16) in its 32 low bits.
+     */
+    __attribute__((aligned(64))) u64 depot[SIZE_CLASS_COUNT];
+
+    /** @brief The list of all the thread caches. */
+    __attribute__((aligned(64))) thread_cache *thread_caches;
+    /** @brief The lock protecting the list of thread caches. */
+    spinlock thread_caches_lock;
 } memory_state;
 
 static const char *TAG_LABELS[MEMORY_TAG_MAX_TAGS] = {
-    "UNKNOWN", "DYNARRAY", "HASHTABLE", "ENGINE", "PLATFORM", "STRING", "RENDERER",
+    "UNKNOWN", "DYNARRAY", "HASHTABLE", "ENGINE", "PLATFORM", "STRING", "RENDERER", "VULKAN",
 };
 
 static memory_state *state = NULL;
 
+/** @brief The cache of the calling thread, created on its first allocation. */
+static _Thread_local thread_cache *local_cache = NULL;
+
 /**
  * @brief Initializes the memory system.
  *
  * @note Unlike other systems, ths function will allocate the needed memory itself. As such, it must be the first system to be
  * initialized.
  *
+ * @param[in] config The configuration of the memory system.
+ *
  * @retval TRUE Success
  * @retval FALSE Failure
  */
-b8 mem_init() {
-    state = (memory_state *)platform_allocate(sizeof(memory_state));
-    mem_zero(state, sizeof(memory_state));
+b8 mem_init(const memory_config *config) {
+    u64 page_size = platform_get_page_size();
+    u64 granularity = MAX(config->huge_pages ? HUGE_PAGE_COMMIT_GRANULARITY : COMMIT_GRANULARITY, page_size);
+
+    u64 state_size = ALIGN_UP(sizeof(memory_state), page_size);
+    u64 frame_arenas_offset = ALIGN_UP(sizeof(memory_state), granularity);
+    u64 frame_arena_size = ALIGN_UP(config->frame_arena_size, granularity);
+    u64 reserve_size = ALIGN_UP(config->reserve_size, granularity);
+
+    if (reserve_size > MAX_RESERVE_SIZE) {
+        LOG_FATAL("The reserved range (%llu bytes) is larger than the maximum supported (%llu bytes)",
+                  reserve_size,
+                  MAX_RESERVE_SIZE);
+        return FALSE;
+    }
+
+    if (frame_arenas_offset + 2 * frame_arena_size > reserve_size) {
+        LOG_FATAL("The reserved range (%llu bytes) is too small to hold the frame arenas (2 x %llu bytes)",
+                  reserve_size,
+                  frame_arena_size);
+        return FALSE;
+    }
+
+    void *memory = platform_virtual_reserve(reserve_size, config->huge_pages);
+    if (memory == NULL) {
+        LOG_FATAL("Failed to reserve %llu bytes of address space", reserve_size);
+        return FALSE;
+    }
+
+    if (!platform_virtual_commit(memory, state_size)) {
+        LOG_FATAL("Failed to commit the memory system state");
+        platform_virtual_release(memory, reserve_size);
+        return FALSE;
+    }
+
+    // Freshly committed memory is already zeroed
+    state = (memory_state *)memory;
+    state->reserved_memory = memory;
+    state->reserved_size = reserve_size;
+    state->commit_granularity = granularity;
+    state->scratch_size = ALIGN_UP(config->scratch_size, page_size);
+    state->profiler_output_path = config->profiler_output_path;
+
+    linear_allocator_create(frame_arena_size, memory + frame_arenas_offset, &state->frame_arenas[0]);
+    linear_allocator_create(frame_arena_size, memory + frame_arenas_offset + frame_arena_size, &state->frame_arenas[1]);
+    state->current_frame_arena = 0;
+
+    // The heap starts empty, and is committed on the first allocation
+    tlsf_allocator_create(&state->heap);
+    state->heap_committed_end = memory + frame_arenas_offset + 2 * frame_arena_size;
+
+    if (!memory_profiler_init(config->profiler_sample_interval, config->profiler_max_stacks)) {
+        LOG_WARN("Failed to initialize the heap profiler, continuing without it");
+    }
 
     return TRUE;
 }
@@ -59,13 +271,20 @@ b8 mem_init() {
  * @brief Deinitializes the memory system.
  */
 void mem_deinit() {
+    if (state->profiler_output_path != NULL) {
+        mem_profiler_dump(state->profiler_output_path, MEMORY_PROFILE_ALLOCATED);
+    }
+    memory_profiler_deinit();
+
+    mem_thread_cache_release();
+
     // Check if any allocations are left, and warn about them
     for (u64 i = 0; i < MEMORY_TAG_MAX_TAGS; i++) {
-        if (state->allocation_count[i] != 0) {
-            LOG_WARN("Memory leak of %llu bytes (%llu allocations) in tag %s",
-                     state->allocated_size[i],
-                     state->allocation_count[i],
-                     TAG_LABELS[i]);
+        u64 allocation_count, allocated_size;
+        mem_get_usage(i, &allocation_count, &allocated_size);
+
+        if (allocation_count != 0) {
+            LOG_WARN("Memory leak of %llu bytes (%llu allocations) in tag %s", allocated_size, allocation_count, TAG_LABELS[i]);
 
 #ifdef DEBUG
             region_header *current = state->regions_list_head[i];
@@ -83,55 +302,432 @@ void mem_deinit() {
         }
     }
 
-    platform_free(state);
+    for (thread_cache *cache = state->thread_caches; cache != NULL; cache = cache->next) {
+        if (cache->scratch.memory != NULL) {
+            platform_virtual_release(cache->scratch.memory, cache->scratch.total_size);
+        }
+    }
+
+    // The state lives in the reserved range, so it must not be touched after this point
+    void *reserved_memory = state->reserved_memory;
+    u64 reserved_size = state->reserved_size;
+    state = NULL;
+
+    platform_virtual_release(reserved_memory, reserved_size);
+}
+
+/**
+ * @brief Commits more memory at the end of the heap, so that an allocation of the given size (alignment included) can succeed.
+ *
+ * @note The heap lock must be held.
+ *
+ * @retval TRUE Success
+ * @retval FALSE Failure (the reserved range is exhausted, or the commit failed)
+ */
+static b8 heap_grow(u64 size) {
+    // Leave room for the block headers, the end of region sentinel and the rounding to the size classes
+    u64 needed = size + size / TLSF_SL_INDEX_COUNT + 4 * tlsf_allocator_block_overhead();
+    u64 grow_size = ALIGN_UP(MAX(needed, HEAP_GROWTH_STEP), state->commit_granularity);
+
+    u64 available = (u64)state->reserved_memory + state->reserved_size - (u64)state->heap_committed_end;
+    if (grow_size > available) {
+        grow_size = ALIGN_UP(needed, state->commit_granularity);
+        if (grow_size > available) {
+            return FALSE;
+        }
+    }
+
+    if (!platform_virtual_commit(state->heap_committed_end, grow_size)) {
+        return FALSE;
+    }
+
+    if (!tlsf_allocator_add_memory(&state->heap, state->heap_committed_end, grow_size)) {
+        platform_virtual_decommit(state->heap_committed_end, grow_size);
+        return FALSE;
+    }
+
+    state->heap_committed_end += grow_size;
+    return TRUE;
+}
+
+/**
+ * @brief Allocates a region and its header from the heap, growing it if needed.
+ *
+ * @note The heap lock must be held.
+ *
+ * @param[in] size The size of the region, header excluded.
+ * @param[in] alignment The alignment of the region.
+ *
+ * @return The header of the region, or NULL if the heap could not grow.
+ */
+static region_header *heap_allocate(u64 size, u64 alignment) {
+    // The header is placed right in front of the region, and the region (not the header) must be aligned
+    region_header *header = tlsf_allocator_allocate(&state->heap, size + sizeof(region_header), alignment, sizeof(region_header));
+    if (header == NULL) {
+        if (!heap_grow(size + sizeof(region_header) + alignment)) {
+            return NULL;
+        }
+
+        header = tlsf_allocator_allocate(&state->heap, size + sizeof(region_header), alignment, sizeof(region_header));
+    }
+
+    return header;
+}
+
+/**
+ * @brief Gets the cache of the calling thread, creating (or reusing a released) one on the first call.
+ *
+ * @return The cache of the calling thread, or NULL if it could not be allocated.
+ */
+static thread_cache *get_thread_cache() {
+    if (local_cache != NULL) {
+        return local_cache;
+    }
+
+    spinlock_acquire(&state->thread_caches_lock);
+
+    thread_cache *cache = state->thread_caches;
+    while (cache != NULL && cache->in_use) {
+        cache = cache->next;
+    }
+
+    if (cache == NULL) {
+        spinlock_acquire(&state->heap_lock);
+        region_header *header = heap_allocate(sizeof(thread_cache), DEFAULT_ALIGNMENT);
+        spinlock_release(&state->heap_lock);
+
+        if (header == NULL) {
+            spinlock_release(&state->thread_caches_lock);
+            return NULL;
+        }
+
+        // The caches are internal to the memory system, so they are not tracked by the statistics
+        cache = (thread_cache *)(header + 1);
+        mem_zero(cache, sizeof(thread_cache));
+        cache->next = state->thread_caches;
+        state->thread_caches = cache;
+    }
+
+    cache->in_use = TRUE;
+    spinlock_release(&state->thread_caches_lock);
+
+    local_cache = cache;
+    return cache;
+}
+
+/**
+ * @brief Records an allocation (positive changes) or a free (negative changes) in the statistics.
+ *
+ * @param[in] cache The cache of the calling thread, or NULL to update the global statistics directly.
+ * @param[in] tag The tag of the region.
+ * @param[in] count The change of the allocation count.
+ * @param[in] size The change of the allocated size.
+ */
+static void stats_update(thread_cache *cache, memory_tag tag, i64 count, i64 size) {
+    if (cache == NULL) {
+        __atomic_fetch_add(&state->allocation_count[tag], (u64)count, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&state->allocated_size[tag], (u64)size, __ATOMIC_RELAXED);
+        return;
+    }
+
+    i64 count_delta = cache->allocation_count_delta[tag] + count;
+    i64 size_delta = cache->allocated_size_delta[tag] + size;
+
+    if (size_delta > STATS_FLUSH_THRESHOLD || size_delta < -STATS_FLUSH_THRESHOLD) {
+        __atomic_fetch_add(&state->allocation_count[tag], (u64)count_delta, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&state->allocated_size[tag], (u64)size_delta, __ATOMIC_RELAXED);
+        count_delta = 0;
+        size_delta = 0;
+    }
+
+    __atomic_store_n(&cache->allocation_count_delta[tag], count_delta, __ATOMIC_RELAXED);
+    __atomic_store_n(&cache->allocated_size_delta[tag], size_delta, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Gets the number of bytes allocated in a tag, as seen by the calling thread (the changes not merged by the other
+ * threads are not accounted for).
+ */
+static u64 local_usage(thread_cache *cache, memory_tag tag) {
+    u64 allocated_size = __atomic_load_n(&state->allocated_size[tag], __ATOMIC_RELAXED);
+    return cache != NULL ? allocated_size + (u64)cache->allocated_size_delta[tag] : allocated_size;
+}
+
+/**
+ * @brief Logs the memory usage and budget of every tag.
+ */
+static void log_usage_report() {
+    LOG_ERROR("Memory usage report:");
+    for (u32 i = 0; i < MEMORY_TAG_MAX_TAGS; i++) {
+        u64 allocation_count, allocated_size;
+        mem_get_usage(i, &allocation_count, &allocated_size);
+
+        LOG_ERROR("  %-10s %12llu bytes (%llu allocations), soft limit %llu, hard limit %llu",
+                  TAG_LABELS[i],
+                  allocated_size,
+                  allocation_count,
+                  state->budgets[i].soft_limit,
+                  state->budgets[i].hard_limit);
+    }
+}
+
+/**
+ * @brief Checks that an allocation fits in the hard limit of its tag.
+ *
+ * @retval TRUE The allocation fits
+ * @retval FALSE The allocation would cross the hard limit
+ */
+static b8 budget_check_hard_limit(thread_cache *cache, memory_tag tag, u64 size) {
+    u64 hard_limit = state->budgets[tag].hard_limit;
+    if (hard_limit == 0 || local_usage(cache, tag) + size + sizeof(region_header) <= hard_limit) {
+        return TRUE;
+    }
+
+    LOG_FATAL("Allocation of %llu bytes in tag %s would exceed its hard limit (%llu bytes)", size, TAG_LABELS[tag], hard_limit);
+    log_usage_report();
+    return FALSE;
+}
+
+/**
+ * @brief Raises the pressure of a tag when its usage crosses its soft limit upwards, and rearms it when it goes back under.
+ *
+ * This runs inside the allocator, on any thread, while the event system belongs to the main thread: the event is only marked
+ * as pending here, and fired by @ref mem_frame_begin.
+ */
+static void budget_update_pressure(thread_cache *cache, memory_tag tag) {
+    u64 soft_limit = state->budgets[tag].soft_limit;
+    if (soft_limit == 0) {
+        return;
+    }
+
+    b8 under_pressure = local_usage(cache, tag) > soft_limit;
+    if (__atomic_load_n(&state->under_pressure[tag], __ATOMIC_RELAXED) == under_pressure) {
+        return;
+    }
+
+    // Only the thread that flips the flag raises the event
+    if (__atomic_exchange_n(&state->under_pressure[tag], under_pressure, __ATOMIC_RELAXED) != under_pressure && under_pressure) {
+        __atomic_fetch_or(&state->pressure_pending, 1u << tag, __ATOMIC_RELAXED);
+    }
+}
+
+static u64 depot_pack(cached_region *region, u64 counter) {
+    u64 offset = region != NULL ? ((u64)region - (u64)state->reserved_memory) / 16 : 0;
+    return (counter << 32) | offset;
+}
+
+static cached_region *depot_unpack(u64 head) {
+    u64 offset = head & 0xFFFFFFFF;
+    return offset != 0 ? (cached_region *)(state->reserved_memory + offset * 16) : NULL;
+}
+
+/**
+ * @brief Pushes a full magazine to the depot.
+ */
+static void depot_push(u8 size_class, cached_region *magazine_head) {
+    u64 *depot = &state->depot[size_class];
+    u64 head = __atomic_load_n(depot, __ATOMIC_RELAXED);
+    u64 new_head;
+
+    do {
+        __atomic_store_n(&magazine_head->next_magazine, depot_unpack(head), __ATOMIC_RELAXED);
+        new_head = depot_pack(magazine_head, (head >> 32) + 1);
+    } while (!__atomic_compare_exchange_n(depot, &head, new_head, TRUE, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+}
+
+/**
+ * @brief Pops a full magazine from the depot.
+ *
+ * @return The first region of the magazine, or NULL if the depot is empty.
+ */
+static cached_region *depot_pop(u8 size_class) {
+    u64 *depot = &state->depot[size_class];
+    u64 head = __atomic_load_n(depot, __ATOMIC_ACQUIRE);
+    u64 new_head;
+    cached_region *magazine_head;
+
+    do {
+        magazine_head = depot_unpack(head);
+        if (magazine_head == NULL) {
+            return NULL;
+        }
+
+        // The magazine may be popped (and its regions reused) by another thread meanwhile. The regions are never unmapped, so
+        // the read is safe, and the counter makes the exchange fail in that case.
+        new_head = depot_pack(__atomic_load_n(&magazine_head->next_magazine, __ATOMIC_RELAXED), (head >> 32) + 1);
+    } while (!__atomic_compare_exchange_n(depot, &head, new_head, TRUE, __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE));
+
+    return magazine_head;
+}
+
+/**
+ * @brief Fills an empty magazine with new regions carved from the heap.
+ *
+ * @retval TRUE Success (the magazine may not be full if the heap is exhausted)
+ * @retval FALSE Failure (no region could be allocated)
+ */
+static b8 magazine_fill(magazine *magazine, u8 size_class) {
+    u64 size = (size_class + 1) * SIZE_CLASS_GRANULARITY;
+
+    spinlock_acquire(&state->heap_lock);
+    while (magazine->count < MAGAZINE_CAPACITY) {
+        region_header *header = heap_allocate(size, DEFAULT_ALIGNMENT);
+        if (header == NULL) {
+            break;
+        }
+
+        header->size_class = size_class;
+
+        cached_region *region = (cached_region *)(header + 1);
+        region->next = magazine->head;
+        magazine->head = region;
+        magazine->count++;
+    }
+    spinlock_release(&state->heap_lock);
+
+    return magazine->count != 0;
+}
+
+/**
+ * @brief Gives the regions of a magazine back to the depot if it is full, or to the heap otherwise, and empties it.
+ */
+static void magazine_release(magazine *magazine, u8 size_class) {
+    if (magazine->count == MAGAZINE_CAPACITY) {
+        depot_push(size_class, magazine->head);
+    } else if (magazine->count != 0) {
+        spinlock_acquire(&state->heap_lock);
+        cached_region *region = magazine->head;
+        while (region != NULL) {
+            cached_region *next = region->next;
+            tlsf_allocator_free(&state->heap, (region_header *)region - 1);
+            region = next;
+        }
+        spinlock_release(&state->heap_lock);
+    }
+
+    magazine->head = NULL;
+    magazine->count = 0;
+}
+
+static void magazine_swap(magazine *a, magazine *b) {
+    magazine temp = *a;
+    *a = *b;
+    *b = temp;
+}
+
+/**
+ * @brief Allocates a small region from the cache of the calling thread.
+ *
+ * @return The header of the region, or NULL if the heap is exhausted.
+ */
+static region_header *cache_allocate(thread_cache *cache, u8 size_class) {
+    magazine *loaded = &cache->loaded[size_class];
+
+    if (loaded->count == 0) {
+        magazine *previous = &cache->previous[size_class];
+
+        if (previous->count != 0) {
+            magazine_swap(loaded, previous);
+        } else if ((loaded->head = depot_pop(size_class)) != NULL) {
+            loaded->count = MAGAZINE_CAPACITY;
+        } else if (!magazine_fill(loaded, size_class)) {
+            return NULL;
+        }
+    }
+
+    cached_region *region = loaded->head;
+    loaded->head = region->next;
+    loaded->count--;
+
+    return (region_header *)region - 1;
+}
+
+/**
+ * @brief Gives a small region back to the cache of the calling thread.
+ */
+static void cache_free(thread_cache *cache, region_header *header) {
+    u8 size_class = header->size_class;
+    magazine *loaded = &cache->loaded[size_class];
+
+    if (loaded->count == MAGAZINE_CAPACITY) {
+        magazine *previous = &cache->previous[size_class];
+
+        if (previous->count == MAGAZINE_CAPACITY) {
+            magazine_release(previous, size_class);
+        }
+        magazine_swap(loaded, previous);
+    }
+
+    cached_region *region = (cached_region *)(header + 1);
+    region->next = loaded->head;
+    loaded->head = region;
+    loaded->count++;
 }
 
 #ifdef DEBUG
 void *_mem_alloc_aligned_debug(memory_tag tag, u64 size, u64 alignment, const char *file, u32 line, const char *func) {
 #else
-static void *mem_alloc_aligned(memory_tag tag, u64 size, u64 alignment) {
+API void *mem_alloc_aligned(memory_tag tag, u64 size, u64 alignment) {
 #endif
     if (tag == MEMORY_TAG_UNKNOWN) {
         LOG_WARN("An allocation with an unknown tag was requested. Tag this allocation accordingly.");
     }
 
-    // Calculate the maximum size of the region, taking into account the alignment and the header
-    u64 region_size = size + sizeof(region_header) + alignment;
+    thread_cache *cache = get_thread_cache();
+    if (!budget_check_hard_limit(cache, tag, size)) {
+        return NULL;
+    }
 
-    // Allocate the region
-    void *allocation = platform_allocate(region_size);
-    if (allocation == NULL) {
-        LOG_FATAL("Failed to allocate %llu bytes in tag %s", region_size);
+    region_header *header;
+    if (cache != NULL && size <= SMALL_REGION_MAX_SIZE && alignment <= DEFAULT_ALIGNMENT) {
+        header = cache_allocate(cache, size == 0 ? 0 : (size - 1) / SIZE_CLASS_GRANULARITY);
+    } else {
+        spinlock_acquire(&state->heap_lock);
+        header = heap_allocate(size, MAX(alignment, DEFAULT_ALIGNMENT));
+        spinlock_release(&state->heap_lock);
+
+        if (header != NULL) {
+            header->size_class = SIZE_CLASS_NONE;
+        }
+    }
+
+    if (header == NULL) {
+        LOG_FATAL("Failed to allocate %llu bytes in tag %s", size, TAG_LABELS[tag]);
         return NULL;
     }
 
-    // Initialize the region header in the correct location
-    void *region = (void *)(((u64)allocation + sizeof(region_header) + alignment - 1) / alignment * alignment);
-    region_header *header = (region_header *)((u64)region - sizeof(region_header));
+    void *region = header + 1;
     header->size = size;
-    header->allocation_offset = (u64)header - (u64)allocation;
-    header->allocation_size = region_size;
     header->tag = tag;
+    header->alignment_log2 = __builtin_ctzll(MAX(alignment, DEFAULT_ALIGNMENT));
+    header->sample_id = memory_profiler_record_allocation(size);
 
 #ifdef DEBUG
     header->file = file;
     header->line = line;
     header->func = func;
-    header->prev = state->regions_list_tail[tag];
     header->next = NULL;
 
     // Update the linked list
+    spinlock_acquire(&state->regions_lock);
+    header->prev = state->regions_list_tail[tag];
     if (state->regions_list_tail[tag] != NULL) {
         state->regions_list_tail[tag]->next = header;
     } else {
         state->regions_list_head[tag] = header;
     }
     state->regions_list_tail[tag] = header;
+    spinlock_release(&state->regions_lock);
 #endif
 
     // Update the statistics
-    state->allocation_count[tag]++;
-    state->allocated_size[tag] += region_size;
+    stats_update(cache, tag, 1, tlsf_allocator_block_size(header));
+    if (cache != NULL) {
+        __atomic_store_n(&cache->total_allocation_count, cache->total_allocation_count + 1, __ATOMIC_RELAXED);
+    } else {
+        __atomic_fetch_add(&state->total_allocation_count, 1, __ATOMIC_RELAXED);
+    }
+    budget_update_pressure(cache, tag);
 
     return region;
 }
@@ -145,23 +741,189 @@ static void *mem_alloc_aligned(memory_tag tag, u64 size, u64 alignment) {
  */
 #ifdef DEBUG
 API void *_mem_alloc_debug(memory_tag tag, u64 size, const char *file, u32 line, const char *func) {
-    return _mem_alloc_aligned_debug(tag, size, 1, file, line, func);
+    return _mem_alloc_aligned_debug(tag, size, DEFAULT_ALIGNMENT, file, line, func);
 }
 #else
-API void *mem_alloc(memory_tag tag, u64 size) { return mem_alloc_aligned(tag, size, 1, platform_get_caller()); }
+API void *mem_alloc(memory_tag tag, u64 size) { return mem_alloc_aligned(tag, size, DEFAULT_ALIGNMENT); }
 #endif
 
+/**
+ * @brief Resizes a memory region, moving it only if it cannot be resized in place.
+ *
+ * @param ptr The memory region.
+ * @param size The new size of the region.
+ * @return A pointer to the resized region (which is the given one if it was not moved), or NULL on failure.
+ */
+#ifdef DEBUG
+API void *_mem_realloc_debug(void *ptr, u64 size, const char *file, u32 line, const char *func) {
+#else
+API void *mem_realloc(void *ptr, u64 size) {
+#endif
+    region_header *header = (region_header *)ptr - 1;
+    memory_tag tag = header->tag;
+
+    // Small regions own their whole size class, heap regions may absorb the free block that follows them
+    b8 resized = FALSE;
+    if (header->size_class != SIZE_CLASS_NONE) {
+        resized = size != 0 && size <= (header->size_class + 1u) * SIZE_CLASS_GRANULARITY;
+    } else {
+        thread_cache *cache = get_thread_cache();
+        if (size > header->size && !budget_check_hard_limit(cache, tag, size - header->size)) {
+            return NULL;
+        }
+
+        spinlock_acquire(&state->heap_lock);
+        u64 old_block_size = tlsf_allocator_block_size(header);
+        resized = tlsf_allocator_resize(&state->heap, header, size + sizeof(region_header));
+        u64 new_block_size = tlsf_allocator_block_size(header);
+        spinlock_release(&state->heap_lock);
+
+        if (resized) {
+            stats_update(cache, tag, 0, (i64)new_block_size - (i64)old_block_size);
+            budget_update_pressure(cache, tag);
+        }
+    }
+
+    if (resized) {
+        if (header->sample_id != 0) {
+            memory_profiler_record_free(header->sample_id, header->size);
+        }
+        header->sample_id = memory_profiler_record_allocation(size);
+        header->size = size;
+        return ptr;
+    }
+
+#ifdef DEBUG
+    void *new_ptr = _mem_alloc_aligned_debug(tag, size, 1ull << header->alignment_log2, file, line, func);
+#else
+    void *new_ptr = mem_alloc_aligned(tag, size, 1ull << header->alignment_log2);
+#endif
+    if (new_ptr == NULL) {
+        return NULL;
+    }
+
+    mem_copy(new_ptr, ptr, MIN(size, header->size));
+    mem_free(ptr);
+    return new_ptr;
+}
+
+/**
+ * @brief Gets the size of a memory region allocated with @ref mem_alloc or @ref mem_alloc_aligned.
+ *
+ * @param ptr The memory region.
+ * @return The size requested when the region was allocated.
+ */
+API u64 mem_get_size(const void *ptr) { return ((const region_header *)ptr - 1)->size; }
+
+/**
+ * @brief Records in the statistics (and budgets) of a tag an allocation made outside of the memory system.
+ *
+ * @param tag The tag of the allocation.
+ * @param size The size of the allocation.
+ */
+API void mem_track_external_allocation(memory_tag tag, u64 size) {
+    thread_cache *cache = get_thread_cache();
+    stats_update(cache, tag, 1, size);
+    budget_update_pressure(cache, tag);
+}
+
+/**
+ * @brief Records in the statistics of a tag the free of an allocation recorded with @ref mem_track_external_allocation.
+ *
+ * @param tag The tag of the allocation.
+ * @param size The size of the allocation.
+ */
+API void mem_track_external_free(memory_tag tag, u64 size) {
+    thread_cache *cache = get_thread_cache();
+    stats_update(cache, tag, -1, -(i64)size);
+    budget_update_pressure(cache, tag);
+}
+
+/**
+ * @brief Allocates a memory region from the current frame arena.
+ *
+ * @param size The size of the memory to allocate.
+ * @return A pointer to the allocated memory region, or NULL if the frame arena is exhausted.
+ */
+API void *mem_frame_alloc(u64 size) { return mem_frame_alloc_aligned(size, DEFAULT_ALIGNMENT); }
+
+/**
+ * @brief Allocates an aligned memory region from the current frame arena.
+ *
+ * @param size The size of the memory to allocate.
+ * @param alignment The alignment of the memory to allocate.
+ * @return A pointer to the allocated memory region, or NULL if the frame arena is exhausted.
+ */
+API void *mem_frame_alloc_aligned(u64 size, u64 alignment) {
+    u8 index = __atomic_load_n(&state->current_frame_arena, __ATOMIC_RELAXED);
+    linear_allocator *arena = &state->frame_arenas[index];
+
+    void *block = linear_allocator_allocate_concurrent(arena, size, alignment);
+    if (block == NULL) {
+        return NULL;
+    }
+
+    // Commit the arena lazily, so that the physical memory used is bound to the largest frame seen so far
+    u64 end = (u64)block - (u64)arena->memory + size;
+    if (end > __atomic_load_n(&state->frame_arenas_committed[index], __ATOMIC_ACQUIRE)) {
+        spinlock_acquire(&state->frame_arenas_lock);
+
+        u64 committed = state->frame_arenas_committed[index];
+        if (end > committed) {
+            u64 new_committed = ALIGN_UP(end, state->commit_granularity);
+
+            if (!platform_virtual_commit(arena->memory + committed, new_committed - committed)) {
+                spinlock_release(&state->frame_arenas_lock);
+                LOG_FATAL("Failed to commit %llu bytes for the frame arena", new_committed - committed);
+                return NULL;
+            }
+
+            __atomic_store_n(&state->frame_arenas_committed[index], new_committed, __ATOMIC_RELEASE);
+        }
+
+        spinlock_release(&state->frame_arenas_lock);
+    }
+
+    return block;
+}
+
+/**
+ * @brief Begins a new frame: swaps the frame arenas and resets the one that becomes current, then fires the pressure events
+ * raised since the last frame.
+ */
+void mem_frame_begin() {
+    u8 index = state->current_frame_arena ^ 1;
+    linear_allocator_free_all(&state->frame_arenas[index]);
+    __atomic_store_n(&state->current_frame_arena, index, __ATOMIC_RELEASE);
+
+    // A tag whose usage went back under its soft limit meanwhile has nothing left to shed
+    u32 pending = __atomic_exchange_n(&state->pressure_pending, 0, __ATOMIC_RELAXED);
+    for (u32 tag = 0; tag < MEMORY_TAG_MAX_TAGS; tag++) {
+        if ((pending & (1u << tag)) != 0 && __atomic_load_n(&state->under_pressure[tag], __ATOMIC_RELAXED)) {
+            LOG_WARN("Memory usage of tag %s crossed its soft limit (%llu bytes)",
+                     TAG_LABELS[tag],
+                     state->budgets[tag].soft_limit);
+            event_fire(EVENT_TYPE_MEMORY_PRESSURE, (event_data){.u32 = tag});
+        }
+    }
+}
+
 /**
  * @brief Frees the given memory region.
  *
  * @param ptr The memory region to free.
  */
 API void mem_free(void *ptr) {
+    if (ptr == NULL) {
+        return;
+    }
+
     // TODO: We should find a way to make sure that the given pointer points directly after a valid header
-    region_header *header = (region_header *)((u64)ptr - sizeof(region_header));
+    region_header *header = (region_header *)ptr - 1;
 
 // Update the linked list
 #ifdef DEBUG
+    spinlock_acquire(&state->regions_lock);
     if (header->prev != NULL) {
         header->prev->next = header->next;
     } else {
@@ -173,14 +935,213 @@ API void mem_free(void *ptr) {
     } else {
         state->regions_list_tail[header->tag] = header->prev;
     }
+    spinlock_release(&state->regions_lock);
 #endif
 
     // Update the statistics
-    state->allocation_count[header->tag]--;
-    state->allocated_size[header->tag] -= header->allocation_size;
+    thread_cache *cache = get_thread_cache();
+    stats_update(cache, header->tag, -1, -(i64)tlsf_allocator_block_size(header));
+
+    if (header->sample_id != 0) {
+        memory_profiler_record_free(header->sample_id, header->size);
+    }
 
     // Free the region
-    platform_free(header - header->allocation_offset);
+    memory_tag tag = header->tag;
+    if (cache != NULL && header->size_class != SIZE_CLASS_NONE) {
+        cache_free(cache, header);
+    } else {
+        spinlock_acquire(&state->heap_lock);
+        tlsf_allocator_free(&state->heap, header);
+        spinlock_release(&state->heap_lock);
+    }
+
+    budget_update_pressure(cache, tag);
+}
+
+/**
+ * @brief Sets the budget of a tag.
+ *
+ * @param tag The tag.
+ * @param soft_limit The soft limit in bytes, or 0 for none.
+ * @param hard_limit The hard limit in bytes, or 0 for none.
+ */
+API void mem_set_budget(memory_tag tag, u64 soft_limit, u64 hard_limit) {
+    if (soft_limit != 0 && hard_limit != 0 && soft_limit > hard_limit) {
+        LOG_WARN("The soft limit of tag %s (%llu bytes) is above its hard limit (%llu bytes)",
+                 TAG_LABELS[tag],
+                 soft_limit,
+                 hard_limit);
+    }
+
+    state->budgets[tag].soft_limit = soft_limit;
+    state->budgets[tag].hard_limit = hard_limit;
+    __atomic_store_n(&state->under_pressure[tag], FALSE, __ATOMIC_RELAXED);
+    __atomic_fetch_and(&state->pressure_pending, ~(1u << tag), __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Writes the profile collected by the sampling heap profiler, in the folded stacks format.
+ *
+ * @param path The path of the file to write.
+ * @param kind The kind of profile to write.
+ *
+ * @retval TRUE Success
+ * @retval FALSE Failure (or the profiler is disabled)
+ */
+API b8 mem_profiler_dump(const char *path, memory_profile_kind kind) { return memory_profiler_dump(path, kind); }
+
+/**
+ * @brief Gets the current position in the scratch stack of the calling thread.
+ *
+ * @return The current position in the scratch stack.
+ */
+API scratch_marker mem_scratch_mark() {
+    thread_cache *cache = get_thread_cache();
+    return cache != NULL ? cache->scratch.allocated : 0;
+}
+
+/**
+ * @brief Allocates a temporary memory region from the scratch stack of the calling thread.
+ *
+ * @param size The size of the memory to allocate.
+ * @return A pointer to the allocated memory region, or NULL if the scratch stack is exhausted.
+ */
+API void *mem_scratch_alloc(u64 size) { return mem_scratch_alloc_aligned(size, DEFAULT_ALIGNMENT); }
+
+/**
+ * @brief Allocates an aligned temporary memory region from the scratch stack of the calling thread.
+ *
+ * @param size The size of the memory to allocate.
+ * @param alignment The alignment of the memory to allocate.
+ * @return A pointer to the allocated memory region, or NULL if the scratch stack is exhausted.
+ */
+API void *mem_scratch_alloc_aligned(u64 size, u64 alignment) {
+    thread_cache *cache = get_thread_cache();
+    if (cache == NULL) {
+        LOG_FATAL("Failed to get the allocation cache of the thread");
+        return NULL;
+    }
+
+    linear_allocator *scratch = &cache->scratch;
+    if (scratch->memory == NULL) {
+        void *memory = platform_virtual_reserve(state->scratch_size, FALSE);
+        if (memory == NULL) {
+            LOG_FATAL("Failed to reserve %llu bytes of address space for the scratch stack", state->scratch_size);
+            return NULL;
+        }
+
+        linear_allocator_create(state->scratch_size, memory, scratch);
+        cache->scratch_committed = 0;
+    }
+
+    void *block = linear_allocator_allocate(scratch, size, alignment);
+    if (block == NULL) {
+        return NULL;
+    }
+
+    // Like the frame arenas, the scratch stack is committed lazily
+    if (scratch->allocated > cache->scratch_committed) {
+        u64 committed = cache->scratch_committed;
+        u64 new_committed = MIN(ALIGN_UP(scratch->allocated, COMMIT_GRANULARITY), scratch->total_size);
+
+        if (!platform_virtual_commit(scratch->memory + committed, new_committed - committed)) {
+            LOG_FATAL("Failed to commit %llu bytes for the scratch stack", new_committed - committed);
+            scratch->allocated = (u64)block - (u64)scratch->memory;
+            return NULL;
+        }
+
+        cache->scratch_committed = new_committed;
+    }
+
+    return block;
+}
+
+/**
+ * @brief Rewinds the scratch stack of the calling thread, releasing every region allocated after the marker was taken.
+ *
+ * @param marker The marker to rewind to.
+ */
+API void mem_scratch_rewind(scratch_marker marker) {
+    thread_cache *cache = get_thread_cache();
+    if (cache != NULL) {
+        cache->scratch.allocated = marker;
+    }
+}
+
+/**
+ * @brief Releases the cache of the calling thread: its regions are given back to the shared pools, and its statistics are
+ * merged into the global ones.
+ */
+API void mem_thread_cache_release() {
+    thread_cache *cache = local_cache;
+    if (cache == NULL) {
+        return;
+    }
+
+    for (u8 i = 0; i < SIZE_CLASS_COUNT; i++) {
+        magazine_release(&cache->loaded[i], i);
+        magazine_release(&cache->previous[i], i);
+    }
+
+    for (u64 i = 0; i < MEMORY_TAG_MAX_TAGS; i++) {
+        __atomic_fetch_add(&state->allocation_count[i], (u64)cache->allocation_count_delta[i], __ATOMIC_RELAXED);
+        __atomic_fetch_add(&state->allocated_size[i], (u64)cache->allocated_size_delta[i], __ATOMIC_RELAXED);
+        __atomic_store_n(&cache->allocation_count_delta[i], 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&cache->allocated_size_delta[i], 0, __ATOMIC_RELAXED);
+    }
+
+    __atomic_fetch_add(&state->total_allocation_count, cache->total_allocation_count, __ATOMIC_RELAXED);
+    __atomic_store_n(&cache->total_allocation_count, 0, __ATOMIC_RELAXED);
+
+    // The scratch stack is kept reserved, for the next thread using the cache
+    cache->scratch.allocated = 0;
+
+    spinlock_acquire(&state->thread_caches_lock);
+    cache->in_use = FALSE;
+    spinlock_release(&state->thread_caches_lock);
+
+    local_cache = NULL;
+}
+
+/**
+ * @brief Gets the total number of allocations made since the initialization of the memory system, in all tags.
+ *
+ * @return The number of allocations.
+ */
+API u64 mem_get_total_allocation_count() {
+    u64 total_allocation_count = __atomic_load_n(&state->total_allocation_count, __ATOMIC_RELAXED);
+
+    spinlock_acquire(&state->thread_caches_lock);
+    for (thread_cache *cache = state->thread_caches; cache != NULL; cache = cache->next) {
+        total_allocation_count += __atomic_load_n(&cache->total_allocation_count, __ATOMIC_RELAXED);
+    }
+    spinlock_release(&state->thread_caches_lock);
+
+    return total_allocation_count;
+}
+
+/**
+ * @brief Gets the memory usage of a tag.
+ *
+ * @param[in] tag The tag.
+ * @param[out] out_allocation_count A pointer to the number of live allocations in the tag.
+ * @param[out] out_allocated_size A pointer to the number of bytes allocated in the tag.
+ */
+API void mem_get_usage(memory_tag tag, u64 *out_allocation_count, u64 *out_allocated_size) {
+    u64 allocation_count = __atomic_load_n(&state->allocation_count[tag], __ATOMIC_RELAXED);
+    u64 allocated_size = __atomic_load_n(&state->allocated_size[tag], __ATOMIC_RELAXED);
+
+    // Merge the changes not flushed by the threads yet
+    spinlock_acquire(&state->thread_caches_lock);
+    for (thread_cache *cache = state->thread_caches; cache != NULL; cache = cache->next) {
+        allocation_count += (u64)__atomic_load_n(&cache->allocation_count_delta[tag], __ATOMIC_RELAXED);
+        allocated_size += (u64)__atomic_load_n(&cache->allocated_size_delta[tag], __ATOMIC_RELAXED);
+    }
+    spinlock_release(&state->thread_caches_lock);
+
+    *out_allocation_count = allocation_count;
+    *out_allocated_size = allocated_size;
 }
 
 /**
@@ -3,6 +3,9 @@
  * @author Killian Bellouard (killianbellouard@gmail.com)
  * @brief This file defines the memory management system. It is responsible for allocating and freeing memory, and for tracking
  * the memory usage of the different parts of the engine, by the means of tags.
+ *
+ * Every function can be called from any thread. Small allocations are served from per-thread caches, so threads rarely
+ * contend with each other.
  * @version 0.1
  * @date 2024-06-11
  */
@@ -20,19 +23,56 @@ typedef enum memory_tag {
     MEMORY_TAG_PLATFORM,  // Platform specific data
     MEMORY_TAG_STRING,    // Strings
     MEMORY_TAG_RENDERER,  // Renderer
+    MEMORY_TAG_VULKAN,    // Vulkan driver host memory
     MEMORY_TAG_MAX_TAGS
 } memory_tag;
 
+/** @brief The memory budget of a tag. A limit of 0 means unlimited. */
+typedef struct memory_budget {
+    /** @brief The number of bytes above which @ref EVENT_TYPE_MEMORY_PRESSURE is fired. */
+    u64 soft_limit;
+    /** @brief The number of bytes above which allocations fail. */
+    u64 hard_limit;
+} memory_budget;
+
+/** @brief The kinds of heap profiles. */
+typedef enum memory_profile_kind {
+    /** @brief The bytes allocated since the beginning, per call stack (where the allocation pressure comes from). */
+    MEMORY_PROFILE_ALLOCATED,
+    /** @brief The bytes allocated and not freed yet, per call stack (what holds the memory). */
+    MEMORY_PROFILE_IN_USE,
+} memory_profile_kind;
+
+/** @brief The configuration of the memory system. */
+typedef struct memory_config {
+    /** @brief The size of the virtual address range reserved up-front for the whole memory system, in bytes. */
+    u64 reserve_size;
+    /** @brief The size of each of the two per-frame arenas, in bytes. */
+    u64 frame_arena_size;
+    /** @brief The size of the address range reserved for the scratch stack of each thread, in bytes. */
+    u64 scratch_size;
+    /** @brief The average number of bytes allocated between two samples of the heap profiler, or 0 to disable it. */
+    u64 profiler_sample_interval;
+    /** @brief The maximum number of distinct call stacks recorded by the heap profiler. */
+    u32 profiler_max_stacks;
+    /** @brief The path where the heap profile is written when the memory system is deinitialized, or NULL. */
+    const char *profiler_output_path;
+    /** @brief Whether to ask the OS to back the reserved range with (transparent) huge pages. */
+    b8 huge_pages;
+} memory_config;
+
 /**
  * @brief Initializes the memory system.
  *
  * @note Unlike other systems, ths function will allocate the needed memory itself. As such, it must be the first system to be
  * initialized.
  *
+ * @param[in] config The configuration of the memory system.
+ *
  * @retval TRUE Success
  * @retval FALSE Failure
  */
-b8 mem_init();
+b8 mem_init(const memory_config *config);
 
 /**
  * @brief Deinitializes the memory system.
@@ -61,6 +101,20 @@ API void *_mem_alloc_debug(memory_tag tag, u64 size, const char *file, u32 line,
  */
 #define mem_alloc_aligned(tag, size, alignment) _mem_alloc_aligned_debug(tag, size, alignment, __FILE__, __LINE__, __func__)
 API void *_mem_alloc_aligned_debug(memory_tag tag, u64 size, u64 alignment, const char *file, u32 line, const char *func);
+
+/**
+ * @brief Resizes a memory region, moving it only if it cannot be resized in place.
+ *
+ * The region keeps its tag and alignment. The contents are preserved up to the smaller of the old and new sizes, and the
+ * rest is left uninitialized.
+ *
+ * @param ptr The memory region, allocated with @ref mem_alloc or @ref mem_alloc_aligned (must not be NULL).
+ * @param size The new size of the region.
+ * @return A pointer to the resized region (which is the given one if it was not moved), or NULL on failure, in which case
+ * the given region is left untouched.
+ */
+#define mem_realloc(ptr, size) _mem_realloc_debug(ptr, size, __FILE__, __LINE__, __func__)
+API void *_mem_realloc_debug(void *ptr, u64 size, const char *file, u32 line, const char *func);
 #else
 /**
  * @brief Allocates a memory region of the given size and tag.
@@ -80,8 +134,78 @@ API void *mem_alloc(memory_tag tag, u64 size);
  * @return A pointer to the allocated memory region.
  */
 API void *mem_alloc_aligned(memory_tag tag, u64 size, u64 alignment);
+
+/**
+ * @brief Resizes a memory region, moving it only if it cannot be resized in place.
+ *
+ * The region keeps its tag and alignment. The contents are preserved up to the smaller of the old and new sizes, and the
+ * rest is left uninitialized.
+ *
+ * @param ptr The memory region, allocated with @ref mem_alloc or @ref mem_alloc_aligned (must not be NULL).
+ * @param size The new size of the region.
+ * @return A pointer to the resized region (which is the given one if it was not moved), or NULL on failure, in which case
+ * the given region is left untouched.
+ */
+API void *mem_realloc(void *ptr, u64 size);
 #endif
 
+/**
+ * @brief Gets the size of a memory region allocated with @ref mem_alloc or @ref mem_alloc_aligned.
+ *
+ * @param ptr The memory region.
+ * @return The size requested when the region was allocated.
+ */
+API u64 mem_get_size(const void *ptr);
+
+/**
+ * @brief Records in the statistics (and budgets) of a tag an allocation made outside of the memory system.
+ *
+ * This is used for memory that is allocated by third parties on our behalf, but that we want to see in the reports (like the
+ * internal allocations of the Vulkan driver).
+ *
+ * @param tag The tag of the allocation.
+ * @param size The size of the allocation.
+ */
+API void mem_track_external_allocation(memory_tag tag, u64 size);
+
+/**
+ * @brief Records in the statistics of a tag the free of an allocation recorded with @ref mem_track_external_allocation.
+ *
+ * @param tag The tag of the allocation.
+ * @param size The size of the allocation.
+ */
+API void mem_track_external_free(memory_tag tag, u64 size);
+
+/**
+ * @brief Allocates a memory region from the current frame arena.
+ *
+ * The region stays valid until the beginning of the frame after the next one (the frame arenas are double-buffered), so
+ * data produced during a frame can still be consumed by the renderer during the following one. It must not be freed.
+ *
+ * @param size The size of the memory to allocate.
+ * @return A pointer to the allocated memory region, or NULL if the frame arena is exhausted.
+ */
+API void *mem_frame_alloc(u64 size);
+
+/**
+ * @brief Allocates an aligned memory region from the current frame arena.
+ *
+ * @see mem_frame_alloc
+ *
+ * @param size The size of the memory to allocate.
+ * @param alignment The alignment of the memory to allocate.
+ * @return A pointer to the allocated memory region, or NULL if the frame arena is exhausted.
+ */
+API void *mem_frame_alloc_aligned(u64 size, u64 alignment);
+
+/**
+ * @brief Begins a new frame: swaps the frame arenas and resets the one that becomes current, then fires the pressure events
+ * raised since the last frame (see @ref mem_set_budget).
+ *
+ * @note Called by the engine at the top of each frame, on the main thread.
+ */
+void mem_frame_begin();
+
 /**
  * @brief Frees the given memory region.
  *
@@ -89,6 +213,109 @@ API void *mem_alloc_aligned(memory_tag tag, u64 size, u64 alignment);
  */
 API void mem_free(void *ptr);
 
+/**
+ * @brief Sets the budget of a tag.
+ *
+ * Once the memory allocated in the tag crosses the soft limit, @ref EVENT_TYPE_MEMORY_PRESSURE is fired so that subsystems can
+ * shed load. Allocations happen on any thread, so the event is fired at the beginning of the next frame, on the main
+ * thread. An allocation that would cross the hard limit fails (returns NULL), and a usage report is logged.
+ *
+ * @note Each thread merges its statistics periodically, so the limits may be overshot by a few kilobytes per thread.
+ *
+ * @param tag The tag.
+ * @param soft_limit The soft limit in bytes, or 0 for none.
+ * @param hard_limit The hard limit in bytes, or 0 for none.
+ */
+API void mem_set_budget(memory_tag tag, u64 soft_limit, u64 hard_limit);
+
+/**
+ * @brief Writes the profile collected by the sampling heap profiler, in the folded stacks format (one call stack per line,
+ * frames from the outermost to the innermost separated by semicolons, followed by a number of bytes). It can be turned into a
+ * flamegraph with flamegraph.pl, or opened in speedscope.
+ *
+ * @note The sizes are estimated from the samples, so they are only accurate for call stacks allocating much more than the
+ * sample interval.
+ *
+ * @param path The path of the file to write.
+ * @param kind The kind of profile to write.
+ *
+ * @retval TRUE Success
+ * @retval FALSE Failure (or the profiler is disabled)
+ */
+API b8 mem_profiler_dump(const char *path, memory_profile_kind kind);
+
+/** @brief A position in the scratch stack of a thread, to rewind to. */
+typedef u64 scratch_marker;
+
+/**
+ * @brief Gets the current position in the scratch stack of the calling thread.
+ *
+ * Temporary buffers are allocated from the scratch stack with @ref mem_scratch_alloc, and released all at once by rewinding to
+ * a marker taken before them with @ref mem_scratch_rewind. Markers must be rewound in LIFO order, so scratch buffers can be
+ * used by nested functions as long as each one rewinds to its own marker before returning.
+ *
+ * @return The current position in the scratch stack.
+ */
+API scratch_marker mem_scratch_mark();
+
+/**
+ * @brief Allocates a temporary memory region from the scratch stack of the calling thread.
+ *
+ * The region stays valid until the stack is rewound to a marker taken before it. It must not be freed, nor shared with other
+ * threads.
+ *
+ * @param size The size of the memory to allocate.
+ * @return A pointer to the allocated memory region, or NULL if the scratch stack is exhausted.
+ */
+API void *mem_scratch_alloc(u64 size);
+
+/**
+ * @brief Allocates an aligned temporary memory region from the scratch stack of the calling thread.
+ *
+ * @see mem_scratch_alloc
+ *
+ * @param size The size of the memory to allocate.
+ * @param alignment The alignment of the memory to allocate.
+ * @return A pointer to the allocated memory region, or NULL if the scratch stack is exhausted.
+ */
+API void *mem_scratch_alloc_aligned(u64 size, u64 alignment);
+
+/**
+ * @brief Rewinds the scratch stack of the calling thread, releasing every region allocated after the marker was taken.
+ *
+ * @param marker The marker to rewind to.
+ */
+API void mem_scratch_rewind(scratch_marker marker);
+
+/**
+ * @brief Gets the total number of allocations made since the initialization of the memory system (freed or not), in all tags.
+ *
+ * @note The result may be slightly off while other threads are allocating.
+ *
+ * @return The number of allocations.
+ */
+API u64 mem_get_total_allocation_count();
+
+/**
+ * @brief Releases the allocation cache of the calling thread: its regions are given back to the shared pools, and its
+ * statistics are merged into the global ones.
+ *
+ * @note Every thread that allocated memory must call this before exiting, so that its cache can be reused by other threads.
+ * The cache is recreated if the thread allocates again.
+ */
+API void mem_thread_cache_release();
+
+/**
+ * @brief Gets the memory usage of a tag.
+ *
+ * @note The result may be slightly off while other threads are allocating.
+ *
+ * @param[in] tag The tag.
+ * @param[out] out_allocation_count A pointer to the number of live allocations in the tag.
+ * @param[out] out_allocated_size A pointer to the number of bytes allocated in the tag.
+ */
+API void mem_get_usage(memory_tag tag, u64 *out_allocation_count, u64 *out_allocated_size);
+
 /**
  * @brief Zeroes out the given memory region.
  *
@@ -0,0 +1,224 @@
+#include "memory_profiler.h"
+#include "core/spinlock.h"
+#include "platform/filesystem.h"
+#include "platform/platform.h"
+
+#define LOG_SCOPE "MEMORY PROFILER"
+#include "core/log.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/** @brief The maximum number of frames recorded per call stack. */
+#define MAX_STACK_DEPTH 32
+
+/** @brief The number of frames skipped at the top of the call stacks (the profiler and the memory system). */
+#define SKIPPED_FRAMES 2
+
+/** @brief The largest number of stacks, so that their identifiers fit in 16 bits (0 is reserved for "not sampled"). */
+#define MAX_STACKS 32768
+
+/** @brief The maximum length of a frame name in the reports. */
+#define MAX_SYMBOL_NAME_LENGTH 256
+
+/** @brief A call stack, and the samples attributed to it. */
+typedef struct profiler_stack {
+    u64 hash;
+    u32 depth;
+    void *frames[MAX_STACK_DEPTH];
+
+    /** @brief The (estimated) number of bytes allocated by this call stack since the beginning. */
+    u64 allocated_size;
+    /** @brief The (estimated) number of bytes allocated by this call stack and not freed yet. */
+    u64 in_use_size;
+} profiler_stack;
+
+typedef struct memory_profiler_state {
+    u64 sample_interval;
+
+    /** @brief The stacks, in an open addressing hash table indexed by the hash of their frames. */
+    profiler_stack *stacks;
+    /** @brief The capacity of the table (a power of two). */
+    u32 capacity;
+    /** @brief The number of stacks recorded. */
+    u32 count;
+    /** @brief The size of the address range holding the table. */
+    u64 stacks_size;
+
+    /** @brief The lock protecting the table. */
+    spinlock lock;
+} memory_profiler_state;
+
+static memory_profiler_state state = {};
+
+/** @brief The number of bytes the calling thread can allocate before its next sample. */
+static _Thread_local i64 bytes_until_sample = 0;
+
+/** @brief The state of the random number generator of the calling thread, used to jitter the sample interval. */
+static _Thread_local u64 random_state = 0;
+
+static u64 next_random() {
+    if (random_state == 0) {
+        random_state = (u64)&random_state | 1;
+    }
+
+    // xorshift64
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 7;
+    random_state ^= random_state << 17;
+    return random_state;
+}
+
+/**
+ * @brief Draws the number of bytes until the next sample, uniformly in [interval / 2, 3 * interval / 2], so that allocation
+ * patterns repeating with the same period as the interval are not always (or never) sampled.
+ */
+static i64 next_sample_distance() { return state.sample_interval / 2 + next_random() % (state.sample_interval + 1); }
+
+/** @brief Gets the number of bytes a sample of the given size accounts for. */
+static u64 sample_weight(u64 size) { return size > state.sample_interval ? size : state.sample_interval; }
+
+b8 memory_profiler_init(u64 sample_interval, u32 max_stacks) {
+    state.sample_interval = sample_interval;
+    if (sample_interval == 0) {
+        return TRUE;
+    }
+
+    u32 capacity = 1;
+    while (capacity < max_stacks && capacity < MAX_STACKS) {
+        capacity <<= 1;
+    }
+
+    // The table is kept out of the heap, so that the profiler does not show up in its own reports
+    u64 stacks_size = capacity * sizeof(profiler_stack);
+    profiler_stack *stacks = platform_virtual_reserve(stacks_size, FALSE);
+    if (stacks == NULL || !platform_virtual_commit(stacks, stacks_size)) {
+        LOG_ERROR("Failed to allocate the table of call stacks (%llu bytes)", stacks_size);
+        if (stacks != NULL) {
+            platform_virtual_release(stacks, stacks_size);
+        }
+        state.sample_interval = 0;
+        return FALSE;
+    }
+
+    state.stacks = stacks;
+    state.capacity = capacity;
+    state.count = 0;
+    state.stacks_size = stacks_size;
+    return TRUE;
+}
+
+void memory_profiler_deinit() {
+    if (state.stacks != NULL) {
+        platform_virtual_release(state.stacks, state.stacks_size);
+    }
+
+    mem_zero(&state, sizeof(memory_profiler_state));
+}
+
+u16 memory_profiler_record_allocation(u64 size) {
+    if (state.sample_interval == 0) {
+        return 0;
+    }
+
+    bytes_until_sample -= size;
+    if (bytes_until_sample > 0) {
+        return 0;
+    }
+    bytes_until_sample = next_sample_distance();
+
+    void *frames[MAX_STACK_DEPTH];
+    u32 depth = platform_capture_stack_trace(SKIPPED_FRAMES, MAX_STACK_DEPTH, frames);
+
+    // FNV-1a over the return addresses
+    u64 hash = 0xcbf29ce484222325;
+    for (u32 i = 0; i < depth; i++) {
+        hash ^= (u64)frames[i];
+        hash *= 0x100000001b3;
+    }
+
+    u16 sample_id = 0;
+    spinlock_acquire(&state.lock);
+
+    u32 index = hash & (state.capacity - 1);
+    while (TRUE) {
+        profiler_stack *stack = &state.stacks[index];
+
+        if (stack->depth == 0) {
+            // Keep a free slot, so that lookups always terminate
+            if (state.count + 1 >= state.capacity) {
+                break;
+            }
+
+            stack->hash = hash;
+            stack->depth = depth;
+            mem_copy(stack->frames, frames, depth * sizeof(void *));
+            state.count++;
+        }
+
+        if (stack->hash == hash && stack->depth == depth && memcmp(stack->frames, frames, depth * sizeof(void *)) == 0) {
+            stack->allocated_size += sample_weight(size);
+            stack->in_use_size += sample_weight(size);
+            sample_id = index + 1;
+            break;
+        }
+
+        index = (index + 1) & (state.capacity - 1);
+    }
+
+    spinlock_release(&state.lock);
+    return sample_id;
+}
+
+void memory_profiler_record_free(u16 sample_id, u64 size) {
+    spinlock_acquire(&state.lock);
+    state.stacks[sample_id - 1].in_use_size -= sample_weight(size);
+    spinlock_release(&state.lock);
+}
+
+b8 memory_profiler_dump(const char *path, memory_profile_kind kind) {
+    if (state.sample_interval == 0) {
+        LOG_ERROR("The memory profiler is disabled");
+        return FALSE;
+    }
+
+    scratch_marker marker = mem_scratch_mark();
+
+    // Each line holds at most MAX_STACK_DEPTH names, their separators, and the size
+    u64 max_line_size = MAX_STACK_DEPTH * MAX_SYMBOL_NAME_LENGTH + 32;
+    char symbol[MAX_SYMBOL_NAME_LENGTH];
+
+    spinlock_acquire(&state.lock);
+
+    u64 report_size = 0;
+    char *report = mem_scratch_alloc(state.count * max_line_size + 1);
+    if (report == NULL) {
+        spinlock_release(&state.lock);
+        mem_scratch_rewind(marker);
+        return FALSE;
+    }
+
+    for (u32 i = 0; i < state.capacity; i++) {
+        profiler_stack *stack = &state.stacks[i];
+        u64 size = kind == MEMORY_PROFILE_IN_USE ? stack->in_use_size : stack->allocated_size;
+        if (stack->depth == 0 || size == 0) {
+            continue;
+        }
+
+        for (u32 j = stack->depth; j > 0; j--) {
+            platform_get_symbol_name(stack->frames[j - 1], symbol, MAX_SYMBOL_NAME_LENGTH);
+            report_size += snprintf(report + report_size, MAX_SYMBOL_NAME_LENGTH + 1, "%s%s", symbol, j > 1 ? ";" : "");
+        }
+        report_size += snprintf(report + report_size, 32, " %llu\n", (unsigned long long)size);
+    }
+
+    spinlock_release(&state.lock);
+
+    b8 result = filesystem_node_write(path, report, report_size, TRUE);
+    if (!result) {
+        LOG_ERROR("Failed to write the memory profile to %s", path);
+    }
+
+    mem_scratch_rewind(marker);
+    return result;
+}
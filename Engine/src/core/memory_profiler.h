@@ -0,0 +1,64 @@
+/**
+ * @file memory_profiler.h
+ * @author Killian Bellouard (killianbellouard@gmail.com)
+ * @brief This file defines the sampling heap profiler used by the memory system. It is available in every build configuration.
+ *
+ * Instead of tracking every allocation, each thread counts down the bytes it allocates, and captures the call stack of the
+ * allocation that brings the countdown under zero, about once every sample interval bytes. Each sample is accounted with a
+ * weight of max(size, sample interval) bytes, so that the totals approximate the real ones. Samples are aggregated by call
+ * stack, and can be dumped in the "folded stacks" format read by flamegraph.pl, speedscope or inferno.
+ *
+ * @note This is internal to the memory system. Use @ref mem_profiler_dump to get a report.
+ * @version 0.1
+ * @date 2024-08-12
+ */
+
+#pragma once
+
+#include "common.h"
+#include "core/memory.h"
+
+/**
+ * @brief Initializes the profiler.
+ *
+ * @param[in] sample_interval The average number of bytes allocated between two samples, or 0 to disable the profiler.
+ * @param[in] max_stacks The maximum number of distinct call stacks recorded.
+ *
+ * @retval TRUE Success
+ * @retval FALSE Failure
+ */
+b8 memory_profiler_init(u64 sample_interval, u32 max_stacks);
+
+/**
+ * @brief Deinitializes the profiler.
+ */
+void memory_profiler_deinit();
+
+/**
+ * @brief Records an allocation, if it is sampled.
+ *
+ * @param[in] size The size of the allocation.
+ *
+ * @return The identifier of the sample, to pass to @ref memory_profiler_record_free, or 0 if the allocation is not sampled.
+ */
+u16 memory_profiler_record_allocation(u64 size);
+
+/**
+ * @brief Records the free of a sampled allocation.
+ *
+ * @param[in] sample_id The identifier returned by @ref memory_profiler_record_allocation.
+ * @param[in] size The size of the allocation.
+ */
+void memory_profiler_record_free(u16 sample_id, u64 size);
+
+/**
+ * @brief Writes the samples in the folded stacks format: one line per call stack, with the frames from the outermost to the
+ * innermost separated by semicolons, followed by the number of bytes.
+ *
+ * @param[in] path The path of the file to write.
+ * @param[in] kind The kind of profile to write.
+ *
+ * @retval TRUE Success
+ * @retval FALSE Failure
+ */
+b8 memory_profiler_dump(const char *path, memory_profile_kind kind);
@@ -0,0 +1,116 @@
+#include "mpmc_queue.h"
+#include "core/atomic.h"
+#include "core/spinlock.h"
+#include "math/math.h"
+#include "memory.h"
+
+#define LOG_SCOPE "MPMC QUEUE"
+#include "core/log.h"
+
+/**
+ * @brief The header of a cell, followed by its element.
+ *
+ * The sequence of the cell of position p is p while it is free to be written for that position, p + 1 once its element is
+ * written, and p + capacity once the element is read, which makes it free for the next lap.
+ */
+typedef struct mpmc_queue_cell {
+    u64 sequence;
+} mpmc_queue_cell;
+
+static inline mpmc_queue_cell *cell_at(const mpmc_queue *queue, u64 position) {
+    return (mpmc_queue_cell *)(queue->cells + (position & queue->mask) * queue->cell_size);
+}
+
+API b8 mpmc_queue_init(mpmc_queue *queue, u32 element_size, u32 capacity) {
+    mem_zero(queue, sizeof(mpmc_queue));
+
+    // A single cell would be free for the next lap as soon as it is read, so it could not tell a full queue from an empty one
+    u32 rounded_capacity = 2;
+    while (rounded_capacity < capacity) {
+        rounded_capacity *= 2;
+    }
+
+    u32 cell_size = ALIGN_UP(sizeof(mpmc_queue_cell) + element_size, _Alignof(mpmc_queue_cell));
+    queue->cells = mem_alloc_aligned(MEMORY_TAG_ENGINE, (u64)rounded_capacity * cell_size, CACHE_LINE_SIZE);
+    if (queue->cells == NULL) {
+        LOG_ERROR("Failed to allocate %u cells", rounded_capacity);
+        return FALSE;
+    }
+
+    queue->element_size = element_size;
+    queue->cell_size = cell_size;
+    queue->mask = rounded_capacity - 1;
+
+    for (u64 i = 0; i < rounded_capacity; i++) {
+        cell_at(queue, i)->sequence = i;
+    }
+
+    return TRUE;
+}
+
+API void mpmc_queue_destroy(mpmc_queue *queue) {
+    if (queue->cells != NULL) {
+        mem_free(queue->cells);
+    }
+
+    mem_zero(queue, sizeof(mpmc_queue));
+}
+
+API b8 mpmc_queue_push(mpmc_queue *queue, const void *value) {
+    u64 position = atomic_load_u64(&queue->enqueue_position, ATOMIC_ORDER_RELAXED);
+    mpmc_queue_cell *cell;
+
+    for (;;) {
+        cell = cell_at(queue, position);
+        i64 difference = (i64)(atomic_load_u64(&cell->sequence, ATOMIC_ORDER_ACQUIRE) - position);
+
+        if (difference == 0) {
+            // The cell is free for this position, claim it (a failed exchange reloads the position)
+            if (atomic_compare_exchange_u64(&queue->enqueue_position, &position, position + 1, ATOMIC_ORDER_RELAXED)) {
+                break;
+            }
+        } else if (difference < 0) {
+            // The element of the previous lap has not been read yet
+            return FALSE;
+        } else {
+            // Another producer claimed the position
+            position = atomic_load_u64(&queue->enqueue_position, ATOMIC_ORDER_RELAXED);
+            CPU_RELAX();
+        }
+    }
+
+    mem_copy(cell + 1, value, queue->element_size);
+
+    // The element must be visible before the consumers see the cell as written
+    atomic_store_u64(&cell->sequence, position + 1, ATOMIC_ORDER_RELEASE);
+    return TRUE;
+}
+
+API b8 mpmc_queue_pop(mpmc_queue *queue, void *value) {
+    u64 position = atomic_load_u64(&queue->dequeue_position, ATOMIC_ORDER_RELAXED);
+    mpmc_queue_cell *cell;
+
+    for (;;) {
+        cell = cell_at(queue, position);
+        i64 difference = (i64)(atomic_load_u64(&cell->sequence, ATOMIC_ORDER_ACQUIRE) - (position + 1));
+
+        if (difference == 0) {
+            if (atomic_compare_exchange_u64(&queue->dequeue_position, &position, position + 1, ATOMIC_ORDER_RELAXED)) {
+                break;
+            }
+        } else if (difference < 0) {
+            // The element of this position has not been written yet
+            return FALSE;
+        } else {
+            // Another consumer claimed the position
+            position = atomic_load_u64(&queue->dequeue_position, ATOMIC_ORDER_RELAXED);
+            CPU_RELAX();
+        }
+    }
+
+    mem_copy(value, cell + 1, queue->element_size);
+
+    // The element must be copied before the producers see the cell as free for the next lap
+    atomic_store_u64(&cell->sequence, position + queue->mask + 1, ATOMIC_ORDER_RELEASE);
+    return TRUE;
+}
@@ -0,0 +1,80 @@
+/**
+ * @file mpmc_queue.h
+ * @author Killian Bellouard (killianbellouard@gmail.com)
+ * @brief This file defines a bounded lock-free queue, for any number of producer and consumer threads.
+ *
+ * The queue is a ring buffer of cells whose capacity is a power of two, after Dmitry Vyukov's bounded MPMC queue. Each cell
+ * holds a sequence number telling whether it is ready to be written or read at a given position: a producer claims the next
+ * position with a compare-and-swap only once its cell is free, writes the element and publishes it by advancing the sequence
+ * of the cell, and consumers do the same on their side. Threads never wait for each other, except by retrying when another
+ * thread claimed the same position first. The positions of the producers and of the consumers are on their own cache lines.
+ *
+ * @note The queue is aligned on a cache line, which the heap does not guarantee: allocate it with @ref mem_alloc_aligned.
+ * @version 0.1
+ * @date 2024-08-20
+ */
+
+#pragma once
+
+#include "common.h"
+
+/** @brief A bounded multiple-producer multiple-consumer queue. */
+typedef struct mpmc_queue {
+    /** @brief The size of an element. */
+    _Alignas(CACHE_LINE_SIZE) u32 element_size;
+    /** @brief The size of a cell: its sequence number followed by the element. */
+    u32 cell_size;
+    /** @brief The capacity minus one, to wrap the positions. */
+    u64 mask;
+    /** @brief The cells. */
+    u8 *cells;
+
+    /** @brief The position of the next element to push, claimed by the producers. */
+    _Alignas(CACHE_LINE_SIZE) u64 enqueue_position;
+
+    /** @brief The position of the next element to pop, claimed by the consumers. */
+    _Alignas(CACHE_LINE_SIZE) u64 dequeue_position;
+} mpmc_queue;
+
+/**
+ * @brief Initializes a multiple-producer multiple-consumer queue.
+ *
+ * @param[out] queue The queue to initialize.
+ * @param[in] element_size The size of the elements.
+ * @param[in] capacity The number of elements the queue can hold, rounded up to a power of two (at least 2).
+ *
+ * @retval TRUE Success
+ * @retval FALSE Failure
+ */
+API b8 mpmc_queue_init(mpmc_queue *queue, u32 element_size, u32 capacity);
+
+/**
+ * @brief Destroys a multiple-producer multiple-consumer queue. The elements left in it are dropped.
+ *
+ * @warning No other thread may access the queue anymore.
+ *
+ * @param[in] queue The queue to destroy.
+ */
+API void mpmc_queue_destroy(mpmc_queue *queue);
+
+/**
+ * @brief Pushes an element in a multiple-producer multiple-consumer queue.
+ *
+ * @param[in] queue The queue.
+ * @param[in] value A pointer to the value to copy in the queue.
+ *
+ * @retval TRUE Success
+ * @retval FALSE Failure (the queue is full)
+ */
+API b8 mpmc_queue_push(mpmc_queue *queue, const void *value);
+
+/**
+ * @brief Pops an element from a multiple-producer multiple-consumer queue.
+ *
+ * @param[in] queue The queue.
+ * @param[out] value A pointer to copy the value of the element to.
+ *
+ * @retval TRUE Success
+ * @retval FALSE Failure (the queue is empty)
+ */
+API b8 mpmc_queue_pop(mpmc_queue *queue, void *value);
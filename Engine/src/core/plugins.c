@@ -1,18 +1,30 @@
 #include "core/plugins.h"
-#include "core/dynamic_array.h"
+#include "core/hashmap.h"
+#include "core/slot_map.h"
 #include "core/str.h"
+#include "core/str_intern.h"
 
 #define LOG_SCOPE "PLUGIN SYSTEM"
 #include "core/log.h"
 
 struct plugins_system_state {
-    DYNARRAY(plugin) plugins;
+    /** @brief The loaded plugins, of @ref plugin. */
+    slot_map plugins;
+    /** @brief The handle of each loaded plugin, from its interned name. */
+    HASHMAP(str_id, uuid) handles;
 };
 
 static plugins_system_state *state = NULL;
 
 static void plugin_unload(plugin *);
 
+/** @brief Finds a loaded plugin from its interned name, or returns NULL if it is not loaded. */
+static plugin *find_plugin(str_id name_id) {
+    uuid *handle;
+    HASHMAP_GET(state->handles, name_id, handle);
+    return handle != NULL ? slot_map_get(&state->plugins, *handle) : NULL;
+}
+
 /**
  * @brief Initializes the plugin system.
  *
@@ -33,6 +45,7 @@ b8 plugins_init(plugins_system_state *state_storage, u64 *size_requirement) {
 
     state = (plugins_system_state *)state_storage;
     mem_zero(state, sizeof(plugins_system_state));
+    slot_map_init(&state->plugins, sizeof(plugin), 0, NULL);
 
     return TRUE;
 }
@@ -43,15 +56,12 @@ b8 plugins_init(plugins_system_state *state_storage, u64 *size_requirement) {
  * @param[in] state A pointer to the state of the plugin system.
  */
 void plugins_deinit(plugins_system_state *state) {
-    for (uuid i = 0; i < state->plugins.count; i++) {
-        if (state->plugins.data[i].name == NULL) {
-            continue;
-        }
-
-        plugin_unload(&state->plugins.data[i]);
+    for (u32 i = 0; i < state->plugins.count; i++) {
+        plugin_unload(SLOT_MAP_AT(state->plugins, plugin, i));
     }
 
-    DYNARRAY_CLEAR(state->plugins);
+    slot_map_destroy(&state->plugins);
+    HASHMAP_CLEAR(state->handles);
 }
 
 /**
@@ -64,66 +74,65 @@ void plugins_deinit(plugins_system_state *state) {
  * @retval FALSE Failure
  */
 b8 plugins_load(const char *name, plugin *result) {
-    for (uuid i = 0; i < state->plugins.count; i++) {
-        if (str_eq(state->plugins.data[i].name, name)) {
-            // Already loaded
-            return TRUE;
-        }
-    }
-
-    uuid found_uuid = INVALID_UUID;
-    for (uuid i = 0; i < state->plugins.count; i++) {
-        if (state->plugins.data[i].name == NULL) {
-            found_uuid = i;
-            break;
-        }
+    // Names are interned, so that they are compared by address
+    str_id name_id = str_intern(name);
+    if (name_id == NULL) {
+        LOG_ERROR("Failed to load plugin %s: Could not intern its name", name);
+        return FALSE;
     }
 
-    if (found_uuid == INVALID_UUID) {
-        found_uuid = state->plugins.count;
-        DYNARRAY_PUSH(state->plugins, (plugin){});
+    if (find_plugin(name_id) != NULL) {
+        // Already loaded
+        return TRUE;
     }
 
-    // TODO: String functions
-    state->plugins.data[found_uuid].name = mem_alloc(MEMORY_TAG_STRING, str_len(name) + 1);
-    mem_copy((char *)state->plugins.data[found_uuid].name, name, str_len(name) + 1);
-
     LOG_TRACE("Loading plugin %s", name);
 
-    dynamic_library library;
-    if (!platform_dynamic_library_open(name, &library)) {
+    plugin loaded = { .name = name_id->string };
+    if (!platform_dynamic_library_open(name, &loaded.library)) {
         LOG_ERROR("Failed to load plugin %s: Could not open library", name);
-        mem_free((char *)state->plugins.data[found_uuid].name);
-        state->plugins.data[found_uuid].name = NULL;
         return FALSE;
     }
 
-    state->plugins.data[found_uuid].library = library;
-
     plugin_interface *interface;
-    if (!platform_dynamic_library_get_symbol(library, "_plugin_interface", (void **)&interface)) {
+    if (!platform_dynamic_library_get_symbol(loaded.library, "_plugin_interface", (void **)&interface)) {
         LOG_ERROR("Failed to load plugin %s: Could not get symbol _plugin_interface", name);
-        platform_dynamic_library_close(library);
-        mem_free((char *)state->plugins.data[found_uuid].name);
-        state->plugins.data[found_uuid].name = NULL;
+        platform_dynamic_library_close(loaded.library);
         return FALSE;
     }
 
-    state->plugins.data[found_uuid].interface = *interface;
+    loaded.interface = *interface;
 
     PFN_plugin_init init = interface->init;
     if (init) {
         LOG_TRACE("Initializing plugin %s", name);
-        if (!init(&state->plugins.data[found_uuid].interface.state)) {
+        if (!init(&loaded.interface.state)) {
             LOG_ERROR("Failed to initialize plugin %s", name);
-            platform_dynamic_library_close(library);
-            mem_free((char *)state->plugins.data[found_uuid].name);
-            state->plugins.data[found_uuid].name = NULL;
+            platform_dynamic_library_close(loaded.library);
             return FALSE;
         }
     }
 
-    *result = state->plugins.data[found_uuid];
+    uuid handle;
+    if (!slot_map_insert(&state->plugins, &loaded, &handle)) {
+        LOG_ERROR("Failed to register plugin %s", name);
+        plugin_unload(&loaded);
+        return FALSE;
+    }
+
+    // The name is not in the map yet, so the count only stays the same if the map could not grow
+    u32 count = state->handles.count;
+    HASHMAP_SET(state->handles, name_id, handle);
+    if (state->handles.count == count) {
+        LOG_ERROR("Failed to register plugin %s", name);
+        slot_map_remove(&state->plugins, handle);
+        plugin_unload(&loaded);
+        return FALSE;
+    }
+
+    plugin *registered = slot_map_get(&state->plugins, handle);
+    registered->handle = handle;
+    *result = *registered;
 
     return TRUE;
 }
@@ -139,18 +148,21 @@ b8 plugins_load(const char *name, plugin *result) {
  * @retval FALSE Failure
  */
 b8 plugins_unload(const char *name) {
-    for (uuid i = 0; i < state->plugins.count; i++) {
-        if (state->plugins.data[i].name == NULL) {
-            continue;
-        }
+    str_id name_id = str_intern_find(str_view_from_cstr(name));
+    if (name_id == NULL) {
+        return FALSE;
+    }
 
-        if (str_eq(state->plugins.data[i].name, name)) {
-            plugin_unload(&state->plugins.data[i]);
-            return TRUE;
-        }
+    plugin *plugin = find_plugin(name_id);
+    if (plugin == NULL) {
+        return FALSE;
     }
 
-    return FALSE;
+    uuid handle = plugin->handle;
+    plugin_unload(plugin);
+    slot_map_remove(&state->plugins, handle);
+    HASHMAP_REMOVE(state->handles, name_id);
+    return TRUE;
 }
 
 /**
@@ -163,18 +175,18 @@ b8 plugins_unload(const char *name) {
  * @retval FALSE Failure
  */
 b8 plugins_get(const char *name, plugin *plugin) {
-    for (uuid i = 0; i < state->plugins.count; i++) {
-        if (state->plugins.data[i].name == NULL) {
-            continue;
-        }
+    str_id name_id = str_intern_find(str_view_from_cstr(name));
+    if (name_id == NULL) {
+        return FALSE;
+    }
 
-        if (str_eq(state->plugins.data[i].name, name)) {
-            *plugin = state->plugins.data[i];
-            return TRUE;
-        }
+    struct plugin *found = find_plugin(name_id);
+    if (found == NULL) {
+        return FALSE;
     }
 
-    return FALSE;
+    *plugin = *found;
+    return TRUE;
 }
 
 static void plugin_unload(plugin *plugin) {
@@ -188,6 +200,5 @@ static void plugin_unload(plugin *plugin) {
         LOG_ERROR("Failed to close plugin %s", plugin->name);
     }
 
-    mem_free((char *)plugin->name);
     mem_zero(plugin, sizeof(struct plugin));
 }
@@ -51,6 +51,9 @@ typedef struct plugin {
 
     /** @brief The library handle to the plugin. */
     dynamic_library library;
+
+    /** @brief The handle of the plugin in the plugin system. */
+    uuid handle;
 } plugin;
 
 /**
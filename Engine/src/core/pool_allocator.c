@@ -0,0 +1,93 @@
+#include "pool_allocator.h"
+#include "math/math.h"
+
+#define LOG_SCOPE "POOL ALLOCATOR"
+#include "core/log.h"
+
+/** @brief The header of a chunk, followed by its elements. */
+typedef struct pool_chunk {
+    struct pool_chunk *next;
+} pool_chunk;
+
+/** @brief The link stored in a free element. */
+typedef struct pool_free_element {
+    struct pool_free_element *next;
+} pool_free_element;
+
+static b8 pool_grow(pool_allocator *pool) {
+    u64 elements_offset = ALIGN_UP(sizeof(pool_chunk), pool->alignment);
+    pool_chunk *chunk = mem_alloc_aligned(
+        pool->tag, elements_offset + pool->element_size * pool->elements_per_chunk, MAX(pool->alignment, _Alignof(pool_chunk)));
+    if (chunk == NULL) {
+        return FALSE;
+    }
+
+    chunk->next = pool->chunks;
+    pool->chunks = chunk;
+
+    // Thread the new elements in the free list, in address order
+    u8 *elements = (u8 *)chunk + elements_offset;
+    for (u32 i = pool->elements_per_chunk; i > 0; i--) {
+        pool_free_element *element = (pool_free_element *)(elements + (i - 1) * pool->element_size);
+        element->next = pool->free_list;
+        pool->free_list = element;
+    }
+
+    pool->capacity += pool->elements_per_chunk;
+    return TRUE;
+}
+
+API void pool_allocator_create(pool_allocator *pool, u64 element_size, u64 alignment, u32 elements_per_chunk, memory_tag tag) {
+    alignment = MAX(alignment, _Alignof(pool_free_element));
+
+    pool->element_size = ALIGN_UP(MAX(element_size, sizeof(pool_free_element)), alignment);
+    pool->alignment = alignment;
+    pool->elements_per_chunk = MAX(elements_per_chunk, 1);
+    pool->tag = tag;
+    pool->free_list = NULL;
+    pool->chunks = NULL;
+    pool->allocated_count = 0;
+    pool->capacity = 0;
+}
+
+API void pool_allocator_destroy(pool_allocator *pool) {
+    if (pool->allocated_count != 0) {
+        LOG_WARN("Destroying a pool with %u elements still allocated", pool->allocated_count);
+    }
+
+    pool_chunk *chunk = pool->chunks;
+    while (chunk != NULL) {
+        pool_chunk *next = chunk->next;
+        mem_free(chunk);
+        chunk = next;
+    }
+
+    pool->free_list = NULL;
+    pool->chunks = NULL;
+    pool->allocated_count = 0;
+    pool->capacity = 0;
+}
+
+API void *pool_allocator_allocate(pool_allocator *pool) {
+    if (pool->free_list == NULL && !pool_grow(pool)) {
+        LOG_ERROR("Failed to grow the pool by %u elements", pool->elements_per_chunk);
+        return NULL;
+    }
+
+    pool_free_element *element = pool->free_list;
+    pool->free_list = element->next;
+    pool->allocated_count++;
+
+    return element;
+}
+
+API void pool_allocator_free(pool_allocator *pool, void *element) {
+    if (element == NULL) {
+        return;
+    }
+
+    pool_free_element *free_element = element;
+    free_element->next = pool->free_list;
+    pool->free_list = free_element;
+    pool->allocated_count--;
+}
@@ -0,0 +1,98 @@
+/**
+ * @file pool_allocator.h
+ * @author Killian Bellouard (killianbellouard@gmail.com)
+ * @brief This file defines a pool allocator, serving fixed-size elements in O(1) from chunks allocated on the heap.
+ *
+ * Free elements are kept in an intrusive free list. When it is empty, a new chunk of elements is allocated from the heap (with
+ * the tag of the pool), so churning elements does not touch the heap once the pool has grown to its working size. Chunks are
+ * only given back to the heap when the pool is destroyed.
+ * @version 0.1
+ * @date 2024-08-07
+ */
+
+#pragma once
+
+#include "common.h"
+#include "memory.h"
+
+/** @brief A pool allocator. */
+typedef struct pool_allocator {
+    /** @brief The size of an element, rounded up so that it can hold a free list link and keep its alignment. */
+    u64 element_size;
+    /** @brief The alignment of an element. */
+    u64 alignment;
+    /** @brief The number of elements allocated at once when the pool grows. */
+    u32 elements_per_chunk;
+    /** @brief The tag used for the chunks. */
+    memory_tag tag;
+
+    /** @brief The head of the free list. */
+    void *free_list;
+    /** @brief The head of the list of chunks. */
+    void *chunks;
+
+    /** @brief The number of elements currently handed out. */
+    u32 allocated_count;
+    /** @brief The total number of elements in the chunks. */
+    u32 capacity;
+} pool_allocator;
+
+/**
+ * @brief Creates a pool allocator for elements of the given type.
+ *
+ * @param[out] pool A pointer to the pool to initialize.
+ * @param[in] type The type of the elements.
+ * @param[in] elements_per_chunk The number of elements allocated at once when the pool grows.
+ * @param[in] tag The tag used for the chunks.
+ */
+#define POOL_ALLOCATOR_CREATE(pool, type, elements_per_chunk, tag) \
+    pool_allocator_create(pool, sizeof(type), _Alignof(type), elements_per_chunk, tag)
+
+/**
+ * @brief Allocates an element of the given type from a pool.
+ *
+ * @param[in] pool The pool to allocate from.
+ * @param[in] type The type of the elements of the pool.
+ */
+#define POOL_ALLOCATE(pool, type) ((type *)pool_allocator_allocate(pool))
+
+/**
+ * @brief Creates a pool allocator.
+ *
+ * @note No memory is allocated until the first element is requested.
+ *
+ * @param[out] pool A pointer to the pool to initialize.
+ * @param[in] element_size The size of the elements.
+ * @param[in] alignment The alignment of the elements (must be a power of two).
+ * @param[in] elements_per_chunk The number of elements allocated at once when the pool grows.
+ * @param[in] tag The tag used for the chunks.
+ */
+API void pool_allocator_create(pool_allocator *pool, u64 element_size, u64 alignment, u32 elements_per_chunk, memory_tag tag);
+
+/**
+ * @brief Destroys a pool allocator, freeing all its chunks.
+ *
+ * @warning Every element allocated from the pool becomes invalid.
+ *
+ * @param[in] pool The pool to destroy.
+ */
+API void pool_allocator_destroy(pool_allocator *pool);
+
+/**
+ * @brief Allocates an element from the pool.
+ *
+ * @note The content of the element is undefined.
+ *
+ * @param[in] pool The pool to allocate from.
+ *
+ * @return A pointer to the element, or NULL if the pool could not grow.
+ */
+API void *pool_allocator_allocate(pool_allocator *pool);
+
+/**
+ * @brief Gives an element back to the pool.
+ *
+ * @param[in] pool The pool the element was allocated from.
+ * @param[in] element The element to free.
+ */
+API void pool_allocator_free(pool_allocator *pool, void *element);
@@ -0,0 +1,174 @@
+#include "slot_map.h"
+
+#define LOG_SCOPE "SLOT MAP"
+#include "core/log.h"
+
+/** @brief The end of the free list. */
+#define NO_SLOT 0xFFFFFFFF
+
+/** @brief The smallest capacity of a map that holds elements. */
+#define MIN_CAPACITY 8
+
+/** @brief The alignment of the elements, whose type is not known. */
+#define ELEMENT_ALIGNMENT 16
+
+/** @brief A slot. Its generation is odd while it holds an element, and even while it is free. */
+typedef struct slot_map_slot {
+    u32 generation;
+    /** @brief The dense index of the element of the slot, or the next free slot if it is free. */
+    u32 index;
+} slot_map_slot;
+
+static inline uuid make_handle(u32 slot, u32 generation) { return ((u64)generation << 32) | slot; }
+
+/** @brief Resizes the storage to the given capacity, linking the new slots in the free list. */
+static b8 slot_map_grow(slot_map *map, u32 new_capacity) {
+    void *data = allocator_reallocate(map->allocator,
+                                      map->data,
+                                      (u64)map->capacity * map->element_size,
+                                      (u64)new_capacity * map->element_size,
+                                      ELEMENT_ALIGNMENT);
+    if (data == NULL) {
+        return FALSE;
+    }
+    map->data = data;
+
+    u32 *dense_slots = allocator_reallocate(
+        map->allocator, map->dense_slots, map->capacity * sizeof(u32), new_capacity * sizeof(u32), _Alignof(u32));
+    if (dense_slots == NULL) {
+        return FALSE;
+    }
+    map->dense_slots = dense_slots;
+
+    slot_map_slot *slots = allocator_reallocate(map->allocator,
+                                                map->slots,
+                                                map->capacity * sizeof(slot_map_slot),
+                                                new_capacity * sizeof(slot_map_slot),
+                                                _Alignof(slot_map_slot));
+    if (slots == NULL) {
+        return FALSE;
+    }
+    map->slots = slots;
+
+    // Link the new slots in index order, in front of the (empty) free list
+    for (u32 i = map->capacity; i < new_capacity; i++) {
+        slots[i].generation = 0;
+        slots[i].index = i + 1 < new_capacity ? i + 1 : map->free_head;
+    }
+
+    map->free_head = map->capacity;
+    map->capacity = new_capacity;
+    return TRUE;
+}
+
+/** @brief Gets the slot of a handle, or NULL if the handle does not refer to a live element. */
+static slot_map_slot *find_slot(const slot_map *map, uuid handle) {
+    u32 slot = (u32)handle;
+    if (slot >= map->capacity || map->slots[slot].generation != (u32)(handle >> 32) || (map->slots[slot].generation & 1) == 0) {
+        return NULL;
+    }
+
+    return &map->slots[slot];
+}
+
+API void slot_map_init(slot_map *map, u32 element_size, u32 initial_capacity, const allocator *allocator) {
+    mem_zero(map, sizeof(slot_map));
+    map->element_size = element_size;
+    map->free_head = NO_SLOT;
+    map->allocator = allocator != NULL ? allocator : allocator_get_heap(MEMORY_TAG_DYNARRAY);
+
+    if (initial_capacity != 0 && !slot_map_grow(map, initial_capacity)) {
+        LOG_ERROR("Failed to allocate %u slots", initial_capacity);
+    }
+}
+
+API void slot_map_destroy(slot_map *map) {
+    allocator_free(map->allocator, map->data, (u64)map->capacity * map->element_size);
+    allocator_free(map->allocator, map->dense_slots, map->capacity * sizeof(u32));
+    allocator_free(map->allocator, map->slots, map->capacity * sizeof(slot_map_slot));
+    mem_zero(map, sizeof(slot_map));
+}
+
+API b8 slot_map_insert(slot_map *map, const void *value, uuid *handle) {
+    if (map->free_head == NO_SLOT && !slot_map_grow(map, map->capacity < MIN_CAPACITY ? MIN_CAPACITY : map->capacity * 2)) {
+        LOG_ERROR("Failed to grow to %u slots", map->capacity * 2);
+        return FALSE;
+    }
+
+    u32 slot_index = map->free_head;
+    slot_map_slot *slot = &map->slots[slot_index];
+    map->free_head = slot->index;
+
+    slot->generation++;
+    slot->index = map->count;
+    map->dense_slots[map->count] = slot_index;
+
+    void *element = (u8 *)map->data + (u64)map->count * map->element_size;
+    if (value != NULL) {
+        mem_copy(element, value, map->element_size);
+    } else {
+        mem_zero(element, map->element_size);
+    }
+
+    map->count++;
+    *handle = make_handle(slot_index, slot->generation);
+    return TRUE;
+}
+
+API void *slot_map_get(const slot_map *map, uuid handle) {
+    slot_map_slot *slot = find_slot(map, handle);
+    return slot != NULL ? (u8 *)map->data + (u64)slot->index * map->element_size : NULL;
+}
+
+API b8 slot_map_remove(slot_map *map, uuid handle) {
+    slot_map_slot *slot = find_slot(map, handle);
+    if (slot == NULL) {
+        return FALSE;
+    }
+
+    // Fill the hole with the last element, to keep the elements packed
+    u32 index = slot->index;
+    u32 last = map->count - 1;
+    if (index != last) {
+        mem_copy((u8 *)map->data + (u64)index * map->element_size,
+                 (u8 *)map->data + (u64)last * map->element_size,
+                 map->element_size);
+        map->dense_slots[index] = map->dense_slots[last];
+        map->slots[map->dense_slots[index]].index = index;
+    }
+    map->count--;
+
+    slot->generation++;
+    slot->index = map->free_head;
+    map->free_head = (u32)handle;
+    return TRUE;
+}
+
+API b8 slot_map_remove_ordered(slot_map *map, uuid handle) {
+    slot_map_slot *slot = find_slot(map, handle);
+    if (slot == NULL) {
+        return FALSE;
+    }
+
+    // Close the hole by shifting the following elements down, and point their slots to their new indices
+    u32 index = slot->index;
+    u32 tail = map->count - index - 1;
+    mem_move((u8 *)map->data + (u64)index * map->element_size,
+             (u8 *)map->data + (u64)(index + 1) * map->element_size,
+             (u64)tail * map->element_size);
+    mem_move(&map->dense_slots[index], &map->dense_slots[index + 1], tail * sizeof(u32));
+    for (u32 i = index; i < index + tail; i++) {
+        map->slots[map->dense_slots[i]].index = i;
+    }
+    map->count--;
+
+    slot->generation++;
+    slot->index = map->free_head;
+    map->free_head = (u32)handle;
+    return TRUE;
+}
+
+API uuid slot_map_handle_at(const slot_map *map, u32 index) {
+    u32 slot = map->dense_slots[index];
+    return make_handle(slot, map->slots[slot].generation);
+}
@@ -0,0 +1,122 @@
+/**
+ * @file slot_map.h
+ * @author Killian Bellouard (killianbellouard@gmail.com)
+ * @brief This file defines a slot map: a container handing out generational handles to the elements it stores.
+ *
+ * Elements are stored densely, so iterating over them is a walk over an array, and a removal moves the last element in the
+ * place of the removed one. Handles go through a table of slots: each slot holds the index of its element in the dense array,
+ * and a generation counter incremented whenever the slot is taken or released. A handle carries the generation of its slot
+ * when it was handed out, so a handle to a removed element (even when its slot is reused) is detected instead of aliasing the
+ * new element. Free slots are linked in a free list, so inserts and removals are O(1).
+ * @version 0.1
+ * @date 2024-08-19
+ */
+
+#pragma once
+
+#include "common.h"
+#include "core/allocator.h"
+
+/** @brief A slot map. */
+typedef struct slot_map {
+    /** @brief The size of an element. */
+    u32 element_size;
+    /** @brief The number of elements. */
+    u32 count;
+    /** @brief The number of slots, which is also the capacity of the dense arrays. */
+    u32 capacity;
+    /** @brief The index of the first free slot, or 0xFFFFFFFF if every slot is taken. */
+    u32 free_head;
+    /** @brief The elements, densely packed. */
+    void *data;
+    /** @brief The index of the slot of each element. */
+    u32 *dense_slots;
+    /** @brief The slots. */
+    struct slot_map_slot *slots;
+    /** @brief The allocator of the storage. */
+    const allocator *allocator;
+} slot_map;
+
+/**
+ * @brief Gets a pointer to the element at the given dense index (below the count) of a slot map.
+ *
+ * @param[in] map The slot map.
+ * @param[in] type The type of the elements.
+ * @param[in] index The dense index of the element.
+ */
+#define SLOT_MAP_AT(map, type, index) (&((type *)(map).data)[index])
+
+/**
+ * @brief Initializes a slot map.
+ *
+ * @note No memory is allocated if the initial capacity is 0.
+ *
+ * @param[out] map The slot map to initialize.
+ * @param[in] element_size The size of the elements.
+ * @param[in] initial_capacity The number of elements the map can hold before growing.
+ * @param[in] allocator The allocator of the storage (which must outlive the map), or NULL for the heap.
+ */
+API void slot_map_init(slot_map *map, u32 element_size, u32 initial_capacity, const allocator *allocator);
+
+/**
+ * @brief Destroys a slot map, freeing its storage. Every handle becomes invalid.
+ *
+ * @param[in] map The slot map to destroy.
+ */
+API void slot_map_destroy(slot_map *map);
+
+/**
+ * @brief Inserts an element in a slot map.
+ *
+ * @param[in] map The slot map.
+ * @param[in] value A pointer to the value to copy in the element, or NULL to zero it.
+ * @param[out] handle A pointer to store the handle of the element.
+ *
+ * @retval TRUE Success
+ * @retval FALSE Failure (the map could not grow)
+ */
+API b8 slot_map_insert(slot_map *map, const void *value, uuid *handle);
+
+/**
+ * @brief Gets the element of a handle.
+ *
+ * @note The pointer is invalidated by the next insert or removal.
+ *
+ * @param[in] map The slot map.
+ * @param[in] handle The handle of the element.
+ *
+ * @return A pointer to the element, or NULL if the handle is invalid (or its element was removed).
+ */
+API void *slot_map_get(const slot_map *map, uuid handle);
+
+/**
+ * @brief Removes the element of a handle. The last element is moved in its place.
+ *
+ * @param[in] map The slot map.
+ * @param[in] handle The handle of the element.
+ *
+ * @retval TRUE Success
+ * @retval FALSE Failure (the handle is invalid, or its element was already removed)
+ */
+API b8 slot_map_remove(slot_map *map, uuid handle);
+
+/**
+ * @brief Removes the element of a handle, shifting the elements after it down to keep the order of the elements. O(n).
+ *
+ * @param[in] map The slot map.
+ * @param[in] handle The handle of the element.
+ *
+ * @retval TRUE Success
+ * @retval FALSE Failure (the handle is invalid, or its element was already removed)
+ */
+API b8 slot_map_remove_ordered(slot_map *map, uuid handle);
+
+/**
+ * @brief Gets the handle of the element at the given dense index, to identify the elements met while iterating.
+ *
+ * @param[in] map The slot map.
+ * @param[in] index The dense index of the element (below the count).
+ *
+ * @return The handle of the element.
+ */
+API uuid slot_map_handle_at(const slot_map *map, u32 index);
@@ -0,0 +1,43 @@
+/**
+ * @file spinlock.h
+ * @author Killian Bellouard (killianbellouard@gmail.com)
+ * @brief This file defines a minimal spinlock, for very short critical sections in low level systems that cannot depend on
+ * the platform layer (like the memory system).
+ * @version 0.1
+ * @date 2024-08-12
+ */
+
+#pragma once
+
+#include "common.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define CPU_RELAX() __builtin_ia32_pause()
+#elif defined(__aarch64__)
+#define CPU_RELAX() __asm__ volatile("yield")
+#else
+#define CPU_RELAX()
+#endif
+
+/** @brief A spinlock. Zero-initialized spinlocks are unlocked. */
+typedef b8 spinlock;
+
+/**
+ * @brief Acquires a spinlock, busy-waiting until it is available.
+ *
+ * @param[in] lock The lock to acquire.
+ */
+static inline void spinlock_acquire(spinlock *lock) {
+    while (__atomic_test_and_set(lock, __ATOMIC_ACQUIRE)) {
+        while (__atomic_load_n(lock, __ATOMIC_RELAXED)) {
+            CPU_RELAX();
+        }
+    }
+}
+
+/**
+ * @brief Releases a spinlock.
+ *
+ * @param[in] lock The lock to release.
+ */
+static inline void spinlock_release(spinlock *lock) { __atomic_clear(lock, __ATOMIC_RELEASE); }
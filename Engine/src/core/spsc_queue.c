@@ -0,0 +1,74 @@
+#include "spsc_queue.h"
+#include "core/atomic.h"
+#include "memory.h"
+
+#define LOG_SCOPE "SPSC QUEUE"
+#include "core/log.h"
+
+API b8 spsc_queue_init(spsc_queue *queue, u32 element_size, u32 capacity) {
+    mem_zero(queue, sizeof(spsc_queue));
+
+    u32 rounded_capacity = 1;
+    while (rounded_capacity < capacity) {
+        rounded_capacity *= 2;
+    }
+
+    queue->data = mem_alloc_aligned(MEMORY_TAG_ENGINE, (u64)rounded_capacity * element_size, CACHE_LINE_SIZE);
+    if (queue->data == NULL) {
+        LOG_ERROR("Failed to allocate %u elements", rounded_capacity);
+        return FALSE;
+    }
+
+    queue->element_size = element_size;
+    queue->mask = rounded_capacity - 1;
+    return TRUE;
+}
+
+API void spsc_queue_destroy(spsc_queue *queue) {
+    if (queue->data != NULL) {
+        mem_free(queue->data);
+    }
+
+    mem_zero(queue, sizeof(spsc_queue));
+}
+
+API b8 spsc_queue_push(spsc_queue *queue, const void *value) {
+    u64 tail = atomic_load_u64(&queue->tail, ATOMIC_ORDER_RELAXED);
+
+    // Only read the head of the consumer when the queue looks full, it has popped elements since the last time otherwise
+    if (tail - queue->cached_head > queue->mask) {
+        queue->cached_head = atomic_load_u64(&queue->head, ATOMIC_ORDER_ACQUIRE);
+        if (tail - queue->cached_head > queue->mask) {
+            return FALSE;
+        }
+    }
+
+    mem_copy(queue->data + (tail & queue->mask) * queue->element_size, value, queue->element_size);
+
+    // The element must be visible before the consumer sees the new tail
+    atomic_store_u64(&queue->tail, tail + 1, ATOMIC_ORDER_RELEASE);
+    return TRUE;
+}
+
+API b8 spsc_queue_pop(spsc_queue *queue, void *value) {
+    u64 head = atomic_load_u64(&queue->head, ATOMIC_ORDER_RELAXED);
+
+    if (head == queue->cached_tail) {
+        queue->cached_tail = atomic_load_u64(&queue->tail, ATOMIC_ORDER_ACQUIRE);
+        if (head == queue->cached_tail) {
+            return FALSE;
+        }
+    }
+
+    mem_copy(value, queue->data + (head & queue->mask) * queue->element_size, queue->element_size);
+
+    // The element must be copied before the producer can overwrite it
+    atomic_store_u64(&queue->head, head + 1, ATOMIC_ORDER_RELEASE);
+    return TRUE;
+}
+
+API u32 spsc_queue_count(spsc_queue *queue) {
+    u64 head = atomic_load_u64(&queue->head, ATOMIC_ORDER_ACQUIRE);
+    u64 tail = atomic_load_u64(&queue->tail, ATOMIC_ORDER_ACQUIRE);
+    return tail > head ? (u32)(tail - head) : 0;
+}
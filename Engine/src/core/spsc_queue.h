@@ -0,0 +1,92 @@
+/**
+ * @file spsc_queue.h
+ * @author Killian Bellouard (killianbellouard@gmail.com)
+ * @brief This file defines a bounded lock-free queue, for one producer thread and one consumer thread.
+ *
+ * The queue is a ring buffer whose capacity is a power of two. The producer only writes the tail and the consumer only writes
+ * the head, each on its own cache line, so neither ever waits for the other: pushing an element is a copy and a release store
+ * of the tail. Each side also keeps a copy of the index of the other side, and only reads the real one when the queue looks
+ * full (or empty) with its copy, so the cache line of the other side is rarely pulled in.
+ *
+ * @note The queue is aligned on a cache line, which the heap does not guarantee: allocate it with @ref mem_alloc_aligned.
+ * @version 0.1
+ * @date 2024-08-20
+ */
+
+#pragma once
+
+#include "common.h"
+
+/** @brief A bounded single-producer single-consumer queue. */
+typedef struct spsc_queue {
+    /** @brief The size of an element. */
+    _Alignas(CACHE_LINE_SIZE) u32 element_size;
+    /** @brief The capacity minus one, to wrap the indices. */
+    u32 mask;
+    /** @brief The elements. */
+    u8 *data;
+
+    /** @brief The number of elements popped so far, written by the consumer. */
+    _Alignas(CACHE_LINE_SIZE) u64 head;
+    /** @brief The tail, as last read by the consumer. */
+    u64 cached_tail;
+
+    /** @brief The number of elements pushed so far, written by the producer. */
+    _Alignas(CACHE_LINE_SIZE) u64 tail;
+    /** @brief The head, as last read by the producer. */
+    u64 cached_head;
+} spsc_queue;
+
+/**
+ * @brief Initializes a single-producer single-consumer queue.
+ *
+ * @param[out] queue The queue to initialize.
+ * @param[in] element_size The size of the elements.
+ * @param[in] capacity The number of elements the queue can hold, rounded up to a power of two.
+ *
+ * @retval TRUE Success
+ * @retval FALSE Failure
+ */
+API b8 spsc_queue_init(spsc_queue *queue, u32 element_size, u32 capacity);
+
+/**
+ * @brief Destroys a single-producer single-consumer queue. The elements left in it are dropped.
+ *
+ * @warning No other thread may access the queue anymore.
+ *
+ * @param[in] queue The queue to destroy.
+ */
+API void spsc_queue_destroy(spsc_queue *queue);
+
+/**
+ * @brief Pushes an element in a single-producer single-consumer queue. Must only be called from the producer thread.
+ *
+ * @param[in] queue The queue.
+ * @param[in] value A pointer to the value to copy in the queue.
+ *
+ * @retval TRUE Success
+ * @retval FALSE Failure (the queue is full)
+ */
+API b8 spsc_queue_push(spsc_queue *queue, const void *value);
+
+/**
+ * @brief Pops an element from a single-producer single-consumer queue. Must only be called from the consumer thread.
+ *
+ * @param[in] queue The queue.
+ * @param[out] value A pointer to copy the value of the element to.
+ *
+ * @retval TRUE Success
+ * @retval FALSE Failure (the queue is empty)
+ */
+API b8 spsc_queue_pop(spsc_queue *queue, void *value);
+
+/**
+ * @brief Gets the number of elements in a single-producer single-consumer queue.
+ *
+ * @note The result may already be outdated when it is returned, if the other thread is pushing or popping.
+ *
+ * @param[in] queue The queue.
+ *
+ * @return The number of elements.
+ */
+API u32 spsc_queue_count(spsc_queue *queue);
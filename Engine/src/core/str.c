@@ -96,6 +96,17 @@ char *str_view_dup(str_view view) {
     return dup;
 }
 
+char *str_view_dup_scratch(str_view view) {
+    char *dup = mem_scratch_alloc(view.size + 1);
+    if (dup == NULL) {
+        return NULL;
+    }
+
+    mem_copy(dup, view.begin, view.size);
+    dup[view.size] = 0;
+    return dup;
+}
+
 char *str_dup(const char *str) {
     u64 size = strlen(str) + 1;
     char *dup = mem_alloc(MEMORY_TAG_STRING, size);
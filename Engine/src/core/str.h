@@ -151,6 +151,17 @@ b8 str_eqi(const char *a, const char *b);
  */
 char *str_view_dup(str_view view);
 
+/**
+ * @brief Copies a string view on the scratch stack of the calling thread
+ *
+ * @note The copy is released when the scratch stack is rewound (see @ref mem_scratch_rewind).
+ *
+ * @param[in] view The string view
+ *
+ * @returns The copied string, or NULL if the scratch stack is exhausted
+ */
+char *str_view_dup_scratch(str_view view);
+
 /**
  * @brief Copies a string
  *
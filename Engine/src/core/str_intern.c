@@ -0,0 +1,196 @@
+#include "str_intern.h"
+#include "core/hash.h"
+#include "core/spinlock.h"
+#include "math/math.h"
+#include "memory.h"
+
+#define LOG_SCOPE "STRING INTERNER"
+#include "core/log.h"
+
+/** @brief The size of the arena chunks holding the strings. Longer strings get a chunk of their own. */
+#define CHUNK_SIZE (64 * 1024)
+
+/** @brief The initial number of slots of the table. */
+#define INITIAL_CAPACITY 1024
+
+/** @brief A chunk of the arena, followed by the strings. */
+typedef struct intern_chunk {
+    struct intern_chunk *next;
+} intern_chunk;
+
+/**
+ * @brief The table of handles, using open addressing with linear probing. Interned strings are never removed.
+ *
+ * Lookups do not lock: handles are published with release semantics once their string is written, and when the table grows,
+ * the new one is published the same way. Previous tables are kept until the interner is deinitialized, for the lookups that
+ * may still probe them.
+ */
+typedef struct intern_table {
+    /** @brief The previous table. */
+    struct intern_table *retired;
+    /** @brief The number of slots, always a power of two. */
+    u64 capacity;
+    str_id slots[];
+} intern_table;
+
+/** @brief The state of the string interner. */
+typedef struct str_intern_state {
+    /** @brief The lock taken to intern a new string. */
+    spinlock lock;
+
+    /** @brief The chunks of the arena, the first one being the current one. */
+    intern_chunk *chunks;
+    /** @brief The next free byte of the current chunk. */
+    u8 *cursor;
+    /** @brief The end of the current chunk. */
+    u8 *end;
+
+    /** @brief The current table, read atomically. */
+    intern_table *table;
+    /** @brief The number of interned strings. */
+    u32 count;
+} str_intern_state;
+
+static str_intern_state state = {};
+
+/** @brief Finds the slot of a string in a table, which is either empty or holds the handle to the string. */
+static str_id *find_slot(intern_table *table, str_view view, u64 view_hash) {
+    u64 mask = table->capacity - 1;
+
+    for (u64 index = view_hash & mask;; index = (index + 1) & mask) {
+        str_id id = __atomic_load_n(&table->slots[index], __ATOMIC_ACQUIRE);
+        if (id == NULL || (id->hash == view_hash && str_view_eq_view(view, (str_view){ id->string, id->length }))) {
+            return &table->slots[index];
+        }
+    }
+}
+
+/**
+ * @brief Replaces the table with one twice as large.
+ *
+ * @note The lock must be held.
+ */
+static b8 grow_table() {
+    intern_table *old_table = state.table;
+    u64 new_capacity = old_table ? old_table->capacity * 2 : INITIAL_CAPACITY;
+
+    intern_table *new_table = mem_alloc(MEMORY_TAG_STRING, sizeof(intern_table) + new_capacity * sizeof(str_id));
+    if (new_table == NULL) {
+        return FALSE;
+    }
+
+    mem_zero(new_table->slots, new_capacity * sizeof(str_id));
+    new_table->capacity = new_capacity;
+    new_table->retired = old_table;
+
+    // The new table is not published yet, so plain accesses are enough to fill it
+    u64 mask = new_capacity - 1;
+    for (u64 i = 0; old_table != NULL && i < old_table->capacity; i++) {
+        str_id id = old_table->slots[i];
+        if (id == NULL) {
+            continue;
+        }
+
+        u64 index = id->hash & mask;
+        while (new_table->slots[index] != NULL) {
+            index = (index + 1) & mask;
+        }
+        new_table->slots[index] = id;
+    }
+
+    __atomic_store_n(&state.table, new_table, __ATOMIC_RELEASE);
+    return TRUE;
+}
+
+/** @brief Copies a string in the arena. */
+static interned_str *arena_store(str_view view, u64 view_hash) {
+    u64 size = ALIGN_UP(sizeof(interned_str) + view.size + 1, _Alignof(interned_str));
+
+    if (state.cursor == NULL || (u64)(state.end - state.cursor) < size) {
+        u64 chunk_size = MAX(CHUNK_SIZE, sizeof(intern_chunk) + size);
+        intern_chunk *chunk = mem_alloc(MEMORY_TAG_STRING, chunk_size);
+        if (chunk == NULL) {
+            return NULL;
+        }
+
+        chunk->next = state.chunks;
+        state.chunks = chunk;
+        state.cursor = (u8 *)chunk + ALIGN_UP(sizeof(intern_chunk), _Alignof(interned_str));
+        state.end = (u8 *)chunk + chunk_size;
+    }
+
+    interned_str *id = (interned_str *)state.cursor;
+    state.cursor += size;
+
+    id->hash = view_hash;
+    id->length = view.size;
+    mem_copy(id->string, view.begin, view.size);
+    id->string[view.size] = '\0';
+    return id;
+}
+
+static str_id str_intern_find_hashed(str_view view, u64 view_hash) {
+    intern_table *table = __atomic_load_n(&state.table, __ATOMIC_ACQUIRE);
+    return table != NULL ? __atomic_load_n(find_slot(table, view, view_hash), __ATOMIC_ACQUIRE) : NULL;
+}
+
+API str_id str_intern(const char *string) { return str_intern_view(str_view_from_cstr(string)); }
+
+API str_id str_intern_view(str_view view) {
+    u64 view_hash = hash_str_view(view);
+
+    // Most strings are already interned, so look them up without locking first
+    str_id id = str_intern_find_hashed(view, view_hash);
+    if (id != NULL) {
+        return id;
+    }
+
+    spinlock_acquire(&state.lock);
+
+    // Keep the table at most half full
+    if ((state.table == NULL || (state.count + 1) * 2 > state.table->capacity) && !grow_table()) {
+        spinlock_release(&state.lock);
+        LOG_ERROR("Failed to grow the table");
+        return NULL;
+    }
+
+    // Another thread may have interned the string in the meantime
+    str_id *slot = find_slot(state.table, view, view_hash);
+    id = *slot;
+
+    if (id == NULL) {
+        id = arena_store(view, view_hash);
+        if (id == NULL) {
+            spinlock_release(&state.lock);
+            LOG_ERROR("Failed to store \"%.*s\"", STR_VIEW_PRINT(view));
+            return NULL;
+        }
+
+        // The string must be visible before its handle is
+        __atomic_store_n(slot, id, __ATOMIC_RELEASE);
+        state.count++;
+    }
+
+    spinlock_release(&state.lock);
+    return id;
+}
+
+API str_id str_intern_find(str_view view) { return str_intern_find_hashed(view, hash_str_view(view)); }
+
+void str_intern_deinit() {
+    intern_chunk *chunk = state.chunks;
+    while (chunk != NULL) {
+        intern_chunk *next = chunk->next;
+        mem_free(chunk);
+        chunk = next;
+    }
+
+    intern_table *table = state.table;
+    while (table != NULL) {
+        intern_table *retired = table->retired;
+        mem_free(table);
+        table = retired;
+    }
+
+    state = (str_intern_state){};
+}
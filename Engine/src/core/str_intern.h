@@ -0,0 +1,68 @@
+/**
+ * @file str_intern.h
+ * @author Killian Bellouard (killianbellouard@gmail.com)
+ * @brief This file defines the string interner, which stores a single copy of each distinct string.
+ *
+ * Interning a string returns a handle to its unique copy, carrying its hash and length. Two handles are equal if and only if
+ * their strings are equal, so comparing interned strings is a pointer comparison, and hashing them is reading a field. Interned
+ * strings are stored in an arena and are never freed, until the engine shuts down: only intern strings from a bounded set (keys,
+ * names, paths), not strings that change every frame.
+ *
+ * @note The interner can be used from any thread. Looking up a string that is already interned does not lock.
+ * @version 0.1
+ * @date 2024-08-16
+ */
+
+#pragma once
+
+#include "common.h"
+#include "core/str.h"
+
+/** @brief An interned string. */
+typedef struct interned_str {
+    /** @brief The hash of the string. */
+    u64 hash;
+    /** @brief The length of the string, without the null terminator. */
+    u32 length;
+    /** @brief The null-terminated string. */
+    char string[];
+} interned_str;
+
+/** @brief A handle to an interned string. Handles are stable, and equal if and only if their strings are equal. */
+typedef const interned_str *str_id;
+
+/**
+ * @brief Interns a null-terminated string.
+ *
+ * @param[in] string The string to intern.
+ *
+ * @return The handle to the interned string.
+ */
+API str_id str_intern(const char *string);
+
+/**
+ * @brief Interns a string view.
+ *
+ * @param[in] view The string to intern.
+ *
+ * @return The handle to the interned string.
+ */
+API str_id str_intern_view(str_view view);
+
+/**
+ * @brief Finds the handle of a string, without interning it.
+ *
+ * Use it to look up strings coming from outside (like user queries), so that they do not fill the interner.
+ *
+ * @param[in] view The string to find.
+ *
+ * @return The handle to the interned string, or NULL if the string has never been interned.
+ */
+API str_id str_intern_find(str_view view);
+
+/**
+ * @brief Frees every interned string.
+ *
+ * @warning Every handle becomes invalid. This is only called by the engine when it shuts down.
+ */
+void str_intern_deinit();
@@ -0,0 +1,234 @@
+#include "core/hash.h"
+#include "core/hashtable_group.h"
+#include "core/str.h"
+#include "hashtable.h"
+#include "math/math.h"
+#include "memory.h"
+
+#define LOG_SCOPE "SWISS HASHTABLE"
+#include "core/log.h"
+
+/** @brief The header of a slot, followed by its value. */
+typedef struct swiss_hashtable_slot {
+    char *key;
+} swiss_hashtable_slot;
+
+static inline u64 slot_stride(const swiss_hashtable *table) {
+    return ALIGN_UP(sizeof(swiss_hashtable_slot) + table->element_size, _Alignof(swiss_hashtable_slot));
+}
+
+static inline swiss_hashtable_slot *slot_at(const swiss_hashtable *table, u64 index) {
+    return (swiss_hashtable_slot *)((u8 *)table->slots + index * slot_stride(table));
+}
+
+/**
+ * @brief Allocates the control bytes and the slots of a table, in one block.
+ *
+ * The control bytes come first so that they stay aligned for the group loads, and every slot starts empty.
+ */
+static b8 allocate_storage(swiss_hashtable *table, u32 capacity) {
+    u8 *block = allocator_allocate(table->allocator, capacity + capacity * slot_stride(table), HASHTABLE_GROUP_SIZE);
+    if (block == NULL) {
+        LOG_ERROR("Failed to allocate %u slots", capacity);
+        return FALSE;
+    }
+
+    mem_set(block, (u8)HASHTABLE_CONTROL_EMPTY, capacity);
+
+    table->control = (i8 *)block;
+    table->slots = block + capacity;
+    table->capacity = capacity;
+    table->growth_left = hashtable_group_max_entries(capacity) - table->count;
+    return TRUE;
+}
+
+/** @brief Copies a key with the allocator of the table. */
+static char *key_copy(const swiss_hashtable *table, const char *key) {
+    u64 size = str_len(key) + 1;
+    char *copy = allocator_allocate(table->allocator, size, 1);
+    if (copy != NULL) {
+        mem_copy(copy, key, size);
+    }
+
+    return copy;
+}
+
+static void key_free(const swiss_hashtable *table, char *key) { allocator_free(table->allocator, key, str_len(key) + 1); }
+
+/** @brief Finds the index of the slot holding the given key, or returns -1 if the key is not in the table. */
+static i64 find_slot(const swiss_hashtable *table, const char *key, u64 key_hash) {
+    u64 group_mask = table->capacity / HASHTABLE_GROUP_SIZE - 1;
+    u64 group = HASHTABLE_H1(key_hash) & group_mask;
+
+    for (u64 step = 1;; step++) {
+        const i8 *control = table->control + group * HASHTABLE_GROUP_SIZE;
+
+        // Keys are only compared when their 7 bits of hash match, which is rare for the wrong ones
+        u32 matches = hashtable_group_match(control, HASHTABLE_H2(key_hash));
+        while (matches != 0) {
+            u64 index = group * HASHTABLE_GROUP_SIZE + __builtin_ctz(matches);
+            if (str_eq(slot_at(table, index)->key, key)) {
+                return index;
+            }
+            matches &= matches - 1;
+        }
+
+        // Inserts fill the first group of the sequence with a free slot, so the key cannot be after a group with an empty one
+        if (hashtable_group_match(control, HASHTABLE_CONTROL_EMPTY) != 0) {
+            return -1;
+        }
+
+        group = (group + step) & group_mask;
+    }
+}
+
+/** @brief Rebuilds the table with the given capacity, dropping the deleted slots. */
+static b8 resize_swiss_hashtable(swiss_hashtable *table, u32 new_capacity) {
+    swiss_hashtable copy = *table;
+
+    if (!allocate_storage(table, new_capacity)) {
+        *table = copy;
+        return FALSE;
+    }
+
+    for (u32 i = 0; i < copy.capacity; i++) {
+        if (copy.control[i] < 0) {
+            continue;
+        }
+
+        swiss_hashtable_slot *slot = slot_at(&copy, i);
+        u64 key_hash = hash(slot->key);
+        u64 index = hashtable_group_find_free_slot(table->control, table->capacity, key_hash);
+
+        table->control[index] = HASHTABLE_H2(key_hash);
+        mem_copy(slot_at(table, index), slot, slot_stride(table));
+    }
+
+    allocator_free(table->allocator, copy.control, copy.capacity + copy.capacity * slot_stride(&copy));
+    return TRUE;
+}
+
+API b8 swiss_hashtable_init(swiss_hashtable *table,
+                            u32 element_size,
+                            u32 initial_capacity,
+                            b8 pointers,
+                            const allocator *allocator) {
+    // Make room for the initial capacity without growing
+    u32 capacity = HASHTABLE_GROUP_SIZE;
+    while (hashtable_group_max_entries(capacity) < initial_capacity) {
+        capacity *= 2;
+    }
+
+    table->element_size = pointers ? sizeof(void *) : element_size;
+    table->count = 0;
+    table->pointers = pointers;
+    table->allocator = allocator != NULL ? allocator : allocator_get_heap(MEMORY_TAG_HASHTABLE);
+    table->control = NULL;
+    table->capacity = 0;
+    return allocate_storage(table, capacity);
+}
+
+API b8 swiss_hashtable_insert(swiss_hashtable *table, const char *key, void *value) {
+    u64 key_hash = hash(key);
+    if (find_slot(table, key, key_hash) >= 0) {
+        return FALSE;
+    }
+
+    char *copy = key_copy(table, key);
+    if (copy == NULL) {
+        LOG_ERROR("Failed to copy the key \"%s\"", key);
+        return FALSE;
+    }
+
+    u64 index = hashtable_group_find_free_slot(table->control, table->capacity, key_hash);
+
+    // Reusing a deleted slot does not use up any room, otherwise the table may have to be rebuilt first
+    if (table->control[index] == HASHTABLE_CONTROL_EMPTY && table->growth_left == 0) {
+        // Only grow if the live entries need it, otherwise rebuilding at the same capacity is enough to drop the deleted slots
+        u32 new_capacity = table->capacity;
+        if (table->count + 1 > hashtable_group_max_entries(table->capacity) / 2) {
+            new_capacity *= 2;
+        }
+
+        if (!resize_swiss_hashtable(table, new_capacity)) {
+            key_free(table, copy);
+            return FALSE;
+        }
+
+        index = hashtable_group_find_free_slot(table->control, table->capacity, key_hash);
+    }
+
+    if (table->control[index] == HASHTABLE_CONTROL_EMPTY) {
+        table->growth_left--;
+    }
+
+    table->control[index] = HASHTABLE_H2(key_hash);
+    table->count++;
+
+    swiss_hashtable_slot *slot = slot_at(table, index);
+    slot->key = copy;
+
+    if (table->pointers) {
+        *(void **)(slot + 1) = value;
+    } else {
+        mem_copy(slot + 1, value, table->element_size);
+    }
+
+    return TRUE;
+}
+
+API b8 swiss_hashtable_set(swiss_hashtable *table, const char *key, void *value) {
+    i64 index = find_slot(table, key, hash(key));
+    if (index < 0) {
+        return FALSE;
+    }
+
+    swiss_hashtable_slot *slot = slot_at(table, index);
+
+    if (value == NULL) {
+        key_free(table, slot->key);
+        table->count--;
+
+        if (hashtable_group_free_slot(table->control, index)) {
+            table->growth_left++;
+        }
+
+        return TRUE;
+    }
+
+    if (table->pointers) {
+        *(void **)(slot + 1) = value;
+    } else {
+        mem_copy(slot + 1, value, table->element_size);
+    }
+
+    return TRUE;
+}
+
+API void *swiss_hashtable_get(swiss_hashtable *table, const char *key) {
+    i64 index = find_slot(table, key, hash(key));
+    if (index < 0) {
+        return NULL;
+    }
+
+    swiss_hashtable_slot *slot = slot_at(table, index);
+
+    if (table->pointers) {
+        return *(void **)(slot + 1);
+    } else {
+        return slot + 1;
+    }
+}
+
+API void swiss_hashtable_destroy(swiss_hashtable *table) {
+    for (u32 i = 0; i < table->capacity; i++) {
+        if (table->control[i] >= 0) {
+            key_free(table, slot_at(table, i)->key);
+        }
+    }
+
+    if (table->control != NULL) {
+        allocator_free(table->allocator, table->control, table->capacity + table->capacity * slot_stride(table));
+    }
+    mem_zero(table, sizeof(swiss_hashtable));
+}
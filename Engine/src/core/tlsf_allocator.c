@@ -0,0 +1,384 @@
+#include "tlsf_allocator.h"
+#include "math/math.h"
+
+#define LOG_SCOPE "TLSF ALLOCATOR"
+#include "core/log.h"
+
+/** @brief The size of a block is stored with two flags in its lowest bits (sizes are multiples of TLSF_ALIGN_SIZE). */
+#define BLOCK_FREE_BIT 0x1
+#define BLOCK_PREV_FREE_BIT 0x2
+#define BLOCK_FLAGS_MASK (BLOCK_FREE_BIT | BLOCK_PREV_FREE_BIT)
+
+/** @brief The classes below this size are linear (one class per TLSF_ALIGN_SIZE bytes). */
+#define SMALL_BLOCK_SIZE (1ull << TLSF_FL_INDEX_SHIFT)
+
+/**
+ * @brief The header of a block.
+ *
+ * Every block (free or used) starts with this header, immediately followed by its payload. The free list links are only valid
+ * while the block is free, and are stored in the payload.
+ */
+struct tlsf_block {
+    /** @brief The previous physical block. Only valid if the previous block is free. */
+    tlsf_block *prev_physical;
+    /** @brief The size of the payload, and the block flags. */
+    u64 size;
+
+    /** @brief The next free block in the same class. */
+    tlsf_block *next_free;
+    /** @brief The previous free block in the same class. */
+    tlsf_block *prev_free;
+};
+
+/** @brief The size of the header present in front of every block. */
+#define BLOCK_HEADER_SIZE (2 * sizeof(u64))
+
+/** @brief The smallest payload a block can have (it must be able to hold the free list links). */
+#define BLOCK_MIN_SIZE (sizeof(tlsf_block) - BLOCK_HEADER_SIZE)
+
+/** @brief The largest payload a block can have. */
+#define BLOCK_MAX_SIZE ((1ull << TLSF_FL_INDEX_MAX) - BLOCK_HEADER_SIZE)
+
+static inline u64 block_size(const tlsf_block *block) { return block->size & ~(u64)BLOCK_FLAGS_MASK; }
+
+static inline void block_set_size(tlsf_block *block, u64 size) { block->size = size | (block->size & BLOCK_FLAGS_MASK); }
+
+static inline b8 block_is_free(const tlsf_block *block) { return (block->size & BLOCK_FREE_BIT) != 0; }
+
+static inline b8 block_is_prev_free(const tlsf_block *block) { return (block->size & BLOCK_PREV_FREE_BIT) != 0; }
+
+static inline void *block_to_pointer(const tlsf_block *block) { return (u8 *)block + BLOCK_HEADER_SIZE; }
+
+static inline tlsf_block *block_from_pointer(const void *pointer) { return (tlsf_block *)((u8 *)pointer - BLOCK_HEADER_SIZE); }
+
+static inline tlsf_block *block_next(const tlsf_block *block) {
+    return (tlsf_block *)((u8 *)block_to_pointer(block) + block_size(block));
+}
+
+static inline void block_set_free(tlsf_block *block) {
+    block->size |= BLOCK_FREE_BIT;
+
+    tlsf_block *next = block_next(block);
+    next->prev_physical = block;
+    next->size |= BLOCK_PREV_FREE_BIT;
+}
+
+static inline void block_set_used(tlsf_block *block) {
+    block->size &= ~(u64)BLOCK_FREE_BIT;
+    block_next(block)->size &= ~(u64)BLOCK_PREV_FREE_BIT;
+}
+
+static inline u32 find_last_set(u64 value) { return 63 - __builtin_clzll(value); }
+
+static inline u32 find_first_set(u32 value) { return __builtin_ctz(value); }
+
+/**
+ * @brief Computes the class in which a block of the given size is stored.
+ */
+static inline void mapping_insert(u64 size, u32 *fl, u32 *sl) {
+    if (size < SMALL_BLOCK_SIZE) {
+        *fl = 0;
+        *sl = (u32)(size / (SMALL_BLOCK_SIZE / TLSF_SL_INDEX_COUNT));
+    } else {
+        u32 last_set = find_last_set(size);
+        *sl = (u32)(size >> (last_set - TLSF_SL_INDEX_COUNT_LOG2)) ^ (1 << TLSF_SL_INDEX_COUNT_LOG2);
+        *fl = last_set - (TLSF_FL_INDEX_SHIFT - 1);
+    }
+}
+
+/**
+ * @brief Computes the first class in which every block is large enough for the given size.
+ */
+static inline void mapping_search(u64 size, u32 *fl, u32 *sl) {
+    if (size >= SMALL_BLOCK_SIZE) {
+        size += (1ull << (find_last_set(size) - TLSF_SL_INDEX_COUNT_LOG2)) - 1;
+    }
+
+    mapping_insert(size, fl, sl);
+}
+
+static tlsf_block *search_suitable_block(tlsf_allocator *allocator, u32 *fl, u32 *sl) {
+    u32 sl_map = allocator->sl_bitmap[*fl] & (~0u << *sl);
+    if (sl_map == 0) {
+        // No block in this first level class, look in the next non-empty one
+        u32 fl_map = *fl + 1 < 32 ? allocator->fl_bitmap & (~0u << (*fl + 1)) : 0;
+        if (fl_map == 0) {
+            return NULL;
+        }
+
+        *fl = find_first_set(fl_map);
+        sl_map = allocator->sl_bitmap[*fl];
+    }
+
+    *sl = find_first_set(sl_map);
+    return allocator->free_lists[*fl][*sl];
+}
+
+static void remove_free_block(tlsf_allocator *allocator, tlsf_block *block, u32 fl, u32 sl) {
+    tlsf_block *prev = block->prev_free;
+    tlsf_block *next = block->next_free;
+
+    if (next != NULL) {
+        next->prev_free = prev;
+    }
+
+    if (prev != NULL) {
+        prev->next_free = next;
+    } else {
+        allocator->free_lists[fl][sl] = next;
+
+        if (next == NULL) {
+            allocator->sl_bitmap[fl] &= ~(1u << sl);
+            if (allocator->sl_bitmap[fl] == 0) {
+                allocator->fl_bitmap &= ~(1u << fl);
+            }
+        }
+    }
+}
+
+static void insert_free_block(tlsf_allocator *allocator, tlsf_block *block) {
+    u32 fl, sl;
+    mapping_insert(block_size(block), &fl, &sl);
+
+    tlsf_block *head = allocator->free_lists[fl][sl];
+    block->next_free = head;
+    block->prev_free = NULL;
+    if (head != NULL) {
+        head->prev_free = block;
+    }
+
+    allocator->free_lists[fl][sl] = block;
+    allocator->fl_bitmap |= 1u << fl;
+    allocator->sl_bitmap[fl] |= 1u << sl;
+}
+
+static void block_remove(tlsf_allocator *allocator, tlsf_block *block) {
+    u32 fl, sl;
+    mapping_insert(block_size(block), &fl, &sl);
+    remove_free_block(allocator, block, fl, sl);
+}
+
+static inline b8 block_can_split(const tlsf_block *block, u64 size) {
+    return block_size(block) >= size + sizeof(tlsf_block);
+}
+
+/**
+ * @brief Splits a block in two, the first one having the given size. Returns the second one, which is marked as free.
+ */
+static tlsf_block *block_split(tlsf_block *block, u64 size) {
+    tlsf_block *remaining = (tlsf_block *)((u8 *)block_to_pointer(block) + size);
+    u64 remaining_size = block_size(block) - (size + BLOCK_HEADER_SIZE);
+
+    remaining->size = remaining_size;
+    block_set_size(block, size);
+    block_set_free(remaining);
+
+    return remaining;
+}
+
+/**
+ * @brief Absorbs a free block into its (adjacent) previous block.
+ */
+static tlsf_block *block_absorb(tlsf_block *prev, tlsf_block *block) {
+    block_set_size(prev, block_size(prev) + block_size(block) + BLOCK_HEADER_SIZE);
+    block_next(prev)->prev_physical = prev;
+    return prev;
+}
+
+static tlsf_block *block_merge_prev(tlsf_allocator *allocator, tlsf_block *block) {
+    if (block_is_prev_free(block)) {
+        tlsf_block *prev = block->prev_physical;
+        block_remove(allocator, prev);
+        block = block_absorb(prev, block);
+    }
+
+    return block;
+}
+
+static tlsf_block *block_merge_next(tlsf_allocator *allocator, tlsf_block *block) {
+    tlsf_block *next = block_next(block);
+    if (block_is_free(next)) {
+        block_remove(allocator, next);
+        block = block_absorb(block, next);
+    }
+
+    return block;
+}
+
+/**
+ * @brief Gives the end of a block back to the allocator if it is large enough to form a new block.
+ */
+static void block_trim_used(tlsf_allocator *allocator, tlsf_block *block, u64 size) {
+    if (block_can_split(block, size)) {
+        tlsf_block *remaining = block_split(block, size);
+        remaining->size &= ~(u64)BLOCK_PREV_FREE_BIT;
+        remaining = block_merge_next(allocator, remaining);
+        insert_free_block(allocator, remaining);
+    }
+}
+
+/**
+ * @brief Gives the beginning of a free block back to the allocator, and returns the block starting after it.
+ */
+static tlsf_block *block_trim_free_leading(tlsf_allocator *allocator, tlsf_block *block, u64 size) {
+    tlsf_block *remaining = block;
+    if (block_can_split(block, size)) {
+        remaining = block_split(block, size - BLOCK_HEADER_SIZE);
+        remaining->size |= BLOCK_PREV_FREE_BIT;
+        remaining->prev_physical = block;
+
+        block_set_free(block);
+        insert_free_block(allocator, block);
+    }
+
+    return remaining;
+}
+
+static inline u64 adjust_request_size(u64 size) {
+    if (size == 0 || size > BLOCK_MAX_SIZE) {
+        return 0;
+    }
+
+    return MAX(ALIGN_UP(size, TLSF_ALIGN_SIZE), BLOCK_MIN_SIZE);
+}
+
+API void tlsf_allocator_create(tlsf_allocator *allocator) {
+    allocator->fl_bitmap = 0;
+    for (u32 i = 0; i < TLSF_FL_INDEX_COUNT; i++) {
+        allocator->sl_bitmap[i] = 0;
+        for (u32 j = 0; j < TLSF_SL_INDEX_COUNT; j++) {
+            allocator->free_lists[i][j] = NULL;
+        }
+    }
+
+    allocator->last_region_end = NULL;
+}
+
+API b8 tlsf_allocator_add_memory(tlsf_allocator *allocator, void *memory, u64 size) {
+    u64 begin = ALIGN_UP((u64)memory, TLSF_ALIGN_SIZE);
+    u64 end = ALIGN_DOWN((u64)memory + size, TLSF_ALIGN_SIZE);
+
+    tlsf_block *block;
+    u64 block_payload;
+    if (allocator->last_region_end != NULL && (u64)allocator->last_region_end == (u64)memory) {
+        // Contiguous with the previous region: the previous sentinel becomes the header of the new block
+        block = (tlsf_block *)(begin - BLOCK_HEADER_SIZE);
+        block_payload = end - begin - BLOCK_HEADER_SIZE;
+    } else {
+        if (end < begin + 2 * BLOCK_HEADER_SIZE + BLOCK_MIN_SIZE) {
+            LOG_ERROR("Memory region too small: %llu bytes", size);
+            return FALSE;
+        }
+
+        block = (tlsf_block *)begin;
+        block->size = 0;
+        block_payload = end - begin - 2 * BLOCK_HEADER_SIZE;
+    }
+
+    if (block_payload > BLOCK_MAX_SIZE) {
+        LOG_ERROR("Memory region too large: %llu bytes", size);
+        return FALSE;
+    }
+
+    // Keep the previous free flag of the old sentinel (if any), and mark the block free
+    block_set_size(block, block_payload);
+
+    // The sentinel is a zero-sized used block that ends the region, so that blocks never merge past the end
+    tlsf_block *sentinel = block_next(block);
+    sentinel->size = 0;
+    block_set_free(block);
+
+    block = block_merge_prev(allocator, block);
+    insert_free_block(allocator, block);
+
+    allocator->last_region_end = (void *)end;
+    return TRUE;
+}
+
+API void *tlsf_allocator_allocate(tlsf_allocator *allocator, u64 size, u64 alignment, u64 offset) {
+    u64 adjusted_size = adjust_request_size(size);
+    if (adjusted_size == 0) {
+        return NULL;
+    }
+
+    // Alignments up to the natural block alignment are free, larger ones need room to move the block forward
+    u64 search_size = adjusted_size;
+    if (alignment > TLSF_ALIGN_SIZE) {
+        search_size = adjust_request_size(adjusted_size + alignment + sizeof(tlsf_block));
+        if (search_size == 0) {
+            return NULL;
+        }
+    }
+
+    u32 fl, sl;
+    mapping_search(search_size, &fl, &sl);
+    if (fl >= TLSF_FL_INDEX_COUNT) {
+        return NULL;
+    }
+
+    tlsf_block *block = search_suitable_block(allocator, &fl, &sl);
+    if (block == NULL) {
+        return NULL;
+    }
+
+    remove_free_block(allocator, block, fl, sl);
+
+    if (alignment > TLSF_ALIGN_SIZE) {
+        u64 pointer = (u64)block_to_pointer(block);
+        u64 aligned = ALIGN_UP(pointer + offset, alignment) - offset;
+        u64 gap = aligned - pointer;
+
+        // The gap must be large enough to hold a free block, otherwise move to the next aligned position
+        if (gap != 0 && gap < sizeof(tlsf_block)) {
+            aligned = ALIGN_UP(pointer + offset + sizeof(tlsf_block), alignment) - offset;
+            gap = aligned - pointer;
+        }
+
+        if (gap != 0) {
+            block = block_trim_free_leading(allocator, block, gap);
+        }
+    }
+
+    block_trim_used(allocator, block, adjusted_size);
+    block_set_used(block);
+
+    return block_to_pointer(block);
+}
+
+API void tlsf_allocator_free(tlsf_allocator *allocator, void *pointer) {
+    if (pointer == NULL) {
+        return;
+    }
+
+    tlsf_block *block = block_from_pointer(pointer);
+    block_set_free(block);
+    block = block_merge_prev(allocator, block);
+    block = block_merge_next(allocator, block);
+    insert_free_block(allocator, block);
+}
+
+API b8 tlsf_allocator_resize(tlsf_allocator *allocator, void *pointer, u64 size) {
+    u64 adjusted_size = adjust_request_size(size);
+    if (adjusted_size == 0) {
+        return FALSE;
+    }
+
+    tlsf_block *block = block_from_pointer(pointer);
+    if (adjusted_size > block_size(block)) {
+        tlsf_block *next = block_next(block);
+        if (!block_is_free(next) || block_size(block) + BLOCK_HEADER_SIZE + block_size(next) < adjusted_size) {
+            return FALSE;
+        }
+
+        block_remove(allocator, next);
+        block_absorb(block, next);
+        block_set_used(block);
+    }
+
+    block_trim_used(allocator, block, adjusted_size);
+    return TRUE;
+}
+
+API u64 tlsf_allocator_block_size(const void *pointer) { return block_size(block_from_pointer(pointer)); }
+
+API u64 tlsf_allocator_block_overhead() { return BLOCK_HEADER_SIZE; }
@@ -0,0 +1,125 @@
+/**
+ * @file tlsf_allocator.h
+ * @author Killian Bellouard (killianbellouard@gmail.com)
+ * @brief This file defines a Two-Level Segregated Fit allocator. It is a general purpose allocator with O(1) allocation and
+ * free operations, working on memory regions provided by the caller.
+ *
+ * Free blocks are sorted in size classes: a first level split by powers of two, each one split in a second level of
+ * @ref TLSF_SL_INDEX_COUNT linear subdivisions. Two bitmaps tell which classes have free blocks, so finding a suitable block is
+ * a couple of bit scans. Free blocks are merged with their physical neighbours immediately.
+ *
+ * See "TLSF: a New Dynamic Memory Allocator for Real-Time Systems" (M. Masmano, I. Ripoll, A. Crespo, J. Real).
+ * @version 0.1
+ * @date 2024-08-05
+ */
+
+#pragma once
+
+#include "common.h"
+
+/** @brief The log2 of the number of second level subdivisions. */
+#define TLSF_SL_INDEX_COUNT_LOG2 5
+/** @brief The number of second level subdivisions. */
+#define TLSF_SL_INDEX_COUNT (1 << TLSF_SL_INDEX_COUNT_LOG2)
+/** @brief The log2 of the alignment of every block (and of the minimum granularity of block sizes). */
+#define TLSF_ALIGN_SIZE_LOG2 4
+/** @brief The alignment of every block. */
+#define TLSF_ALIGN_SIZE (1 << TLSF_ALIGN_SIZE_LOG2)
+/** @brief The log2 of the largest block size supported (256 GiB). */
+#define TLSF_FL_INDEX_MAX 38
+/** @brief The first level index of the smallest "power of two" class. Smaller blocks are all stored in the first class. */
+#define TLSF_FL_INDEX_SHIFT (TLSF_SL_INDEX_COUNT_LOG2 + TLSF_ALIGN_SIZE_LOG2)
+/** @brief The number of first level classes. */
+#define TLSF_FL_INDEX_COUNT (TLSF_FL_INDEX_MAX - TLSF_FL_INDEX_SHIFT + 1)
+
+typedef struct tlsf_block tlsf_block;
+
+/** @brief A TLSF allocator. */
+typedef struct tlsf_allocator {
+    /** @brief Bitmap of the first level classes that have at least one free block. */
+    u32 fl_bitmap;
+    /** @brief Bitmaps of the second level classes that have at least one free block, per first level class. */
+    u32 sl_bitmap[TLSF_FL_INDEX_COUNT];
+    /** @brief Heads of the free lists, per class. */
+    tlsf_block *free_lists[TLSF_FL_INDEX_COUNT][TLSF_SL_INDEX_COUNT];
+    /** @brief The end of the last memory region added, used to merge contiguous regions. */
+    void *last_region_end;
+} tlsf_allocator;
+
+/**
+ * @brief Creates an empty TLSF allocator. Memory must be added with @ref tlsf_allocator_add_memory before allocating.
+ *
+ * @param[out] allocator A pointer to the allocator to initialize.
+ */
+API void tlsf_allocator_create(tlsf_allocator *allocator);
+
+/**
+ * @brief Adds a memory region to the allocator.
+ *
+ * If the region starts exactly where the previously added region ended, both are merged, so that blocks can span them.
+ *
+ * @note The allocator does not take ownership of the memory region, the caller is responsible for freeing it once the allocator
+ * is not used anymore.
+ *
+ * @param[in] allocator The allocator.
+ * @param[in] memory The memory region.
+ * @param[in] size The size of the memory region.
+ *
+ * @retval TRUE Success
+ * @retval FALSE Failure (the region is too small or too large)
+ */
+API b8 tlsf_allocator_add_memory(tlsf_allocator *allocator, void *memory, u64 size);
+
+/**
+ * @brief Allocates a block from the allocator.
+ *
+ * The returned pointer P is such that P + offset is aligned on the requested alignment. This allows callers to store a header
+ * in front of an aligned payload without wasting a full alignment worth of padding.
+ *
+ * @param[in] allocator The allocator.
+ * @param[in] size The size of the block.
+ * @param[in] alignment The alignment (must be a power of two).
+ * @param[in] offset The offset at which the alignment is required (must be a multiple of @ref TLSF_ALIGN_SIZE).
+ *
+ * @return A pointer to the allocated block, or NULL if no free block is large enough.
+ */
+API void *tlsf_allocator_allocate(tlsf_allocator *allocator, u64 size, u64 alignment, u64 offset);
+
+/**
+ * @brief Frees a block allocated from the allocator.
+ *
+ * @param[in] allocator The allocator.
+ * @param[in] pointer The block to free.
+ */
+API void tlsf_allocator_free(tlsf_allocator *allocator, void *pointer);
+
+/**
+ * @brief Resizes an allocated block without moving it.
+ *
+ * Shrinking always succeeds and gives the end of the block back to the allocator. Growing succeeds if the block is followed
+ * by a free block large enough to absorb.
+ *
+ * @param[in] allocator The allocator.
+ * @param[in] pointer The block to resize.
+ * @param[in] size The new size of the block.
+ *
+ * @retval TRUE Success
+ * @retval FALSE Failure (the block must be moved to be resized, and is left untouched)
+ */
+API b8 tlsf_allocator_resize(tlsf_allocator *allocator, void *pointer, u64 size);
+
+/**
+ * @brief Gets the usable size of an allocated block (which may be larger than the requested size).
+ *
+ * @param[in] pointer The block.
+ *
+ * @return The usable size of the block.
+ */
+API u64 tlsf_allocator_block_size(const void *pointer);
+
+/**
+ * @brief Gets the per-block overhead of the allocator.
+ *
+ * @return The size of the bookkeeping data stored in front of every block.
+ */
+API u64 tlsf_allocator_block_overhead();
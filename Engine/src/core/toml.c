@@ -2,6 +2,7 @@
 #include "dynamic_array.h"
 #include "math/math.h"
 #include "str.h"
+#include "str_intern.h"
 
 #define LOG_SCOPE "TOML"
 #include "core/log.h"
@@ -196,9 +197,18 @@ static b8 parse_path(str_view path, toml_table *parent, toml_table_entry **resul
             return FALSE;
         }
 
+        // Keys are interned, so that they are compared by address
+        str_id key_id = str_intern_view(name);
+        if (key_id == NULL) {
+            LOG_ERROR("Failed to intern the key \"%.*s\"", STR_VIEW_PRINT(name));
+            return FALSE;
+        }
+
+        const char *key = key_id->string;
+
         b8 found = FALSE;
         for (u32 i = 0; i < current->entries.count; i++) {
-            if (str_view_eq(name, current->entries.data[i].key)) {
+            if (current->entries.data[i].key == key) {
                 if (path.size != 0 && current->entries.data[i].entry.type != TOML_TABLE_ENTRY_TYPE_TABLE) {
                     LOG_ERROR("Invalid syntax: \"%.*s\" -> invalid entry type %d",
                               STR_VIEW_PRINT(orig_path),
@@ -219,7 +229,7 @@ static b8 parse_path(str_view path, toml_table *parent, toml_table_entry **resul
         if (!found) {
             if (path.size == 0) {
                 toml_table_entry res = {
-                    .key = str_view_dup(name),
+                    .key = key,
                     .entry = {},
                 };
                 DYNARRAY_PUSH(current->entries, res);
@@ -228,7 +238,7 @@ static b8 parse_path(str_view path, toml_table *parent, toml_table_entry **resul
                 return TRUE;
             } else {
                 toml_table_entry res = {
-                    .key = str_view_dup(name),
+                    .key = key,
                     .entry = {
                         .type = TOML_TABLE_ENTRY_TYPE_TABLE,
                         .table = { .entries = {} },
@@ -296,14 +306,23 @@ static b8 parse_string(const char **result, toml_parser *parser) {
     str_view string;
     str_view_split(&parser->content, "\"", &string);
 
-    char *buf = str_view_dup(string);
+    // Escape in a scratch buffer, so that only the final string is allocated on the heap
+    scratch_marker marker = mem_scratch_mark();
+    char *buf = str_view_dup_scratch(string);
+    if (buf == NULL) {
+        LOG_ERROR("Failed to copy the string at line %llu", parser->line);
+        mem_scratch_rewind(marker);
+        return FALSE;
+    }
+
     u64 size = string.size;
     if (!escape_string(buf, &size)) {
-        mem_free(buf);
+        mem_scratch_rewind(marker);
         return FALSE;
     }
 
-    *result = buf;
+    *result = str_view_dup((str_view){buf, size});
+    mem_scratch_rewind(marker);
     return TRUE;
 }
 
@@ -324,14 +343,22 @@ static b8 parse_multiline_string(const char **result, toml_parser *parser) {
 
     parser->line += str_view_count(string, '\n');
 
-    char *buf = str_view_dup(string);
+    scratch_marker marker = mem_scratch_mark();
+    char *buf = str_view_dup_scratch(string);
+    if (buf == NULL) {
+        LOG_ERROR("Failed to copy the string at line %llu", parser->line);
+        mem_scratch_rewind(marker);
+        return FALSE;
+    }
+
     u64 size = string.size;
     if (!escape_string(buf, &size)) {
-        mem_free(buf);
+        mem_scratch_rewind(marker);
         return FALSE;
     }
 
-    *result = buf;
+    *result = str_view_dup((str_view){buf, size});
+    mem_scratch_rewind(marker);
     return TRUE;
 }
 
@@ -521,8 +548,14 @@ static b8 parse_array(toml_array *array, toml_parser *parser) {
             continue;
         }
 
-        toml_entry entry;
+        toml_entry entry = {};
+        u32 count = array->entries.count;
         DYNARRAY_PUSH(array->entries, entry);
+        if (array->entries.count == count) {
+            LOG_ERROR("Failed to allocate an array element at line %llu", parser->line);
+            return FALSE;
+        }
+
         toml_entry *entry_ptr = &array->entries.data[array->entries.count - 1];
 
         parser_trim(parser, TRIM_LEFT);
@@ -667,12 +700,23 @@ API toml_entry *toml_get(toml_table *table, const char *key, toml_entry_type typ
                 return NULL;
             }
 
+            // A key that has never been interned is in no document
+            str_id key_id = str_intern_find(name);
+            if (key_id == NULL) {
+                return NULL;
+            }
+
+            entry = NULL;
             for (u32 i = 0; i < current->entries.count; i++) {
-                if (str_view_eq(name, current->entries.data[i].key)) {
+                if (current->entries.data[i].key == key_id->string) {
                     entry = &current->entries.data[i].entry;
                     break;
                 }
             }
+
+            if (entry == NULL) {
+                return NULL;
+            }
         }
 
         if (key_view.size != 0 && entry->type == TOML_TABLE_ENTRY_TYPE_TABLE) {
@@ -712,7 +756,6 @@ static void toml_free_entry(toml_entry *entry) {
 API void toml_free(toml_table *table) {
     for (u32 i = 0; i < table->entries.count; i++) {
         toml_free_entry(&table->entries.data[i].entry);
-        mem_free((char *)table->entries.data[i].key);
     }
 
     DYNARRAY_CLEAR(table->entries);
@@ -33,6 +33,7 @@ typedef struct toml_entry {
 } toml_entry;
 
 typedef struct toml_table_entry {
+    /** @brief The key, interned (see @ref str_intern). */
     const char *key;
     struct toml_entry entry;
 } toml_table_entry;
@@ -0,0 +1,187 @@
+#include "core/hash.h"
+#include "core/hashtable_group.h"
+#include "hashtable.h"
+#include "math/math.h"
+#include "memory.h"
+
+#define LOG_SCOPE "U64 HASHTABLE"
+#include "core/log.h"
+
+/** @brief The header of a slot, followed by its value. */
+typedef struct u64_hashtable_slot {
+    u64 key;
+} u64_hashtable_slot;
+
+static inline u64 slot_stride(const u64_hashtable *table) {
+    return ALIGN_UP(sizeof(u64_hashtable_slot) + table->element_size, _Alignof(u64_hashtable_slot));
+}
+
+static inline u64_hashtable_slot *slot_at(const u64_hashtable *table, u64 index) {
+    return (u64_hashtable_slot *)((u8 *)table->slots + index * slot_stride(table));
+}
+
+static inline void slot_write_value(const u64_hashtable *table, u64_hashtable_slot *slot, void *value) {
+    if (table->pointers) {
+        *(void **)(slot + 1) = value;
+    } else {
+        mem_copy(slot + 1, value, table->element_size);
+    }
+}
+
+/** @brief Allocates the control bytes and the slots of a table, in one block. Every slot starts empty. */
+static b8 allocate_storage(u64_hashtable *table, u32 capacity) {
+    u8 *block = allocator_allocate(table->allocator, capacity + capacity * slot_stride(table), HASHTABLE_GROUP_SIZE);
+    if (block == NULL) {
+        LOG_ERROR("Failed to allocate %u slots", capacity);
+        return FALSE;
+    }
+
+    mem_set(block, (u8)HASHTABLE_CONTROL_EMPTY, capacity);
+
+    table->control = (i8 *)block;
+    table->slots = block + capacity;
+    table->capacity = capacity;
+    table->growth_left = hashtable_group_max_entries(capacity) - table->count;
+    return TRUE;
+}
+
+/** @brief Finds the index of the slot holding the given key, or returns -1 if the key is not in the table. */
+static i64 find_slot(const u64_hashtable *table, u64 key, u64 key_hash) {
+    u64 group_mask = table->capacity / HASHTABLE_GROUP_SIZE - 1;
+    u64 group = HASHTABLE_H1(key_hash) & group_mask;
+
+    for (u64 step = 1;; step++) {
+        const i8 *control = table->control + group * HASHTABLE_GROUP_SIZE;
+
+        u32 matches = hashtable_group_match(control, HASHTABLE_H2(key_hash));
+        while (matches != 0) {
+            u64 index = group * HASHTABLE_GROUP_SIZE + __builtin_ctz(matches);
+            if (slot_at(table, index)->key == key) {
+                return index;
+            }
+            matches &= matches - 1;
+        }
+
+        if (hashtable_group_match(control, HASHTABLE_CONTROL_EMPTY) != 0) {
+            return -1;
+        }
+
+        group = (group + step) & group_mask;
+    }
+}
+
+/** @brief Rebuilds the table with the given capacity, dropping the deleted slots. */
+static b8 resize_u64_hashtable(u64_hashtable *table, u32 new_capacity) {
+    u64_hashtable copy = *table;
+
+    if (!allocate_storage(table, new_capacity)) {
+        *table = copy;
+        return FALSE;
+    }
+
+    for (u32 i = 0; i < copy.capacity; i++) {
+        if (copy.control[i] < 0) {
+            continue;
+        }
+
+        u64_hashtable_slot *slot = slot_at(&copy, i);
+        u64 key_hash = hash_u64(slot->key);
+        u64 index = hashtable_group_find_free_slot(table->control, table->capacity, key_hash);
+
+        table->control[index] = HASHTABLE_H2(key_hash);
+        mem_copy(slot_at(table, index), slot, slot_stride(table));
+    }
+
+    allocator_free(table->allocator, copy.control, copy.capacity + copy.capacity * slot_stride(&copy));
+    return TRUE;
+}
+
+API b8 u64_hashtable_init(u64_hashtable *table, u32 element_size, u32 initial_capacity, b8 pointers, const allocator *allocator) {
+    u32 capacity = HASHTABLE_GROUP_SIZE;
+    while (hashtable_group_max_entries(capacity) < initial_capacity) {
+        capacity *= 2;
+    }
+
+    table->element_size = pointers ? sizeof(void *) : element_size;
+    table->count = 0;
+    table->pointers = pointers;
+    table->allocator = allocator != NULL ? allocator : allocator_get_heap(MEMORY_TAG_HASHTABLE);
+    table->control = NULL;
+    table->capacity = 0;
+    return allocate_storage(table, capacity);
+}
+
+API b8 u64_hashtable_insert(u64_hashtable *table, u64 key, void *value) {
+    u64 key_hash = hash_u64(key);
+    if (find_slot(table, key, key_hash) >= 0) {
+        return FALSE;
+    }
+
+    u64 index = hashtable_group_find_free_slot(table->control, table->capacity, key_hash);
+
+    if (table->control[index] == HASHTABLE_CONTROL_EMPTY && table->growth_left == 0) {
+        u32 new_capacity = table->capacity;
+        if (table->count + 1 > hashtable_group_max_entries(table->capacity) / 2) {
+            new_capacity *= 2;
+        }
+
+        if (!resize_u64_hashtable(table, new_capacity)) {
+            return FALSE;
+        }
+
+        index = hashtable_group_find_free_slot(table->control, table->capacity, key_hash);
+    }
+
+    if (table->control[index] == HASHTABLE_CONTROL_EMPTY) {
+        table->growth_left--;
+    }
+
+    table->control[index] = HASHTABLE_H2(key_hash);
+    table->count++;
+
+    u64_hashtable_slot *slot = slot_at(table, index);
+    slot->key = key;
+    slot_write_value(table, slot, value);
+
+    return TRUE;
+}
+
+API b8 u64_hashtable_set(u64_hashtable *table, u64 key, void *value) {
+    i64 index = find_slot(table, key, hash_u64(key));
+    if (index < 0) {
+        return FALSE;
+    }
+
+    if (value == NULL) {
+        table->count--;
+        if (hashtable_group_free_slot(table->control, index)) {
+            table->growth_left++;
+        }
+        return TRUE;
+    }
+
+    slot_write_value(table, slot_at(table, index), value);
+    return TRUE;
+}
+
+API void *u64_hashtable_get(u64_hashtable *table, u64 key) {
+    i64 index = find_slot(table, key, hash_u64(key));
+    if (index < 0) {
+        return NULL;
+    }
+
+    u64_hashtable_slot *slot = slot_at(table, index);
+
+    if (table->pointers) {
+        return *(void **)(slot + 1);
+    } else {
+        return slot + 1;
+    }
+}
+
+API void u64_hashtable_destroy(u64_hashtable *table) {
+    if (table->control != NULL) {
+        allocator_free(table->allocator, table->control, table->capacity + table->capacity * slot_stride(table));
+    }
+    mem_zero(table, sizeof(u64_hashtable));
+}
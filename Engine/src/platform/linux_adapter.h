@@ -8,14 +8,17 @@
 
 #pragma once
 
-#include "core/dynamic_array.h"
+#include "core/pool_allocator.h"
+#include "core/slot_map.h"
 #include "platform/platform.h"
 
 typedef struct linux_adapter_state linux_adapter_state;
 
 /** @brief State of the platform layer. */
 struct platform_system_state {
-    DYNARRAY(window *) windows;
+    /** @brief The windows, of window pointers. */
+    slot_map windows;
+    pool_allocator window_pool;
     platform_window_closed_callback window_closed_callback;
     dynamic_library adapter_lib;
 };
@@ -32,7 +35,7 @@ typedef struct linux_adapter {
     void (*window_destroy)(struct linux_adapter *adapter, window *window);
 
     b8 (*vulkan_surface_create)(void *instance, void *allocation_callbacks, void **surface, const window *window);
-    // DYNARRAY(const char*) *extensions
+    // SMALL_DYNARRAY(const char *, 8) *extensions
     void (*vulkan_get_required_extensions)(void *extensions);
     b8 (*vulkan_queue_supports_present)(void *device, u32 queue_family);
 
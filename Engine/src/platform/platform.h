@@ -39,6 +39,51 @@ typedef enum platform_console_color {
 /** @brief A handle to a Dynamic Library. */
 typedef void *dynamic_library;
 
+/** @brief A handle to a thread. */
+typedef void *platform_thread;
+
+/**
+ * @brief The entry point of a thread.
+ *
+ * @param[in] argument The argument given to @ref platform_thread_create.
+ */
+typedef void (*platform_thread_function)(void *argument);
+
+/**
+ * @brief A mutex, which puts the threads waiting for it to sleep. Zero-initialized mutexes are unlocked.
+ *
+ * It is a single word, locked with an atomic operation when it is free: the kernel is only involved when threads contend.
+ */
+typedef struct platform_mutex {
+    /** @brief 0 if unlocked, 1 if locked, 2 if locked and threads may be waiting for it. */
+    u32 state;
+} platform_mutex;
+
+/** @brief A condition variable. Zero-initialized condition variables are ready to be used. */
+typedef struct platform_condition_variable {
+    /** @brief Incremented by each signal, so that waiters can tell whether they missed one. */
+    u32 sequence;
+} platform_condition_variable;
+
+/** @brief A handle to a fiber: an execution context with its own stack, which threads switch to and from explicitly. */
+typedef void *platform_fiber;
+
+/**
+ * @brief The entry point of a fiber. It must never return: a fiber finishes by switching to another one, and is destroyed
+ * from there.
+ *
+ * @param[in] argument The argument given to @ref platform_fiber_create.
+ */
+typedef void (*platform_fiber_function)(void *argument);
+
+/** @brief A counting semaphore. Zero-initialized semaphores have a count of 0. */
+typedef struct platform_semaphore {
+    /** @brief The count. */
+    u32 count;
+    /** @brief The number of threads waiting, so that posting does not call the kernel when there are none. */
+    u32 waiters;
+} platform_semaphore;
+
 /** @brief A struct describing the window to create. */
 typedef struct window_config {
     i32 position_x;
@@ -69,6 +114,9 @@ typedef struct window {
 
     /** @brief The state of the platform layer. */
     struct window_platform_state *platform_state;
+
+    /** @brief The handle of the window in the registry of the platform layer (read-only). */
+    uuid id;
 } window;
 
 // Callbacks
@@ -131,6 +179,57 @@ void *platform_allocate(u64 size);
  */
 void platform_free(void *pointer);
 
+/**
+ * @brief Gets the size of a virtual memory page.
+ *
+ * @return The size of a page in bytes.
+ */
+u64 platform_get_page_size();
+
+/**
+ * @brief Reserves a range of virtual address space, without backing it with physical memory.
+ *
+ * The range must be committed with @ref platform_virtual_commit before being accessed.
+ *
+ * @param[in] size The size of the range to reserve. Must be a multiple of the page size.
+ * @param[in] huge_pages Whether to hint the OS to back the range with huge pages once committed (ignored if unsupported).
+ *
+ * @return A pointer to the beginning of the range, or NULL on failure.
+ */
+void *platform_virtual_reserve(u64 size, b8 huge_pages);
+
+/**
+ * @brief Commits a part of a reserved range, making it readable and writable.
+ *
+ * @note Newly committed memory is zeroed.
+ *
+ * @param[in] address The beginning of the part to commit. Must be page aligned.
+ * @param[in] size The size of the part to commit. Must be a multiple of the page size.
+ *
+ * @retval TRUE Success
+ * @retval FALSE Failure
+ */
+b8 platform_virtual_commit(void *address, u64 size);
+
+/**
+ * @brief Decommits a part of a reserved range, giving its physical memory back to the OS. The range stays reserved.
+ *
+ * @param[in] address The beginning of the part to decommit. Must be page aligned.
+ * @param[in] size The size of the part to decommit. Must be a multiple of the page size.
+ *
+ * @retval TRUE Success
+ * @retval FALSE Failure
+ */
+b8 platform_virtual_decommit(void *address, u64 size);
+
+/**
+ * @brief Releases a range previously reserved with @ref platform_virtual_reserve.
+ *
+ * @param[in] address The beginning of the range.
+ * @param[in] size The size of the range, as passed to @ref platform_virtual_reserve.
+ */
+void platform_virtual_release(void *address, u64 size);
+
 #ifdef DEBUG
 /**
  * @brief Get the address of the caller of the current function.
@@ -144,6 +243,27 @@ void platform_free(void *pointer);
 void *platform_get_caller();
 #endif
 
+/**
+ * @brief Captures the call stack of the calling thread.
+ *
+ * @param[in] skip The number of innermost frames to skip (not counting this function itself).
+ * @param[in] max_frames The maximum number of frames to capture.
+ * @param[out] frames A pointer to an array of at least max_frames return addresses, innermost first.
+ *
+ * @return The number of frames captured.
+ */
+u32 platform_capture_stack_trace(u32 skip, u32 max_frames, void **frames);
+
+/**
+ * @brief Gets a printable name for a code address: the name of the function containing it if it is known, or the name of its
+ * module and the offset in it otherwise (which can be resolved offline, with addr2line for instance).
+ *
+ * @param[in] address The code address.
+ * @param[out] buffer A pointer to a memory region to store the name.
+ * @param[in] size The size of the buffer.
+ */
+void platform_get_symbol_name(void *address, char *buffer, u64 size);
+
 /**
  * @brief Opens a Dynamic Library file.
  *
@@ -234,9 +354,221 @@ void platform_register_window_closed_callback(platform_window_closed_callback ca
  */
 f32 platform_get_time();
 
+/**
+ * @brief Gets the value of a monotonic clock in nanoseconds, for precise measurements of short durations.
+ *
+ * @note The origin of the clock is unspecified, only the differences between two values are meaningful.
+ *
+ * @return The time in nanoseconds.
+ */
+API u64 platform_get_time_ns();
+
 /**
  * @brief Sleeps for the specified number of milliseconds.
  *
  * @param [in] milliseconds The number of milliseconds to sleep.
  */
 API void platform_sleep(u32 milliseconds);
+
+/**
+ * @brief Gets the number of logical processors available to the process.
+ *
+ * @return The number of logical processors (at least 1).
+ */
+API u32 platform_get_processor_count();
+
+/**
+ * @brief Creates a thread, which starts running right away.
+ *
+ * @note The thread releases its allocation cache (see @ref mem_thread_cache_release) when its function returns.
+ *
+ * @param[in] function The entry point of the thread.
+ * @param[in] argument The argument given to the entry point.
+ * @param[out] result A pointer to a memory region to store the handle of the thread.
+ *
+ * @retval TRUE Success
+ * @retval FALSE Failure
+ */
+API b8 platform_thread_create(platform_thread_function function, void *argument, platform_thread *result);
+
+/**
+ * @brief Waits for a thread to finish, and releases its handle.
+ *
+ * @param[in] thread The thread to wait for.
+ *
+ * @retval TRUE Success
+ * @retval FALSE Failure
+ */
+API b8 platform_thread_join(platform_thread thread);
+
+/**
+ * @brief Gets the handle of the calling thread.
+ *
+ * @note On Windows, the handle is only valid in the calling thread.
+ *
+ * @return The handle of the calling thread.
+ */
+API platform_thread platform_thread_current();
+
+/**
+ * @brief Sets the name of a thread, shown by debuggers and profilers.
+ *
+ * @note The name is truncated to 15 characters on Linux.
+ *
+ * @param[in] thread The thread.
+ * @param[in] name The name of the thread.
+ *
+ * @retval TRUE Success
+ * @retval FALSE Failure
+ */
+API b8 platform_thread_set_name(platform_thread thread, const char *name);
+
+/**
+ * @brief Restricts a thread to run on a single logical processor.
+ *
+ * @param[in] thread The thread.
+ * @param[in] processor The index of the logical processor among those available to the process, below
+ * @ref platform_get_processor_count.
+ *
+ * @retval TRUE Success
+ * @retval FALSE Failure
+ */
+API b8 platform_thread_set_affinity(platform_thread thread, u32 processor);
+
+/** @brief Gives the rest of the time slice of the calling thread to another thread. */
+API void platform_thread_yield();
+
+/**
+ * @brief Locks a mutex, waiting for it if it is locked by another thread.
+ *
+ * @note Mutexes are not recursive: locking a mutex twice from the same thread deadlocks.
+ *
+ * @param[in] mutex The mutex to lock.
+ */
+API void platform_mutex_lock(platform_mutex *mutex);
+
+/**
+ * @brief Locks a mutex if it is unlocked, without waiting.
+ *
+ * @param[in] mutex The mutex to lock.
+ *
+ * @retval TRUE The mutex was locked
+ * @retval FALSE The mutex is locked by another thread
+ */
+API b8 platform_mutex_try_lock(platform_mutex *mutex);
+
+/**
+ * @brief Unlocks a mutex, waking a thread waiting for it if there is one.
+ *
+ * @param[in] mutex The mutex to unlock, locked by the calling thread.
+ */
+API void platform_mutex_unlock(platform_mutex *mutex);
+
+/**
+ * @brief Unlocks a mutex and waits for a condition variable to be signaled, then locks the mutex again.
+ *
+ * @note Waiters may wake up without being signaled, so the condition must be checked again in a loop.
+ *
+ * @param[in] condition_variable The condition variable to wait for.
+ * @param[in] mutex The mutex protecting the condition, locked by the calling thread.
+ */
+API void platform_condition_variable_wait(platform_condition_variable *condition_variable, platform_mutex *mutex);
+
+/**
+ * @brief Wakes one of the threads waiting for a condition variable.
+ *
+ * @param[in] condition_variable The condition variable.
+ */
+API void platform_condition_variable_signal(platform_condition_variable *condition_variable);
+
+/**
+ * @brief Wakes every thread waiting for a condition variable.
+ *
+ * @param[in] condition_variable The condition variable.
+ */
+API void platform_condition_variable_broadcast(platform_condition_variable *condition_variable);
+
+/**
+ * @brief Initializes a semaphore.
+ *
+ * @param[out] semaphore The semaphore to initialize.
+ * @param[in] count The initial count.
+ */
+API void platform_semaphore_init(platform_semaphore *semaphore, u32 count);
+
+/**
+ * @brief Decrements the count of a semaphore, waiting for it to be positive first.
+ *
+ * @param[in] semaphore The semaphore.
+ */
+API void platform_semaphore_wait(platform_semaphore *semaphore);
+
+/**
+ * @brief Decrements the count of a semaphore if it is positive, without waiting.
+ *
+ * @param[in] semaphore The semaphore.
+ *
+ * @retval TRUE The count was decremented
+ * @retval FALSE The count is 0
+ */
+API b8 platform_semaphore_try_wait(platform_semaphore *semaphore);
+
+/**
+ * @brief Increments the count of a semaphore, waking as many waiting threads.
+ *
+ * @param[in] semaphore The semaphore.
+ * @param[in] count The number to add to the count.
+ */
+API void platform_semaphore_post(platform_semaphore *semaphore, u32 count);
+
+/**
+ * @brief Creates a fiber. It starts running its entry point when it is first switched to.
+ *
+ * @note A guard page sits past the end of the stack, so a stack overflow faults instead of corrupting memory.
+ *
+ * @param[in] stack_size The size of the stack of the fiber, in bytes.
+ * @param[in] function The entry point of the fiber.
+ * @param[in] argument The argument given to the entry point.
+ * @param[out] result A pointer to a memory region to store the handle of the fiber.
+ *
+ * @retval TRUE Success
+ * @retval FALSE Failure
+ */
+API b8 platform_fiber_create(u64 stack_size, platform_fiber_function function, void *argument, platform_fiber *result);
+
+/**
+ * @brief Destroys a fiber created with @ref platform_fiber_create, freeing its stack.
+ *
+ * @warning The fiber must not be running.
+ *
+ * @param[in] fiber The fiber to destroy.
+ */
+API void platform_fiber_destroy(platform_fiber fiber);
+
+/**
+ * @brief Turns the calling thread into a fiber, so that it can switch to other fibers and be switched back to.
+ *
+ * @param[out] result A pointer to a memory region to store the handle of the fiber of the thread.
+ *
+ * @retval TRUE Success
+ * @retval FALSE Failure
+ */
+API b8 platform_fiber_convert_thread(platform_fiber *result);
+
+/**
+ * @brief Turns the calling thread back into a regular thread.
+ *
+ * @param[in] fiber The fiber of the thread, from @ref platform_fiber_convert_thread. It must be the one running.
+ */
+API void platform_fiber_revert_thread(platform_fiber fiber);
+
+/**
+ * @brief Saves the context of the running fiber and switches to another one. Returns when a thread switches back to it.
+ *
+ * @note A fiber can be switched back to by another thread than the one it switched from. Thread-local variables read before
+ * the switch may then be stale: read them again after it.
+ *
+ * @param[in] from The running fiber.
+ * @param[in] to The fiber to switch to, which must not be running.
+ */
+API void platform_fiber_switch(platform_fiber from, platform_fiber to);
@@ -1,14 +1,27 @@
 #ifdef PLATFORM_LINUX
+// Needed for dladdr
+#define _GNU_SOURCE
+#include "core/atomic.h"
 #include "core/dynamic_array.h"
 #include "core/log.h"
 #include "core/memory.h"
+#include "core/spinlock.h"
 #include "core/str.h"
 #include "linux_adapter.h"
 #include "platform.h"
 #include <dlfcn.h>
+#include <execinfo.h>
+#include <limits.h>
+#include <linux/futex.h>
+#include <pthread.h>
+#include <sched.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
 #include <time.h>
+#include <ucontext.h>
 #include <unistd.h>
 
 static const char *convert_platform_color(platform_console_color foreground, platform_console_color background) {
@@ -89,6 +102,9 @@ b8 platform_init(platform_system_state *state_storage, u64 *size_requirement) {
     platform_system_state *state = state_storage;
     mem_zero(state, sizeof(platform_system_state));
 
+    POOL_ALLOCATOR_CREATE(&state->window_pool, window, 4, MEMORY_TAG_PLATFORM);
+    slot_map_init(&state->windows, sizeof(window *), 4, allocator_get_heap(MEMORY_TAG_PLATFORM));
+
     // Detect the used display manager
     // We first check the XDG_SESSION_TYPE environment variable
     // If it is not set or invalid, we check the WAYLAND_DISPLAY environment variable
@@ -155,13 +171,13 @@ b8 platform_init(platform_system_state *state_storage, u64 *size_requirement) {
  */
 void platform_deinit(platform_system_state *state) {
     if (adapter) {
-        for (u32 i = 0; i < adapter->platform_state->windows.count; i++) {
-            if (adapter->platform_state->windows.data[i]) {
-                platform_window_destroy(adapter->platform_state->windows.data[i]);
-            }
+        // Destroying a window moves the last one in its place
+        while (adapter->platform_state->windows.count > 0) {
+            platform_window_destroy(*SLOT_MAP_AT(adapter->platform_state->windows, window *, 0));
         }
 
-        DYNARRAY_CLEAR(adapter->platform_state->windows);
+        slot_map_destroy(&adapter->platform_state->windows);
+        pool_allocator_destroy(&adapter->platform_state->window_pool);
 
         adapter->deinit(adapter);
 
@@ -209,6 +225,72 @@ void *platform_allocate(u64 size) { return malloc(size); }
  */
 void platform_free(void *pointer) { free(pointer); }
 
+/**
+ * @brief Gets the size of a virtual memory page.
+ *
+ * @return The size of a page in bytes.
+ */
+u64 platform_get_page_size() { return (u64)sysconf(_SC_PAGESIZE); }
+
+/**
+ * @brief Reserves a range of virtual address space, without backing it with physical memory.
+ *
+ * @param[in] size The size of the range to reserve. Must be a multiple of the page size.
+ * @param[in] huge_pages Whether to hint the OS to back the range with huge pages once committed (ignored if unsupported).
+ *
+ * @return A pointer to the beginning of the range, or NULL on failure.
+ */
+void *platform_virtual_reserve(u64 size, b8 huge_pages) {
+    void *address = mmap(NULL, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (address == MAP_FAILED) {
+        return NULL;
+    }
+
+#ifdef MADV_HUGEPAGE
+    if (huge_pages && madvise(address, size, MADV_HUGEPAGE) != 0) {
+        LOG_TRACE("Transparent huge pages are not available, using regular pages");
+    }
+#endif
+
+    return address;
+}
+
+/**
+ * @brief Commits a part of a reserved range, making it readable and writable.
+ *
+ * @param[in] address The beginning of the part to commit. Must be page aligned.
+ * @param[in] size The size of the part to commit. Must be a multiple of the page size.
+ *
+ * @retval TRUE Success
+ * @retval FALSE Failure
+ */
+b8 platform_virtual_commit(void *address, u64 size) { return mprotect(address, size, PROT_READ | PROT_WRITE) == 0; }
+
+/**
+ * @brief Decommits a part of a reserved range, giving its physical memory back to the OS. The range stays reserved.
+ *
+ * @param[in] address The beginning of the part to decommit. Must be page aligned.
+ * @param[in] size The size of the part to decommit. Must be a multiple of the page size.
+ *
+ * @retval TRUE Success
+ * @retval FALSE Failure
+ */
+b8 platform_virtual_decommit(void *address, u64 size) {
+    if (madvise(address, size, MADV_DONTNEED) != 0) {
+        return FALSE;
+    }
+
+    return mprotect(address, size, PROT_NONE) == 0;
+}
+
+/**
+ * @brief Releases a range previously reserved with @ref platform_virtual_reserve.
+ *
+ * @param[in] address The beginning of the range.
+ * @param[in] size The size of the range, as passed to @ref platform_virtual_reserve.
+ */
+void platform_virtual_release(void *address, u64 size) { munmap(address, size); }
+
 #ifdef DEBUG
 /**
  * @brief Get the address of the caller of the current function.
@@ -220,6 +302,49 @@ void platform_free(void *pointer) { free(pointer); }
 void *platform_get_caller() { return __builtin_return_address(1); }
 #endif
 
+/**
+ * @brief Captures the call stack of the calling thread.
+ *
+ * @param[in] skip The number of innermost frames to skip (not counting this function itself).
+ * @param[in] max_frames The maximum number of frames to capture.
+ * @param[out] frames A pointer to an array of at least max_frames return addresses, innermost first.
+ *
+ * @return The number of frames captured.
+ */
+u32 platform_capture_stack_trace(u32 skip, u32 max_frames, void **frames) {
+    void *buffer[128];
+    u32 requested = skip + 1 + max_frames;
+    i32 count = backtrace(buffer, requested < 128 ? requested : 128);
+
+    u32 captured = 0;
+    for (i32 i = skip + 1; i < count; i++) {
+        frames[captured++] = buffer[i];
+    }
+
+    return captured;
+}
+
+/**
+ * @brief Gets a printable name for a code address.
+ *
+ * @note Only the functions exported in the dynamic symbol table are known (link with -rdynamic to export the executable's).
+ *
+ * @param[in] address The code address.
+ * @param[out] buffer A pointer to a memory region to store the name.
+ * @param[in] size The size of the buffer.
+ */
+void platform_get_symbol_name(void *address, char *buffer, u64 size) {
+    Dl_info info;
+    if (dladdr(address, &info) == 0) {
+        snprintf(buffer, size, "0x%lx", (u64)address);
+    } else if (info.dli_sname != NULL) {
+        snprintf(buffer, size, "%s", info.dli_sname);
+    } else {
+        const char *module = strrchr(info.dli_fname, '/');
+        snprintf(buffer, size, "%s+0x%lx", module != NULL ? module + 1 : info.dli_fname, (u64)address - (u64)info.dli_fbase);
+    }
+}
+
 /**
  * @brief Opens a Dynamic Library file.
  *
@@ -230,7 +355,15 @@ void *platform_get_caller() { return __builtin_return_address(1); }
  * @retval FALSE Failure
  */
 b8 platform_dynamic_library_open(const char *name, dynamic_library *result) {
-    char *new_string = mem_alloc(MEMORY_TAG_STRING, str_len(name) + 7);
+    scratch_marker marker = mem_scratch_mark();
+
+    char *new_string = mem_scratch_alloc(str_len(name) + 7);
+    if (new_string == NULL) {
+        LOG_ERROR("platform_dynamic_library_open: Failed to allocate the file name of %s", name);
+        mem_scratch_rewind(marker);
+        return FALSE;
+    }
+
     mem_zero(new_string, str_len(name) + 7);
     str_cat(new_string, "lib");
     str_cat(new_string, name);
@@ -244,7 +377,7 @@ b8 platform_dynamic_library_open(const char *name, dynamic_library *result) {
         if (size == -1) {
             LOG_ERROR("platform_dynamic_library_open: Failed to read the link of /proc/self/exe"
                       "(could not determine executable path)");
-            mem_free(new_string);
+            mem_scratch_rewind(marker);
             return FALSE;
         }
 
@@ -253,16 +386,21 @@ b8 platform_dynamic_library_open(const char *name, dynamic_library *result) {
             size--;
         }
 
-        char *lib_path = mem_alloc(MEMORY_TAG_STRING, str_len(executable_path) + str_len(new_string) + 1);
+        char *lib_path = mem_scratch_alloc(str_len(executable_path) + str_len(new_string) + 1);
+        if (lib_path == NULL) {
+            LOG_ERROR("platform_dynamic_library_open: Failed to allocate the path of %s", new_string);
+            mem_scratch_rewind(marker);
+            return FALSE;
+        }
+
         mem_zero(lib_path, str_len(executable_path) + str_len(new_string) + 1);
         str_cat(lib_path, executable_path);
         str_cat(lib_path, new_string);
 
         *result = dlopen(lib_path, RTLD_LAZY | RTLD_LOCAL);
-        mem_free(lib_path);
     }
 
-    mem_free(new_string);
+    mem_scratch_rewind(marker);
     return *result != NULL;
 }
 
@@ -307,19 +445,15 @@ b8 platform_window_create(const window_config *config, window **result) {
         return FALSE;
     }
 
-    window *window = mem_alloc(MEMORY_TAG_PLATFORM, sizeof(struct window));
-    u32 index = 0xFFFFFFFF;
-    for (u32 i = 0; i < adapter->platform_state->windows.count; i++) {
-        if (adapter->platform_state->windows.data[i] == NULL) {
-            adapter->platform_state->windows.data[i] = window;
-            index = i;
-            break;
-        }
+    window *window = POOL_ALLOCATE(&adapter->platform_state->window_pool, struct window);
+    if (window == NULL) {
+        LOG_ERROR("Failed to allocate a window");
+        return FALSE;
     }
 
-    if (index == 0xFFFFFFFF) {
-        DYNARRAY_PUSH(adapter->platform_state->windows, window); // NOLINT
-        index = adapter->platform_state->windows.count - 1;
+    if (!slot_map_insert(&adapter->platform_state->windows, &window, &window->id)) {
+        pool_allocator_free(&adapter->platform_state->window_pool, window);
+        return FALSE;
     }
 
     window->width = config->width;
@@ -333,7 +467,8 @@ b8 platform_window_create(const window_config *config, window **result) {
 
     if (!adapter->window_create(adapter, config, window)) {
         mem_free(window->title);
-        mem_free(window);
+        slot_map_remove(&adapter->platform_state->windows, window->id);
+        pool_allocator_free(&adapter->platform_state->window_pool, window);
         return FALSE;
     }
 
@@ -356,20 +491,12 @@ void platform_window_destroy(window *window) {
     if (window->title != NULL) {
         mem_free(window->title);
     }
-    mem_free(window);
 
-    b8 found = FALSE;
-    for (uuid i = 0; i < adapter->platform_state->windows.count; i++) {
-        if (adapter->platform_state->windows.data[i] == window) {
-            adapter->platform_state->windows.data[i] = NULL;
-            found = TRUE;
-            break;
-        }
-    }
-
-    if (!found) {
+    if (!slot_map_remove(&adapter->platform_state->windows, window->id)) {
         LOG_WARN("Tried to destroy an unregistered window");
     }
+
+    pool_allocator_free(&adapter->platform_state->window_pool, window);
 }
 
 /**
@@ -427,6 +554,17 @@ f32 platform_get_time() {
     return now.tv_sec + now.tv_nsec * 0.000000001;
 }
 
+/**
+ * @brief Gets the value of a monotonic clock in nanoseconds.
+ *
+ * @return The time in nanoseconds.
+ */
+API u64 platform_get_time_ns() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC_RAW, &now);
+    return now.tv_sec * 1000000000ull + now.tv_nsec;
+}
+
 /**
  * @brief Sleeps for the specified number of milliseconds.
  *
@@ -440,4 +578,516 @@ API void platform_sleep(u32 milliseconds) {
     return;
 }
 
+/**
+ * @brief The number of times a thread checks whether a locked mutex was unlocked, before going to sleep. Critical sections are
+ * usually short, so the mutex is often unlocked before the thread would even be put to sleep.
+ */
+#define MUTEX_SPIN_COUNT 64
+
+/** @brief What a new thread needs to start, freed by the thread itself once read. */
+typedef struct thread_start {
+    platform_thread_function function;
+    void *argument;
+} thread_start;
+
+static void *thread_entry(void *argument) {
+    thread_start start = *(thread_start *)argument;
+    platform_free(argument);
+
+    start.function(start.argument);
+
+    mem_thread_cache_release();
+    return NULL;
+}
+
+/** @brief Puts the calling thread to sleep while the value at the address is the expected one (it may wake up spuriously). */
+static void futex_wait(u32 *address, u32 expected) {
+    syscall(SYS_futex, address, FUTEX_WAIT_PRIVATE, expected, NULL, NULL, 0);
+}
+
+/** @brief Wakes up to count threads sleeping on the address. */
+static void futex_wake(u32 *address, u32 count) {
+    syscall(SYS_futex, address, FUTEX_WAKE_PRIVATE, count > INT_MAX ? INT_MAX : count, NULL, NULL, 0);
+}
+
+/**
+ * @brief Gets the number of logical processors available to the process.
+ *
+ * @return The number of logical processors (at least 1).
+ */
+API u32 platform_get_processor_count() {
+    // The affinity mask of the process may exclude some processors (in containers for instance)
+    cpu_set_t set;
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        return CPU_COUNT(&set);
+    }
+
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (u32)count : 1;
+}
+
+/**
+ * @brief Creates a thread, which starts running right away.
+ *
+ * @param[in] function The entry point of the thread.
+ * @param[in] argument The argument given to the entry point.
+ * @param[out] result A pointer to a memory region to store the handle of the thread.
+ *
+ * @retval TRUE Success
+ * @retval FALSE Failure
+ */
+API b8 platform_thread_create(platform_thread_function function, void *argument, platform_thread *result) {
+    thread_start *start = platform_allocate(sizeof(thread_start));
+    if (start == NULL) {
+        LOG_ERROR("Failed to allocate the start of a thread");
+        return FALSE;
+    }
+
+    start->function = function;
+    start->argument = argument;
+
+    pthread_t thread;
+    int error = pthread_create(&thread, NULL, thread_entry, start);
+    if (error != 0) {
+        LOG_ERROR("Failed to create a thread: %s", strerror(error));
+        platform_free(start);
+        return FALSE;
+    }
+
+    *result = (platform_thread)thread;
+    return TRUE;
+}
+
+/**
+ * @brief Waits for a thread to finish, and releases its handle.
+ *
+ * @param[in] thread The thread to wait for.
+ *
+ * @retval TRUE Success
+ * @retval FALSE Failure
+ */
+API b8 platform_thread_join(platform_thread thread) { return pthread_join((pthread_t)thread, NULL) == 0; }
+
+/**
+ * @brief Gets the handle of the calling thread.
+ *
+ * @return The handle of the calling thread.
+ */
+API platform_thread platform_thread_current() { return (platform_thread)pthread_self(); }
+
+/**
+ * @brief Sets the name of a thread, truncated to 15 characters.
+ *
+ * @param[in] thread The thread.
+ * @param[in] name The name of the thread.
+ *
+ * @retval TRUE Success
+ * @retval FALSE Failure
+ */
+API b8 platform_thread_set_name(platform_thread thread, const char *name) {
+    // Longer names are rejected, instead of being truncated
+    char truncated[16];
+    strncpy(truncated, name, sizeof(truncated) - 1);
+    truncated[sizeof(truncated) - 1] = '\0';
+
+    return pthread_setname_np((pthread_t)thread, truncated) == 0;
+}
+
+/**
+ * @brief Restricts a thread to run on a single logical processor.
+ *
+ * @param[in] thread The thread.
+ * @param[in] processor The index of the logical processor among those available to the process.
+ *
+ * @retval TRUE Success
+ * @retval FALSE Failure
+ */
+API b8 platform_thread_set_affinity(platform_thread thread, u32 processor) {
+    cpu_set_t available;
+    if (sched_getaffinity(0, sizeof(available), &available) != 0) {
+        return FALSE;
+    }
+
+    // Find the processor-th processor of the affinity mask, which may have holes
+    for (u32 cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (CPU_ISSET(cpu, &available) && processor-- == 0) {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(cpu, &set);
+            return pthread_setaffinity_np((pthread_t)thread, sizeof(set), &set) == 0;
+        }
+    }
+
+    return FALSE;
+}
+
+/** @brief Gives the rest of the time slice of the calling thread to another thread. */
+API void platform_thread_yield() { sched_yield(); }
+
+/**
+ * @brief Locks a mutex, waiting for it if it is locked by another thread.
+ *
+ * @param[in] mutex The mutex to lock.
+ */
+API void platform_mutex_lock(platform_mutex *mutex) {
+    u32 observed = 0;
+    if (atomic_compare_exchange_u32(&mutex->state, &observed, 1, ATOMIC_ORDER_ACQUIRE)) {
+        return;
+    }
+
+    // Spin for a while, unless threads are already sleeping on the mutex
+    for (u32 i = 0; i < MUTEX_SPIN_COUNT && observed == 1; i++) {
+        CPU_RELAX();
+
+        observed = atomic_load_u32(&mutex->state, ATOMIC_ORDER_RELAXED);
+        if (observed == 0 && atomic_compare_exchange_u32(&mutex->state, &observed, 1, ATOMIC_ORDER_ACQUIRE)) {
+            return;
+        }
+    }
+
+    // Mark the mutex as contended before sleeping, so that the thread unlocking it knows it has to wake one
+    while (atomic_exchange_u32(&mutex->state, 2, ATOMIC_ORDER_ACQUIRE) != 0) {
+        futex_wait(&mutex->state, 2);
+    }
+}
+
+/**
+ * @brief Locks a mutex if it is unlocked, without waiting.
+ *
+ * @param[in] mutex The mutex to lock.
+ *
+ * @retval TRUE The mutex was locked
+ * @retval FALSE The mutex is locked by another thread
+ */
+API b8 platform_mutex_try_lock(platform_mutex *mutex) {
+    u32 expected = 0;
+    return atomic_compare_exchange_u32(&mutex->state, &expected, 1, ATOMIC_ORDER_ACQUIRE);
+}
+
+/**
+ * @brief Unlocks a mutex, waking a thread waiting for it if there is one.
+ *
+ * @param[in] mutex The mutex to unlock.
+ */
+API void platform_mutex_unlock(platform_mutex *mutex) {
+    if (atomic_exchange_u32(&mutex->state, 0, ATOMIC_ORDER_RELEASE) == 2) {
+        futex_wake(&mutex->state, 1);
+    }
+}
+
+/**
+ * @brief Unlocks a mutex and waits for a condition variable to be signaled, then locks the mutex again.
+ *
+ * @param[in] condition_variable The condition variable to wait for.
+ * @param[in] mutex The mutex protecting the condition.
+ */
+API void platform_condition_variable_wait(platform_condition_variable *condition_variable, platform_mutex *mutex) {
+    // A signal sent after the mutex is unlocked changes the sequence, so the wait returns right away instead of missing it
+    u32 sequence = atomic_load_u32(&condition_variable->sequence, ATOMIC_ORDER_RELAXED);
+    platform_mutex_unlock(mutex);
+
+    futex_wait(&condition_variable->sequence, sequence);
+
+    // Other woken threads may be waiting for the mutex too, so it is locked as contended
+    while (atomic_exchange_u32(&mutex->state, 2, ATOMIC_ORDER_ACQUIRE) != 0) {
+        futex_wait(&mutex->state, 2);
+    }
+}
+
+/**
+ * @brief Wakes one of the threads waiting for a condition variable.
+ *
+ * @param[in] condition_variable The condition variable.
+ */
+API void platform_condition_variable_signal(platform_condition_variable *condition_variable) {
+    atomic_fetch_add_u32(&condition_variable->sequence, 1, ATOMIC_ORDER_RELEASE);
+    futex_wake(&condition_variable->sequence, 1);
+}
+
+/**
+ * @brief Wakes every thread waiting for a condition variable.
+ *
+ * @param[in] condition_variable The condition variable.
+ */
+API void platform_condition_variable_broadcast(platform_condition_variable *condition_variable) {
+    atomic_fetch_add_u32(&condition_variable->sequence, 1, ATOMIC_ORDER_RELEASE);
+    futex_wake(&condition_variable->sequence, INT_MAX);
+}
+
+/**
+ * @brief Initializes a semaphore.
+ *
+ * @param[out] semaphore The semaphore to initialize.
+ * @param[in] count The initial count.
+ */
+API void platform_semaphore_init(platform_semaphore *semaphore, u32 count) {
+    semaphore->count = count;
+    semaphore->waiters = 0;
+}
+
+/**
+ * @brief Decrements the count of a semaphore, waiting for it to be positive first.
+ *
+ * @param[in] semaphore The semaphore.
+ */
+API void platform_semaphore_wait(platform_semaphore *semaphore) {
+    for (;;) {
+        if (platform_semaphore_try_wait(semaphore)) {
+            return;
+        }
+
+        // The waiter count must be visible before the count is checked again by the kernel, the posting thread checks them in
+        // the other order, so at least one of them sees the change of the other
+        atomic_fetch_add_u32(&semaphore->waiters, 1, ATOMIC_ORDER_SEQ_CST);
+        futex_wait(&semaphore->count, 0);
+        atomic_fetch_sub_u32(&semaphore->waiters, 1, ATOMIC_ORDER_RELAXED);
+    }
+}
+
+/**
+ * @brief Decrements the count of a semaphore if it is positive, without waiting.
+ *
+ * @param[in] semaphore The semaphore.
+ *
+ * @retval TRUE The count was decremented
+ * @retval FALSE The count is 0
+ */
+API b8 platform_semaphore_try_wait(platform_semaphore *semaphore) {
+    u32 count = atomic_load_u32(&semaphore->count, ATOMIC_ORDER_RELAXED);
+    while (count > 0) {
+        if (atomic_compare_exchange_u32(&semaphore->count, &count, count - 1, ATOMIC_ORDER_ACQUIRE)) {
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+/**
+ * @brief Increments the count of a semaphore, waking as many waiting threads.
+ *
+ * @param[in] semaphore The semaphore.
+ * @param[in] count The number to add to the count.
+ */
+API void platform_semaphore_post(platform_semaphore *semaphore, u32 count) {
+    atomic_fetch_add_u32(&semaphore->count, count, ATOMIC_ORDER_SEQ_CST);
+    if (atomic_load_u32(&semaphore->waiters, ATOMIC_ORDER_SEQ_CST) > 0) {
+        futex_wake(&semaphore->count, count);
+    }
+}
+
+/**
+ * @brief A fiber.
+ *
+ * On x86-64, fibers switch with a few instructions that save the callee-saved registers on the stack of the fiber and swap the
+ * stack pointers, since swapcontext also saves the signal mask, which takes two system calls per switch. Elsewhere, they use
+ * the ucontext functions.
+ */
+typedef struct linux_fiber {
+#ifdef __x86_64__
+    /** @brief The stack pointer of the fiber while it is switched out, pointing to its saved registers. */
+    void *stack_pointer;
+#else
+    ucontext_t context;
+#endif
+    /** @brief The reserved range of the stack of the fiber, starting with its guard page, or NULL for the fiber of a thread. */
+    void *stack;
+    /** @brief The size of the stack of the fiber, without its guard page. */
+    u64 stack_size;
+    platform_fiber_function function;
+    void *argument;
+} linux_fiber;
+
+/** @brief Runs the function of a fiber, which must not return: the fiber has no context to return to. */
+static void fiber_run(linux_fiber *fiber) {
+    fiber->function(fiber->argument);
+
+    LOG_FATAL("The fiber %p returned", fiber);
+    abort();
+}
+
+#ifdef __x86_64__
+
+/** @brief The saved state of a fiber, from its stack pointer upwards. */
+typedef struct fiber_frame {
+    u32 mxcsr;
+    u32 x87_control_word;
+    u64 r15, r14, r13, r12, rbx, rbp;
+    void *return_address;
+} fiber_frame;
+
+/**
+ * @brief Saves the callee-saved registers of the running fiber on its stack, stores its stack pointer, then restores the
+ * registers of another fiber from its stack and returns where it switched out (or to fiber_start, for a new fiber).
+ */
+__attribute__((visibility("hidden"))) void fiber_switch_context(void **from_stack_pointer, void *to_stack_pointer);
+
+/** @brief The first code run by a fiber, calling fiber_run with the fiber in r12 (from the frame built at its creation). */
+__attribute__((visibility("hidden"))) void fiber_start();
+
+__asm__(".text\n"
+        ".hidden fiber_switch_context\n"
+        ".globl fiber_switch_context\n"
+        ".type fiber_switch_context, @function\n"
+        "fiber_switch_context:\n"
+        "    pushq %rbp\n"
+        "    pushq %rbx\n"
+        "    pushq %r12\n"
+        "    pushq %r13\n"
+        "    pushq %r14\n"
+        "    pushq %r15\n"
+        "    subq $8, %rsp\n"
+        "    stmxcsr (%rsp)\n"
+        "    fnstcw 4(%rsp)\n"
+        "    movq %rsp, (%rdi)\n"
+        "    movq %rsi, %rsp\n"
+        "    ldmxcsr (%rsp)\n"
+        "    fldcw 4(%rsp)\n"
+        "    addq $8, %rsp\n"
+        "    popq %r15\n"
+        "    popq %r14\n"
+        "    popq %r13\n"
+        "    popq %r12\n"
+        "    popq %rbx\n"
+        "    popq %rbp\n"
+        "    ret\n"
+        ".size fiber_switch_context, .-fiber_switch_context\n"
+        ".hidden fiber_start\n"
+        ".globl fiber_start\n"
+        ".type fiber_start, @function\n"
+        "fiber_start:\n"
+        "    movq %r12, %rdi\n"
+        "    callq *%r13\n"
+        "    ud2\n"
+        ".size fiber_start, .-fiber_start\n");
+
+#else
+
+/** @brief The entry point of every fiber. makecontext only passes int arguments, so the fiber comes in two halves. */
+static void fiber_entry(u32 low, u32 high) { fiber_run((linux_fiber *)(((u64)high << 32) | low)); }
+
+#endif
+
+/**
+ * @brief Creates a fiber. Its stack is a reserved range of address space, with an uncommitted guard page below it.
+ *
+ * @param[in] stack_size The size of the stack of the fiber, in bytes.
+ * @param[in] function The entry point of the fiber.
+ * @param[in] argument The argument given to the entry point.
+ * @param[out] result A pointer to a memory region to store the handle of the fiber.
+ *
+ * @retval TRUE Success
+ * @retval FALSE Failure
+ */
+API b8 platform_fiber_create(u64 stack_size, platform_fiber_function function, void *argument, platform_fiber *result) {
+    linux_fiber *fiber = mem_alloc(MEMORY_TAG_PLATFORM, sizeof(linux_fiber));
+    if (fiber == NULL) {
+        return FALSE;
+    }
+
+    // Reserve a page below the stack and leave it uncommitted, so that an overflow faults instead of corrupting memory
+    u64 page_size = platform_get_page_size();
+    stack_size = (stack_size + page_size - 1) & ~(page_size - 1);
+    fiber->stack = platform_virtual_reserve(page_size + stack_size, FALSE);
+    if (fiber->stack == NULL) {
+        LOG_ERROR("Failed to reserve the stack of a fiber");
+        mem_free(fiber);
+        return FALSE;
+    }
+
+    u8 *stack_bottom = (u8 *)fiber->stack + page_size;
+    if (!platform_virtual_commit(stack_bottom, stack_size)) {
+        LOG_ERROR("Failed to commit the stack of a fiber");
+        platform_virtual_release(fiber->stack, page_size + stack_size);
+        mem_free(fiber);
+        return FALSE;
+    }
+
+    mem_track_external_allocation(MEMORY_TAG_PLATFORM, stack_size);
+    fiber->stack_size = stack_size;
+    fiber->function = function;
+    fiber->argument = argument;
+
+#ifdef __x86_64__
+    // Build the frame the first switch restores. It returns to fiber_start with the stack aligned on 16 bytes, as the call it
+    // makes requires
+    u8 *stack_top = stack_bottom + stack_size;
+    fiber_frame *frame = (fiber_frame *)(stack_top - 16 - sizeof(fiber_frame));
+    mem_zero(frame, sizeof(fiber_frame));
+    frame->mxcsr = 0x1F80;
+    frame->x87_control_word = 0x037F;
+    frame->r12 = (u64)fiber;
+    frame->r13 = (u64)fiber_run;
+    frame->return_address = (void *)fiber_start;
+    fiber->stack_pointer = frame;
+#else
+    if (getcontext(&fiber->context) != 0) {
+        LOG_ERROR("Failed to get the context of a fiber");
+        platform_fiber_destroy(fiber);
+        return FALSE;
+    }
+
+    fiber->context.uc_stack.ss_sp = stack_bottom;
+    fiber->context.uc_stack.ss_size = stack_size;
+    fiber->context.uc_link = NULL;
+    makecontext(&fiber->context, (void (*)())fiber_entry, 2, (u32)(u64)fiber, (u32)((u64)fiber >> 32));
+#endif
+
+    *result = fiber;
+    return TRUE;
+}
+
+/**
+ * @brief Destroys a fiber created with @ref platform_fiber_create, freeing its stack.
+ *
+ * @param[in] fiber The fiber to destroy.
+ */
+API void platform_fiber_destroy(platform_fiber fiber) {
+    linux_fiber *linux_fiber = fiber;
+    platform_virtual_release(linux_fiber->stack, platform_get_page_size() + linux_fiber->stack_size);
+    mem_track_external_free(MEMORY_TAG_PLATFORM, linux_fiber->stack_size);
+    mem_free(linux_fiber);
+}
+
+/**
+ * @brief Turns the calling thread into a fiber.
+ *
+ * @param[out] result A pointer to a memory region to store the handle of the fiber of the thread.
+ *
+ * @retval TRUE Success
+ * @retval FALSE Failure
+ */
+API b8 platform_fiber_convert_thread(platform_fiber *result) {
+    // The context of the thread is saved by its first switch, it runs on the stack of the thread
+    linux_fiber *fiber = mem_alloc(MEMORY_TAG_PLATFORM, sizeof(linux_fiber));
+    if (fiber == NULL) {
+        return FALSE;
+    }
+
+    mem_zero(fiber, sizeof(linux_fiber));
+    *result = fiber;
+    return TRUE;
+}
+
+/**
+ * @brief Turns the calling thread back into a regular thread.
+ *
+ * @param[in] fiber The fiber of the thread.
+ */
+API void platform_fiber_revert_thread(platform_fiber fiber) { mem_free(fiber); }
+
+/**
+ * @brief Saves the context of the running fiber and switches to another one.
+ *
+ * @param[in] from The running fiber.
+ * @param[in] to The fiber to switch to.
+ */
+API void platform_fiber_switch(platform_fiber from, platform_fiber to) {
+#ifdef __x86_64__
+    fiber_switch_context(&((linux_fiber *)from)->stack_pointer, ((linux_fiber *)to)->stack_pointer);
+#else
+    swapcontext(&((linux_fiber *)from)->context, &((linux_fiber *)to)->context);
+#endif
+}
+
 #endif
@@ -1,11 +1,18 @@
 #ifdef PLATFORM_WINDOWS
-#include "core/dynamic_array.h"
+// Needed for WaitOnAddress and SetThreadDescription
+#define _WIN32_WINNT 0x0A00
+#include "core/atomic.h"
 #include "core/event.h"
 #include "core/log.h"
 #include "core/memory.h"
+#include "core/pool_allocator.h"
+#include "core/slot_map.h"
+#include "core/spinlock.h"
 #include "core/str.h"
 #include "platform.h"
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #define WIN32_LEAN_AND_MEAN
 #include <windows.h>
 #include <windowsx.h>
@@ -13,7 +20,10 @@
 
 /** @brief State of the platform layer. */
 struct platform_system_state {
-    DYNARRAY(window *) windows;
+    /** @brief The windows, of window pointers. */
+    slot_map windows;
+    pool_allocator window_pool;
+    pool_allocator window_platform_state_pool;
     platform_window_closed_callback window_closed_callback;
 
     f64 clock_frequency;
@@ -58,7 +68,17 @@ static void show_error_message_box(const char *title, const char *message) {
         // TODO: Function to format string
         const char *prefix = ": '";
         const char *suffix = "'.";
-        char *err_message = mem_alloc(MEMORY_TAG_STRING, size + str_len(message) + str_len(prefix) + str_len(suffix) + 1);
+        scratch_marker marker = mem_scratch_mark();
+        char *err_message = mem_scratch_alloc(size + str_len(message) + str_len(prefix) + str_len(suffix) + 1);
+        if (err_message == NULL) {
+            // Show the message without the description of the error
+            LocalFree(message_buf);
+            mem_scratch_rewind(marker);
+            MessageBoxA(NULL, message, "Error", MB_OK | MB_ICONERROR);
+            LOG_FATAL("%s", message);
+            return;
+        }
+
         err_message[0] = '\0';
         str_cat(err_message, message);
         str_cat(err_message, prefix);
@@ -68,7 +88,7 @@ static void show_error_message_box(const char *title, const char *message) {
 
         MessageBoxA(NULL, err_message, "Error", MB_OK | MB_ICONERROR);
         LOG_FATAL(err_message);
-        mem_free(err_message);
+        mem_scratch_rewind(marker);
     } else {
         MessageBoxA(NULL, message, "Error", MB_OK | MB_ICONERROR);
         LOG_FATAL("Window registration failed");
@@ -97,6 +117,10 @@ b8 platform_init(platform_system_state *state_storage, u64 *size_requirement) {
     state = state_storage;
     mem_zero(state, sizeof(platform_system_state));
 
+    POOL_ALLOCATOR_CREATE(&state->window_pool, window, 4, MEMORY_TAG_PLATFORM);
+    POOL_ALLOCATOR_CREATE(&state->window_platform_state_pool, window_platform_state, 4, MEMORY_TAG_PLATFORM);
+    slot_map_init(&state->windows, sizeof(window *), 4, allocator_get_heap(MEMORY_TAG_PLATFORM));
+
 // Detect corruptions and terminate the application at any time
 #ifdef DEBUG
     if (!HeapSetInformation(GetProcessHeap(), HeapEnableTerminationOnCorruption, NULL, 0)) {
@@ -141,12 +165,13 @@ b8 platform_init(platform_system_state *state_storage, u64 *size_requirement) {
  */
 void platform_deinit(platform_system_state *state) {
     if (state) {
-        for (u32 i = 0; i < state->windows.count; i++) {
-            if (state->windows.data[i]) {
-                platform_window_destroy(state->windows.data[i]);
-            }
+        // Destroying a window moves the last one in its place
+        while (state->windows.count > 0) {
+            platform_window_destroy(*SLOT_MAP_AT(state->windows, window *, 0));
         }
-        DYNARRAY_CLEAR(state->windows);
+        slot_map_destroy(&state->windows);
+        pool_allocator_destroy(&state->window_platform_state_pool);
+        pool_allocator_destroy(&state->window_pool);
     }
     memset(state, 0, sizeof(platform_state));
 }
@@ -202,6 +227,59 @@ void *platform_allocate(u64 size) { return HeapAlloc(GetProcessHeap(), 0, size);
  */
 void platform_free(void *pointer) { HeapFree(GetProcessHeap(), 0, pointer); }
 
+/**
+ * @brief Gets the size of a virtual memory page.
+ *
+ * @return The size of a page in bytes.
+ */
+u64 platform_get_page_size() {
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwPageSize;
+}
+
+/**
+ * @brief Reserves a range of virtual address space, without backing it with physical memory.
+ *
+ * @note Large pages require a privilege and must be committed at reservation time on Windows, so the hint is ignored.
+ *
+ * @param[in] size The size of the range to reserve. Must be a multiple of the page size.
+ * @param[in] huge_pages Whether to hint the OS to back the range with huge pages once committed (ignored if unsupported).
+ *
+ * @return A pointer to the beginning of the range, or NULL on failure.
+ */
+void *platform_virtual_reserve(u64 size, b8 huge_pages) { return VirtualAlloc(NULL, size, MEM_RESERVE, PAGE_NOACCESS); }
+
+/**
+ * @brief Commits a part of a reserved range, making it readable and writable.
+ *
+ * @param[in] address The beginning of the part to commit. Must be page aligned.
+ * @param[in] size The size of the part to commit. Must be a multiple of the page size.
+ *
+ * @retval TRUE Success
+ * @retval FALSE Failure
+ */
+b8 platform_virtual_commit(void *address, u64 size) { return VirtualAlloc(address, size, MEM_COMMIT, PAGE_READWRITE) != NULL; }
+
+/**
+ * @brief Decommits a part of a reserved range, giving its physical memory back to the OS. The range stays reserved.
+ *
+ * @param[in] address The beginning of the part to decommit. Must be page aligned.
+ * @param[in] size The size of the part to decommit. Must be a multiple of the page size.
+ *
+ * @retval TRUE Success
+ * @retval FALSE Failure
+ */
+b8 platform_virtual_decommit(void *address, u64 size) { return VirtualFree(address, size, MEM_DECOMMIT) == TRUE; }
+
+/**
+ * @brief Releases a range previously reserved with @ref platform_virtual_reserve.
+ *
+ * @param[in] address The beginning of the range.
+ * @param[in] size The size of the range, as passed to @ref platform_virtual_reserve.
+ */
+void platform_virtual_release(void *address, u64 size) { VirtualFree(address, 0, MEM_RELEASE); }
+
 #ifdef DEBUG
 /**
  * @brief Get the address of the caller of the current function.
@@ -222,6 +300,48 @@ void *platform_get_caller() {
 }
 #endif
 
+/**
+ * @brief Captures the call stack of the calling thread.
+ *
+ * @param[in] skip The number of innermost frames to skip (not counting this function itself).
+ * @param[in] max_frames The maximum number of frames to capture.
+ * @param[out] frames A pointer to an array of at least max_frames return addresses, innermost first.
+ *
+ * @return The number of frames captured.
+ */
+u32 platform_capture_stack_trace(u32 skip, u32 max_frames, void **frames) {
+    return CaptureStackBackTrace(skip + 1, max_frames, frames, NULL);
+}
+
+/**
+ * @brief Gets a printable name for a code address.
+ *
+ * @note The symbols are not resolved (that would require dbghelp): the name is always the module and the offset in it.
+ *
+ * @param[in] address The code address.
+ * @param[out] buffer A pointer to a memory region to store the name.
+ * @param[in] size The size of the buffer.
+ */
+void platform_get_symbol_name(void *address, char *buffer, u64 size) {
+    HMODULE module;
+    char module_path[MAX_PATH];
+
+    if (!GetModuleHandleExA(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS | GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT,
+                            (LPCSTR)address,
+                            &module) ||
+        GetModuleFileNameA(module, module_path, MAX_PATH) == 0) {
+        snprintf(buffer, size, "0x%llx", (u64)address);
+        return;
+    }
+
+    const char *module_name = strrchr(module_path, '\\');
+    snprintf(buffer,
+             size,
+             "%s+0x%llx",
+             module_name != NULL ? module_name + 1 : module_path,
+             (u64)address - (u64)module);
+}
+
 /**
  * @brief Opens a Dynamic Library file.
  *
@@ -277,19 +397,15 @@ b8 platform_window_create(const window_config *config, window **result) {
         return FALSE;
     }
 
-    window *window = mem_alloc(MEMORY_TAG_PLATFORM, sizeof(struct window));
-    u32 index = 0xFFFFFFFF;
-    for (u32 i = 0; i < state->windows.count; i++) {
-        if (state->windows.data[i] == NULL) {
-            state->windows.data[i] = window;
-            index = i;
-            break;
-        }
+    window *window = POOL_ALLOCATE(&state->window_pool, struct window);
+    if (window == NULL) {
+        LOG_ERROR("Failed to allocate a window");
+        return FALSE;
     }
 
-    if (index == 0xFFFFFFFF) {
-        DYNARRAY_PUSH(state->windows, window);
-        index = state->windows.count - 1;
+    if (!slot_map_insert(&state->windows, &window, &window->id)) {
+        pool_allocator_free(&state->window_pool, window);
+        return FALSE;
     }
 
     i32 client_x = config->position_x;
@@ -323,7 +439,15 @@ b8 platform_window_create(const window_config *config, window **result) {
     window->height = client_height;
     window->device_pixel_ratio = 1.0f;
 
-    window->platform_state = mem_alloc(MEMORY_TAG_PLATFORM, sizeof(window_platform_state));
+    window->platform_state = POOL_ALLOCATE(&state->window_platform_state_pool, window_platform_state);
+    if (window->platform_state == NULL) {
+        LOG_ERROR("Failed to allocate the platform state of a window");
+        mem_free(window->title);
+        slot_map_remove(&state->windows, window->id);
+        pool_allocator_free(&state->window_pool, window);
+        return FALSE;
+    }
+
     mem_zero(window->platform_state, sizeof(window_platform_state));
 
     window->platform_state->handle = CreateWindowExA(window_ex_style,
@@ -337,7 +461,7 @@ b8 platform_window_create(const window_config *config, window **result) {
                                                      NULL,
                                                      NULL,
                                                      GetModuleHandleA(NULL),
-                                                     (LPVOID)(u64)index);
+                                                     (LPVOID)window->id);
 
     if (window->platform_state->handle == NULL) {
         show_error_message_box("Error", "Window creation failed");
@@ -358,22 +482,14 @@ b8 platform_window_create(const window_config *config, window **result) {
 void platform_window_destroy(window *window) {
     DestroyWindow(window->platform_state->handle);
     mem_free(window->title);
-    mem_free(window->platform_state);
-    mem_zero(window, sizeof(window));
-    mem_free(window);
-
-    b8 found = FALSE;
-    for (u32 i = 0; i < state->windows.count; i++) {
-        if (state->windows.data[i] == window) {
-            state->windows.data[i] = NULL;
-            found = TRUE;
-            break;
-        }
-    }
+    pool_allocator_free(&state->window_platform_state_pool, window->platform_state);
 
-    if (!found) {
+    if (!slot_map_remove(&state->windows, window->id)) {
         LOG_WARN("Tried to destroy an unregistered window");
     }
+
+    mem_zero(window, sizeof(window));
+    pool_allocator_free(&state->window_pool, window);
 }
 
 /**
@@ -440,6 +556,30 @@ f32 platform_get_time() {
     return (f64)now_time.QuadPart * state->clock_frequency;
 }
 
+/**
+ * @brief Gets the value of a monotonic clock in nanoseconds.
+ *
+ * @note Unlike @ref platform_get_time, this does not need the platform layer to be initialized.
+ *
+ * @return The time in nanoseconds.
+ */
+API u64 platform_get_time_ns() {
+    static u64 frequency = 0;
+    if (frequency == 0) {
+        LARGE_INTEGER result;
+        QueryPerformanceFrequency(&result);
+        frequency = result.QuadPart;
+    }
+
+    LARGE_INTEGER now_time;
+    QueryPerformanceCounter(&now_time);
+
+    // Split the conversion to avoid overflowing 64 bits
+    u64 seconds = now_time.QuadPart / frequency;
+    u64 remainder = now_time.QuadPart % frequency;
+    return seconds * 1000000000ull + remainder * 1000000000ull / frequency;
+}
+
 /**
  * @brief Sleeps for the specified number of milliseconds.
  *
@@ -447,6 +587,408 @@ f32 platform_get_time() {
  */
 API void platform_sleep(u32 milliseconds) { Sleep(milliseconds); }
 
+/**
+ * @brief The number of times a thread checks whether a locked mutex was unlocked, before going to sleep. Critical sections are
+ * usually short, so the mutex is often unlocked before the thread would even be put to sleep.
+ */
+#define MUTEX_SPIN_COUNT 64
+
+/** @brief What a new thread needs to start, freed by the thread itself once read. */
+typedef struct thread_start {
+    platform_thread_function function;
+    void *argument;
+} thread_start;
+
+static DWORD WINAPI thread_entry(LPVOID argument) {
+    thread_start start = *(thread_start *)argument;
+    platform_free(argument);
+
+    start.function(start.argument);
+
+    mem_thread_cache_release();
+    return 0;
+}
+
+/** @brief Puts the calling thread to sleep while the value at the address is the expected one (it may wake up spuriously). */
+static void futex_wait(u32 *address, u32 expected) { WaitOnAddress(address, &expected, sizeof(u32), INFINITE); }
+
+/** @brief Wakes up to count threads sleeping on the address. */
+static void futex_wake(u32 *address, u32 count) {
+    if (count == 1) {
+        WakeByAddressSingle(address);
+    } else {
+        WakeByAddressAll(address);
+    }
+}
+
+/**
+ * @brief Gets the number of logical processors available to the process.
+ *
+ * @return The number of logical processors (at least 1).
+ */
+API u32 platform_get_processor_count() {
+    DWORD count = GetActiveProcessorCount(ALL_PROCESSOR_GROUPS);
+    return count > 0 ? count : 1;
+}
+
+/**
+ * @brief Creates a thread, which starts running right away.
+ *
+ * @param[in] function The entry point of the thread.
+ * @param[in] argument The argument given to the entry point.
+ * @param[out] result A pointer to a memory region to store the handle of the thread.
+ *
+ * @retval TRUE Success
+ * @retval FALSE Failure
+ */
+API b8 platform_thread_create(platform_thread_function function, void *argument, platform_thread *result) {
+    thread_start *start = platform_allocate(sizeof(thread_start));
+    if (start == NULL) {
+        LOG_ERROR("Failed to allocate the start of a thread");
+        return FALSE;
+    }
+
+    start->function = function;
+    start->argument = argument;
+
+    HANDLE thread = CreateThread(NULL, 0, thread_entry, start, 0, NULL);
+    if (thread == NULL) {
+        LOG_ERROR("Failed to create a thread: %lu", GetLastError());
+        platform_free(start);
+        return FALSE;
+    }
+
+    *result = thread;
+    return TRUE;
+}
+
+/**
+ * @brief Waits for a thread to finish, and releases its handle.
+ *
+ * @param[in] thread The thread to wait for.
+ *
+ * @retval TRUE Success
+ * @retval FALSE Failure
+ */
+API b8 platform_thread_join(platform_thread thread) {
+    b8 result = WaitForSingleObject(thread, INFINITE) == WAIT_OBJECT_0;
+    CloseHandle(thread);
+    return result;
+}
+
+/**
+ * @brief Gets the handle of the calling thread.
+ *
+ * @note This is a pseudo handle, only valid in the calling thread.
+ *
+ * @return The handle of the calling thread.
+ */
+API platform_thread platform_thread_current() { return GetCurrentThread(); }
+
+/**
+ * @brief Sets the name of a thread.
+ *
+ * @param[in] thread The thread.
+ * @param[in] name The name of the thread.
+ *
+ * @retval TRUE Success
+ * @retval FALSE Failure
+ */
+API b8 platform_thread_set_name(platform_thread thread, const char *name) {
+    wchar_t wide_name[64];
+    if (MultiByteToWideChar(CP_UTF8, 0, name, -1, wide_name, sizeof(wide_name) / sizeof(wide_name[0])) == 0) {
+        return FALSE;
+    }
+
+    return SUCCEEDED(SetThreadDescription(thread, wide_name));
+}
+
+/**
+ * @brief Restricts a thread to run on a single logical processor.
+ *
+ * @note Only the processors of the first processor group (the first 64) are supported.
+ *
+ * @param[in] thread The thread.
+ * @param[in] processor The index of the logical processor among those available to the process.
+ *
+ * @retval TRUE Success
+ * @retval FALSE Failure
+ */
+API b8 platform_thread_set_affinity(platform_thread thread, u32 processor) {
+    DWORD_PTR process_mask;
+    DWORD_PTR system_mask;
+    if (!GetProcessAffinityMask(GetCurrentProcess(), &process_mask, &system_mask)) {
+        return FALSE;
+    }
+
+    // Find the processor-th processor of the affinity mask, which may have holes
+    for (u32 cpu = 0; cpu < sizeof(DWORD_PTR) * 8; cpu++) {
+        if ((process_mask & ((DWORD_PTR)1 << cpu)) != 0 && processor-- == 0) {
+            return SetThreadAffinityMask(thread, (DWORD_PTR)1 << cpu) != 0;
+        }
+    }
+
+    return FALSE;
+}
+
+/** @brief Gives the rest of the time slice of the calling thread to another thread. */
+API void platform_thread_yield() { SwitchToThread(); }
+
+/**
+ * @brief Locks a mutex, waiting for it if it is locked by another thread.
+ *
+ * @param[in] mutex The mutex to lock.
+ */
+API void platform_mutex_lock(platform_mutex *mutex) {
+    u32 observed = 0;
+    if (atomic_compare_exchange_u32(&mutex->state, &observed, 1, ATOMIC_ORDER_ACQUIRE)) {
+        return;
+    }
+
+    // Spin for a while, unless threads are already sleeping on the mutex
+    for (u32 i = 0; i < MUTEX_SPIN_COUNT && observed == 1; i++) {
+        CPU_RELAX();
+
+        observed = atomic_load_u32(&mutex->state, ATOMIC_ORDER_RELAXED);
+        if (observed == 0 && atomic_compare_exchange_u32(&mutex->state, &observed, 1, ATOMIC_ORDER_ACQUIRE)) {
+            return;
+        }
+    }
+
+    // Mark the mutex as contended before sleeping, so that the thread unlocking it knows it has to wake one
+    while (atomic_exchange_u32(&mutex->state, 2, ATOMIC_ORDER_ACQUIRE) != 0) {
+        futex_wait(&mutex->state, 2);
+    }
+}
+
+/**
+ * @brief Locks a mutex if it is unlocked, without waiting.
+ *
+ * @param[in] mutex The mutex to lock.
+ *
+ * @retval TRUE The mutex was locked
+ * @retval FALSE The mutex is locked by another thread
+ */
+API b8 platform_mutex_try_lock(platform_mutex *mutex) {
+    u32 expected = 0;
+    return atomic_compare_exchange_u32(&mutex->state, &expected, 1, ATOMIC_ORDER_ACQUIRE);
+}
+
+/**
+ * @brief Unlocks a mutex, waking a thread waiting for it if there is one.
+ *
+ * @param[in] mutex The mutex to unlock.
+ */
+API void platform_mutex_unlock(platform_mutex *mutex) {
+    if (atomic_exchange_u32(&mutex->state, 0, ATOMIC_ORDER_RELEASE) == 2) {
+        futex_wake(&mutex->state, 1);
+    }
+}
+
+/**
+ * @brief Unlocks a mutex and waits for a condition variable to be signaled, then locks the mutex again.
+ *
+ * @param[in] condition_variable The condition variable to wait for.
+ * @param[in] mutex The mutex protecting the condition.
+ */
+API void platform_condition_variable_wait(platform_condition_variable *condition_variable, platform_mutex *mutex) {
+    // A signal sent after the mutex is unlocked changes the sequence, so the wait returns right away instead of missing it
+    u32 sequence = atomic_load_u32(&condition_variable->sequence, ATOMIC_ORDER_RELAXED);
+    platform_mutex_unlock(mutex);
+
+    futex_wait(&condition_variable->sequence, sequence);
+
+    // Other woken threads may be waiting for the mutex too, so it is locked as contended
+    while (atomic_exchange_u32(&mutex->state, 2, ATOMIC_ORDER_ACQUIRE) != 0) {
+        futex_wait(&mutex->state, 2);
+    }
+}
+
+/**
+ * @brief Wakes one of the threads waiting for a condition variable.
+ *
+ * @param[in] condition_variable The condition variable.
+ */
+API void platform_condition_variable_signal(platform_condition_variable *condition_variable) {
+    atomic_fetch_add_u32(&condition_variable->sequence, 1, ATOMIC_ORDER_RELEASE);
+    futex_wake(&condition_variable->sequence, 1);
+}
+
+/**
+ * @brief Wakes every thread waiting for a condition variable.
+ *
+ * @param[in] condition_variable The condition variable.
+ */
+API void platform_condition_variable_broadcast(platform_condition_variable *condition_variable) {
+    atomic_fetch_add_u32(&condition_variable->sequence, 1, ATOMIC_ORDER_RELEASE);
+    futex_wake(&condition_variable->sequence, 0xFFFFFFFF);
+}
+
+/**
+ * @brief Initializes a semaphore.
+ *
+ * @param[out] semaphore The semaphore to initialize.
+ * @param[in] count The initial count.
+ */
+API void platform_semaphore_init(platform_semaphore *semaphore, u32 count) {
+    semaphore->count = count;
+    semaphore->waiters = 0;
+}
+
+/**
+ * @brief Decrements the count of a semaphore, waiting for it to be positive first.
+ *
+ * @param[in] semaphore The semaphore.
+ */
+API void platform_semaphore_wait(platform_semaphore *semaphore) {
+    for (;;) {
+        if (platform_semaphore_try_wait(semaphore)) {
+            return;
+        }
+
+        // The waiter count must be visible before the count is checked again by the kernel, the posting thread checks them in
+        // the other order, so at least one of them sees the change of the other
+        atomic_fetch_add_u32(&semaphore->waiters, 1, ATOMIC_ORDER_SEQ_CST);
+        futex_wait(&semaphore->count, 0);
+        atomic_fetch_sub_u32(&semaphore->waiters, 1, ATOMIC_ORDER_RELAXED);
+    }
+}
+
+/**
+ * @brief Decrements the count of a semaphore if it is positive, without waiting.
+ *
+ * @param[in] semaphore The semaphore.
+ *
+ * @retval TRUE The count was decremented
+ * @retval FALSE The count is 0
+ */
+API b8 platform_semaphore_try_wait(platform_semaphore *semaphore) {
+    u32 count = atomic_load_u32(&semaphore->count, ATOMIC_ORDER_RELAXED);
+    while (count > 0) {
+        if (atomic_compare_exchange_u32(&semaphore->count, &count, count - 1, ATOMIC_ORDER_ACQUIRE)) {
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+/**
+ * @brief Increments the count of a semaphore, waking as many waiting threads.
+ *
+ * @param[in] semaphore The semaphore.
+ * @param[in] count The number to add to the count.
+ */
+API void platform_semaphore_post(platform_semaphore *semaphore, u32 count) {
+    atomic_fetch_add_u32(&semaphore->count, count, ATOMIC_ORDER_SEQ_CST);
+    if (atomic_load_u32(&semaphore->waiters, ATOMIC_ORDER_SEQ_CST) > 0) {
+        futex_wake(&semaphore->count, count);
+    }
+}
+
+/** @brief A fiber, on top of the fibers of Windows. */
+typedef struct win32_fiber {
+    LPVOID handle;
+    platform_fiber_function function;
+    void *argument;
+} win32_fiber;
+
+static VOID WINAPI fiber_entry(LPVOID argument) {
+    win32_fiber *fiber = argument;
+    fiber->function(fiber->argument);
+
+    // Returning from a fiber ends the thread
+    LOG_FATAL("The fiber %p returned", fiber);
+    abort();
+}
+
+/**
+ * @brief Creates a fiber. Its stack is allocated by the system.
+ *
+ * @param[in] stack_size The size of the stack of the fiber, in bytes.
+ * @param[in] function The entry point of the fiber.
+ * @param[in] argument The argument given to the entry point.
+ * @param[out] result A pointer to a memory region to store the handle of the fiber.
+ *
+ * @retval TRUE Success
+ * @retval FALSE Failure
+ */
+API b8 platform_fiber_create(u64 stack_size, platform_fiber_function function, void *argument, platform_fiber *result) {
+    win32_fiber *fiber = mem_alloc(MEMORY_TAG_PLATFORM, sizeof(win32_fiber));
+    if (fiber == NULL) {
+        return FALSE;
+    }
+
+    fiber->function = function;
+    fiber->argument = argument;
+    fiber->handle = CreateFiber(stack_size, fiber_entry, fiber);
+    if (fiber->handle == NULL) {
+        LOG_ERROR("Failed to create a fiber: %lu", GetLastError());
+        mem_free(fiber);
+        return FALSE;
+    }
+
+    *result = fiber;
+    return TRUE;
+}
+
+/**
+ * @brief Destroys a fiber created with @ref platform_fiber_create, freeing its stack.
+ *
+ * @param[in] fiber The fiber to destroy.
+ */
+API void platform_fiber_destroy(platform_fiber fiber) {
+    DeleteFiber(((win32_fiber *)fiber)->handle);
+    mem_free(fiber);
+}
+
+/**
+ * @brief Turns the calling thread into a fiber.
+ *
+ * @param[out] result A pointer to a memory region to store the handle of the fiber of the thread.
+ *
+ * @retval TRUE Success
+ * @retval FALSE Failure
+ */
+API b8 platform_fiber_convert_thread(platform_fiber *result) {
+    win32_fiber *fiber = mem_alloc(MEMORY_TAG_PLATFORM, sizeof(win32_fiber));
+    if (fiber == NULL) {
+        return FALSE;
+    }
+
+    mem_zero(fiber, sizeof(win32_fiber));
+    fiber->handle = ConvertThreadToFiber(NULL);
+    if (fiber->handle == NULL) {
+        LOG_ERROR("Failed to convert the thread to a fiber: %lu", GetLastError());
+        mem_free(fiber);
+        return FALSE;
+    }
+
+    *result = fiber;
+    return TRUE;
+}
+
+/**
+ * @brief Turns the calling thread back into a regular thread.
+ *
+ * @param[in] fiber The fiber of the thread.
+ */
+API void platform_fiber_revert_thread(platform_fiber fiber) {
+    ConvertFiberToThread();
+    mem_free(fiber);
+}
+
+/**
+ * @brief Saves the context of the running fiber and switches to another one.
+ *
+ * @param[in] from The running fiber (its context is saved by the system).
+ * @param[in] to The fiber to switch to.
+ */
+API void platform_fiber_switch(platform_fiber from, platform_fiber to) {
+    (void)from;
+    SwitchToFiber(((win32_fiber *)to)->handle);
+}
+
 static key key_from_scancode(u16 scan_code) {
     switch (scan_code) {
     /** @brief Letters */
@@ -575,20 +1117,24 @@ static LRESULT CALLBACK wnd_proc_bootstrap(HWND handle, UINT msg, WPARAM wp, LPA
         return DefWindowProcA(handle, msg, wp, lp);
     }
 
-    u32 index = (u32)(u64)((LPCREATESTRUCTA)lp)->lpCreateParams;
+    uuid id = (uuid)((LPCREATESTRUCTA)lp)->lpCreateParams;
 
-    SetWindowLongPtrA(handle, GWLP_USERDATA, (LONG_PTR)(u64)index);
+    SetWindowLongPtrA(handle, GWLP_USERDATA, (LONG_PTR)id);
     SetWindowLongPtrA(handle, GWLP_WNDPROC, (LONG_PTR)wnd_proc_stub);
 
-    window *window = state->windows.data[index];
+    window *window = *(struct window **)slot_map_get(&state->windows, id);
     window->platform_state->handle = handle;
 
     wnd_proc(window, msg, wp, lp);
 }
 
 static LRESULT CALLBACK wnd_proc_stub(HWND handle, UINT msg, WPARAM wp, LPARAM lp) {
-    u32 index = (u32)GetWindowLongPtrA(handle, GWLP_USERDATA);
-    return wnd_proc(state->windows.data[index], msg, wp, lp);
+    struct window **window = slot_map_get(&state->windows, (uuid)GetWindowLongPtrA(handle, GWLP_USERDATA));
+    if (window == NULL) {
+        return DefWindowProcA(handle, msg, wp, lp);
+    }
+
+    return wnd_proc(*window, msg, wp, lp);
 }
 
 static LRESULT wnd_proc(window *window, UINT msg, WPARAM wp, LPARAM lp) {
@@ -90,6 +90,9 @@ typedef struct vulkan_command_buffer {
 
 /** @brief Structure that contains all the state of the vulkan renderer backend. */
 typedef struct vulkan_state {
+    /** @brief The host allocator given to the driver, backed by the engine memory system. */
+    VkAllocationCallbacks allocator;
+    /** @brief A pointer to the host allocator, as passed to vulkan functions. */
     VkAllocationCallbacks *allocation_callbacks;
     VkInstance instance;
     VkSurfaceKHR surface;
@@ -125,4 +128,4 @@ typedef struct vulkan_state {
     uuid on_resize_handler;
 } vulkan_state;
 
-typedef DYNARRAY(const char *) extension_dynarray;
+typedef SMALL_DYNARRAY(const char *, 8) extension_dynarray;
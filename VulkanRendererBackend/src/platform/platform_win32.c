@@ -43,7 +43,7 @@ b8 vulkan_platform_surface_create(vulkan_state *state, const window *window) {
  * @param[in,out] extensions The list of extensions to append to.
  */
 void vulkan_platform_get_required_extensions(extension_dynarray *extensions) {
-    DYNARRAY_PUSH(*extensions, "VK_KHR_win32_surface");
+    SMALL_DYNARRAY_PUSH(*extensions, "VK_KHR_win32_surface");
 }
 
 /**
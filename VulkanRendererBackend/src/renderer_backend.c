@@ -1,6 +1,7 @@
 #include "renderer_backend.h"
 #include "internal_types.h"
 #include "platform/vulkan_platform.h"
+#include "vulkan_allocator.h"
 #include "vulkan_command_buffer.h"
 #include "vulkan_device.h"
 #include "vulkan_swapchain.h"
@@ -185,6 +186,9 @@ b8 vulkan_init(renderer_backend_interface *interface, renderer_backend_config *c
 
     state->win = window;
 
+    vulkan_allocator_create(&state->allocator);
+    state->allocation_callbacks = &state->allocator;
+
     if (!create_instance(state, config)) {
         return FALSE;
     }
@@ -509,9 +513,9 @@ static b8 create_instance(vulkan_state *state, renderer_backend_config *config)
 #endif
 
     extension_dynarray extensions = {};
-    DYNARRAY_PUSH(extensions, VK_KHR_SURFACE_EXTENSION_NAME);
+    SMALL_DYNARRAY_PUSH(extensions, VK_KHR_SURFACE_EXTENSION_NAME);
 #ifdef DEBUG
-    DYNARRAY_PUSH(extensions, VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
+    SMALL_DYNARRAY_PUSH(extensions, VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
 #endif
     vulkan_platform_get_required_extensions(&extensions);
 
@@ -521,17 +525,17 @@ static b8 create_instance(vulkan_state *state, renderer_backend_config *config)
         .enabledLayerCount = layer_count,
         .ppEnabledLayerNames = layer_names,
         .enabledExtensionCount = extensions.count,
-        .ppEnabledExtensionNames = extensions.data,
+        .ppEnabledExtensionNames = SMALL_DYNARRAY_DATA(extensions),
     };
 
     result = vkCreateInstance(&create_info, state->allocation_callbacks, &state->instance);
     if (result != VK_SUCCESS) {
         LOG_ERROR("Failed to create vulkan instance: %s", vk_result_to_string(result));
-        DYNARRAY_CLEAR(extensions);
+        SMALL_DYNARRAY_CLEAR(extensions);
         return FALSE;
     }
 
-    DYNARRAY_CLEAR(extensions);
+    SMALL_DYNARRAY_CLEAR(extensions);
     return TRUE;
 }
 
@@ -0,0 +1,78 @@
+#include "vulkan_allocator.h"
+#include <core/memory.h>
+
+static void *VKAPI_PTR vulkan_allocation(void *user_data, size_t size, size_t alignment, VkSystemAllocationScope scope) {
+    (void)user_data;
+    (void)scope;
+
+    if (size == 0) {
+        return NULL;
+    }
+
+    return mem_alloc_aligned(MEMORY_TAG_VULKAN, size, alignment);
+}
+
+static void *VKAPI_PTR vulkan_reallocation(
+    void *user_data, void *original, size_t size, size_t alignment, VkSystemAllocationScope scope) {
+    if (original == NULL) {
+        return vulkan_allocation(user_data, size, alignment, scope);
+    }
+
+    if (size == 0) {
+        mem_free(original);
+        return NULL;
+    }
+
+    // On failure, the original allocation must be left untouched
+    void *block = mem_alloc_aligned(MEMORY_TAG_VULKAN, size, alignment);
+    if (block == NULL) {
+        return NULL;
+    }
+
+    u64 original_size = mem_get_size(original);
+    mem_copy(block, original, original_size < size ? original_size : size);
+    mem_free(original);
+
+    return block;
+}
+
+static void VKAPI_PTR vulkan_free(void *user_data, void *memory) {
+    (void)user_data;
+    mem_free(memory);
+}
+
+static void VKAPI_PTR vulkan_internal_allocation_notification(void *user_data,
+                                                              size_t size,
+                                                              VkInternalAllocationType allocation_type,
+                                                              VkSystemAllocationScope scope) {
+    (void)user_data;
+    (void)allocation_type;
+    (void)scope;
+
+    // The driver allocated memory itself (executable memory for instance), so it can only be accounted for
+    mem_track_external_allocation(MEMORY_TAG_VULKAN, size);
+}
+
+static void VKAPI_PTR vulkan_internal_free_notification(void *user_data,
+                                                        size_t size,
+                                                        VkInternalAllocationType allocation_type,
+                                                        VkSystemAllocationScope scope) {
+    (void)user_data;
+    (void)allocation_type;
+    (void)scope;
+    mem_track_external_free(MEMORY_TAG_VULKAN, size);
+}
+
+/**
+ * @brief Fills allocation callbacks backed by the engine memory system.
+ *
+ * @param[out] callbacks A pointer to the callbacks to fill.
+ */
+void vulkan_allocator_create(VkAllocationCallbacks *callbacks) {
+    callbacks->pUserData = NULL;
+    callbacks->pfnAllocation = vulkan_allocation;
+    callbacks->pfnReallocation = vulkan_reallocation;
+    callbacks->pfnFree = vulkan_free;
+    callbacks->pfnInternalAllocation = vulkan_internal_allocation_notification;
+    callbacks->pfnInternalFree = vulkan_internal_free_notification;
+}
@@ -0,0 +1,19 @@
+/**
+ * @file vulkan_allocator.h
+ * @author Killian Bellouard (killianbellouard@gmail.com)
+ * @brief This file defines the host allocator given to the vulkan driver, so that its allocations are served (and tracked) by
+ * the engine memory system, under @ref MEMORY_TAG_VULKAN.
+ * @version 0.1
+ * @date 2024-08-13
+ */
+
+#pragma once
+
+#include "internal_types.h"
+
+/**
+ * @brief Fills allocation callbacks backed by the engine memory system.
+ *
+ * @param[out] callbacks A pointer to the callbacks to fill.
+ */
+void vulkan_allocator_create(VkAllocationCallbacks *callbacks);
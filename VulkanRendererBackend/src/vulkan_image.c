@@ -142,11 +142,11 @@ void vulkan_image_destroy(vulkan_state *state, vulkan_image *image) {
     }
 
     if (image->view != VK_NULL_HANDLE) {
-        vkDestroyImageView(state->device.logical_device, image->view, NULL);
+        vkDestroyImageView(state->device.logical_device, image->view, state->allocation_callbacks);
     }
 
     if (image->handle != VK_NULL_HANDLE) {
-        vkDestroyImage(state->device.logical_device, image->handle, NULL);
-        vkFreeMemory(state->device.logical_device, image->memory, NULL);
+        vkDestroyImage(state->device.logical_device, image->handle, state->allocation_callbacks);
+        vkFreeMemory(state->device.logical_device, image->memory, state->allocation_callbacks);
     }
 }
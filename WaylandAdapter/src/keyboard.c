@@ -18,10 +18,10 @@ void wayland_keyboard_handle_enter(
     linux_adapter *adapter = (linux_adapter *)data;
 
     adapter->adapter_state->keyboard_focus = INVALID_UUID;
-    for (uuid i = 0; i < adapter->platform_state->windows.count; i++) {
-        window *window = adapter->platform_state->windows.data[i];
+    for (u32 i = 0; i < adapter->platform_state->windows.count; i++) {
+        window *window = *SLOT_MAP_AT(adapter->platform_state->windows, struct window *, i);
         if (window->platform_state->surface == surface) {
-            adapter->adapter_state->keyboard_focus = i;
+            adapter->adapter_state->keyboard_focus = window->id;
         }
     }
 }
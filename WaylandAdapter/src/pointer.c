@@ -9,10 +9,10 @@ void wayland_pointer_handle_enter(
     (void)serial;
     linux_adapter *adapter = (linux_adapter *)data;
 
-    for (uuid i = 0; i < adapter->platform_state->windows.count; i++) {
-        window *window = adapter->platform_state->windows.data[i];
+    for (u32 i = 0; i < adapter->platform_state->windows.count; i++) {
+        window *window = *SLOT_MAP_AT(adapter->platform_state->windows, struct window *, i);
         if (window->platform_state->surface == surface) {
-            adapter->adapter_state->pointer_focus = i;
+            adapter->adapter_state->pointer_focus = window->id;
         }
     }
 
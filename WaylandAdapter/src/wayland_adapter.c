@@ -223,11 +223,11 @@ b8 wayland_vulkan_surface_create(VkInstance instance,
     return TRUE;
 }
 
-typedef DYNARRAY(const char *) extension_dynarray;
+typedef SMALL_DYNARRAY(const char *, 8) extension_dynarray;
 
 void wayland_vulkan_get_required_extensions(void *extensions_raw) {
     extension_dynarray *extensions = (extension_dynarray *)extensions_raw;
-    DYNARRAY_PUSH(*extensions, "VK_KHR_wayland_surface");
+    SMALL_DYNARRAY_PUSH(*extensions, "VK_KHR_wayland_surface");
 }
 
 b8 wayland_vulkan_queue_supports_presentation(VkPhysicalDevice device, u32 queue_family_index) {
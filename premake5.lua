@@ -41,10 +41,10 @@ project "Engine"
     defines { "EXPORT" }
 
     filter "system:windows"
-        links { "gdi32" }
+        links { "gdi32", "synchronization" }
 
     filter "system:linux"
-        links { "m" }
+        links { "m", "pthread" }
 
 project "WaylandAdapter"
     basedir "WaylandAdapter"
@@ -76,3 +76,17 @@ project "TestBed"
     includedirs { "TestBed/src", "Engine/src" }
     links { "Engine" }
     dependson { "VulkanRendererBackend" }
+
+    filter "system:linux"
+        -- Export the executable's symbols, so that the heap profiler can name its functions
+        linkoptions { "-rdynamic" }
+
+project "Benchmarks"
+    basedir "Benchmarks"
+    kind "ConsoleApp"
+    language "C"
+    cdialect "gnu17"
+    targetdir "bin/%{cfg.buildcfg}"
+    files { "Benchmarks/src/**.h", "Benchmarks/src/**.c" }
+    includedirs { "Benchmarks/src", "Engine/src" }
+    links { "Engine" }